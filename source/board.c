@@ -1,49 +1,165 @@
 #include "board.h"
+#include <math.h>
+#include <time.h>
+#include "core/gamelog.h"
+#include "engine/book.h"
+#include "engine/profiler.h"
+#include "engine/puzzledb.h"
+#include "engine/tablebase.h"
+#include "engine/worker.h"
 
-bool IsSquareUnderAttack(int row, int col, int byColor);
-int FindKing(int color);
-bool IsMoveLegal(int fromRow, int fromCol, int toRow, int toCol);
-bool HasLegalMoves(int color);
 void UpdateCheckStatus();
-void CheckAllowedMoves();
+static void CancelBot();
+static void StartHistory();
 
 static TILES chessboard [BOARD_SIZE][BOARD_SIZE];
-static PIECE pieces[32];
-static int pieceCount = 0;
 
-static PIECE* selectedPiece = NULL;
+/*
+    Everything on the board is cut from one texture: row 0 White's pieces and row 1 Black's
+    in PIECETYPE order, row 2 a plain tile tinted per square and the move markers
+*/
+#define ATLAS_MARKER_ROW 2
+enum { ATLAS_SOLID, ATLAS_DOT, ATLAS_RING };
+static ATLAS boardAtlas;
+static POSITION game;
+static UNDO history[MAX_GAME_PLY];
+static uint64_t historyKeys[MAX_GAME_PLY];
+static int historyCount = 0;
+static MOVELIST legalMoves;
+
+// Every move of the game as 16 bits, takes back leave the line in place to be redone
+static GAMELOG gameLog;
+
+// Replay shows an earlier ply of the game without touching it, replayPly is -1 when live
+static POSITION replay;
+static int replayPly = -1;
+
 static int selectedRow = -1;
 static int selectedColumn = -1;
 
-static int currentTurn = 0;
-
 static int lastMoveFromRow = -1;
 static int lastMoveFromColumn = -1;
 static int lastMoveToRow = -1;
 static int lastMoveToColumn = -1;
 
-static bool whiteKingInCheck = false;
-static bool blackKingInCheck = false;
+static bool kingInCheck = false;
 static bool isCheckmate = false;
 static int winner = -1;
+static bool endgameKnown = false;
+static TBRESULT endgame;
+
+// Side played by the engine, -1 when both sides are human
+static int botColor = -1;
+
+// Job the worker is searching for the engine's move, 0 when idle
+static uint32_t botJob = 0;
+
+static BOOK openingBook;
+static uint64_t bookRandom = 0;
+
+// Puzzle mode, puzzleStep is the next move of the solution to be played
+static PUZZLEDB puzzleDb;
+static const PUZZLE *puzzle = NULL;
+static bool puzzleMode = false;
+static int puzzleStep = 0;
+static bool puzzleFailed = false;
+static bool puzzleSolved = false;
+static int puzzleRating = PUZZLE_START_RATING;
+static uint64_t puzzleRandom = 0;
+
+// Row 0 is drawn at the top of the screen, which is Black's back rank
+static int TileSquare(int row, int column) {
+    return SQUARE(BOARD_SIZE - 1 - row, column);
+}
+
+static void SetLastMove(MOVE move) {
+    if (move == MOVE_NONE) {
+        lastMoveFromRow = -1;
+        lastMoveFromColumn = -1;
+        lastMoveToRow = -1;
+        lastMoveToColumn = -1;
+        return;
+    }
+    lastMoveFromRow = BOARD_SIZE - 1 - RANK_OF(MOVE_FROM(move));
+    lastMoveFromColumn = FILE_OF(MOVE_FROM(move));
+    lastMoveToRow = BOARD_SIZE - 1 - RANK_OF(MOVE_TO(move));
+    lastMoveToColumn = FILE_OF(MOVE_TO(move));
+}
 
 int GetCurrentTurn() {
-    return currentTurn;
+    return game.sideToMove;
+}
+
+bool IsPieceSelected() {
+    return selectedRow != -1;
 }
 
-PIECE* GetSelectedPiece() {
-    return selectedPiece;
+// Position the board shows, the replayed one while scrubbing through the game
+static const POSITION *ShownPosition() {
+    return replayPly >= 0 ? &replay : &game;
+}
+
+static void ClearSelection() {
+    for (int r = 0; r < BOARD_SIZE; r++) {
+        for (int c = 0; c < BOARD_SIZE; c++) {
+            chessboard[r][c].isPressed = false;
+            chessboard[r][c].isAllowed = false;
+        }
+    }
+    selectedRow = -1;
+    selectedColumn = -1;
+}
+
+// Anti-aliased white disc or ring in one atlas cell, inner radius 0 for a disc
+static void DrawAtlasDisc(Image *image, Rectangle cell, float inner, float outer) {
+    Color *pixels = image->data;
+    float centerX = cell.x + cell.width / 2.0f;
+    float centerY = cell.y + cell.height / 2.0f;
+
+    for (int y = (int)cell.y; y < (int)(cell.y + cell.height); y++) {
+        for (int x = (int)cell.x; x < (int)(cell.x + cell.width); x++) {
+            float distance = sqrtf((x + 0.5f - centerX) * (x + 0.5f - centerX) + (y + 0.5f - centerY) * (y + 0.5f - centerY));
+            float coverage = fminf(fmaxf(outer + 0.5f - distance, 0.0f), 1.0f);
+            if (inner > 0.0f) coverage *= fminf(fmaxf(distance - inner + 0.5f, 0.0f), 1.0f);
+            pixels[y * image->width + x] = (Color){ 255, 255, 255, (unsigned char)(255 * coverage) };
+        }
+    }
+}
+
+// The letters drawn at the same size and offset as the pieces always were
+static void BuildBoardAtlas() {
+    static const char *letters[6] = { "P", "R", "N", "B", "Q", "K" };
+    Image image = GenImageColor(6 * TILE_SIZE, 3 * TILE_SIZE, BLANK);
+
+    for (int color = COLOR_WHITE; color <= COLOR_BLACK; color++) {
+        for (int type = PAWN; type <= KING; type++) {
+            ImageDrawText(&image, letters[type], type * TILE_SIZE + TILE_SIZE / 2 - 12,
+                          color * TILE_SIZE + TILE_SIZE / 2 - 25, 50, color == COLOR_WHITE ? WHITE : BLACK);
+        }
+    }
+
+    Rectangle markers = { 0, ATLAS_MARKER_ROW * TILE_SIZE, TILE_SIZE, TILE_SIZE };
+    ImageDrawRectangle(&image, ATLAS_SOLID * TILE_SIZE, (int)markers.y, TILE_SIZE, TILE_SIZE, WHITE);
+    markers.x = ATLAS_DOT * TILE_SIZE;
+    DrawAtlasDisc(&image, markers, 0.0f, TILE_SIZE / 6.0f);
+    markers.x = ATLAS_RING * TILE_SIZE;
+    DrawAtlasDisc(&image, markers, TILE_SIZE / 2.5f - 5.0f, TILE_SIZE / 2.5f);
+
+    InitializeAtlas(&boardAtlas, image, TILE_SIZE);
+    UnloadImage(image);
 }
 
 void InitializeChessboard() {
 
+    if (!IsAtlasLoaded(&boardAtlas)) BuildBoardAtlas();
+
     int boardPixelSize = BOARD_SIZE * TILE_SIZE;
     int startX = (1920 - boardPixelSize) / 2;
     int startY = (1080 - boardPixelSize) / 2;
 
     for (int row = 0; row < BOARD_SIZE; row++) {
         for (int column = 0; column < BOARD_SIZE; column++) {
-            
+
             chessboard[row][column].position.x = startX + column * TILE_SIZE;
             chessboard[row][column].position.y = startY + row * TILE_SIZE;
 
@@ -52,15 +168,26 @@ void InitializeChessboard() {
             } else {
                 chessboard[row][column].color = 1;
             }
-            
-            chessboard[row][column].occupiedBy = -1;
+
             chessboard[row][column].isPressed = false;
-            chessboard[row][column].isAllowed = false; 
+            chessboard[row][column].isAllowed = false;
         }
     }
+
+    ClearPosition(&game);
+    StartHistory();
 }
 
 void RenderChessboard() {
+    PROFILE_SCOPE("RenderChessboard");
+
+    const POSITION *shown = ShownPosition();
+    bool check = replayPly >= 0 ? IsInCheck(shown, shown->sideToMove) : kingInCheck;
+    int checkedKingSquare = check ? FindKing(shown, shown->sideToMove) : NO_SQUARE;
+
+    // First thing drawn each frame, the counts cover the board and the pieces
+    ResetAtlasStats(&boardAtlas);
+    BeginAtlasBatch(&boardAtlas, 2 * BOARD_SIZE * BOARD_SIZE);
 
     for (int row = 0; row < BOARD_SIZE; row++) {
         for (int column = 0; column < BOARD_SIZE; column++) {
@@ -71,295 +198,324 @@ void RenderChessboard() {
                 tileColor = BLUE;
             } else if ((row == lastMoveFromRow && column == lastMoveFromColumn)) {
                 tileColor = (Color){244, 196, 48, 255};
- 
+
             } else if ((row == lastMoveToRow && column == lastMoveToColumn)) {
                 tileColor = (Color){255, 244, 79, 255};
-            } else if ((whiteKingInCheck || blackKingInCheck) && chessboard[row][column].occupiedBy == FindKing(currentTurn)) {
+            } else if (TileSquare(row, column) == checkedKingSquare) {
                 tileColor = RED;
             } else {
                 tileColor = (chessboard[row][column].color == 0) ? LIGHTGRAY : DARKGRAY;
             }
 
-            DrawRectangle(
-                chessboard[row][column].position.x,
-                chessboard[row][column].position.y,
-                TILE_SIZE,
-                TILE_SIZE,
-                tileColor
-            );
-            
-            // Check and render allowed moves
+            Rectangle tile = { chessboard[row][column].position.x, chessboard[row][column].position.y, TILE_SIZE, TILE_SIZE };
+            DrawAtlasSprite(&boardAtlas, AtlasCell(&boardAtlas, ATLAS_SOLID, ATLAS_MARKER_ROW), tile, tileColor);
+
+            // Allowed moves, a dot on an empty tile and a ring around a piece that can be taken
             if (chessboard[row][column].isAllowed) {
-                Vector2 center = {
-                    chessboard[row][column].position.x + TILE_SIZE / 2.0f,
-                    chessboard[row][column].position.y + TILE_SIZE / 2.0f
-                };
-                
-                // Case 1: Empty tile, draw a filled circle
-                if (chessboard[row][column].occupiedBy == -1) {
-                    float radius = TILE_SIZE / 6.0f;
-                    DrawCircleV(center, radius, Fade(WHITE, 0.7f));
-                }
-                
-                // Case 2: Occupied tile, draw a ring
-                else {
-                    float outerRadius = TILE_SIZE / 2.5f;
-                    float innerRadius = outerRadius - 5.0f;
-                    DrawRing(center, innerRadius, outerRadius, 0, 360, 36, Fade(WHITE, 0.7f));
-                }
+                bool empty = GetPieceAt(shown, TileSquare(row, column)) == NO_PIECE;
+                Rectangle marker = empty ? AtlasCell(&boardAtlas, ATLAS_DOT, ATLAS_MARKER_ROW) : AtlasCell(&boardAtlas, ATLAS_RING, ATLAS_MARKER_ROW);
+                DrawAtlasSprite(&boardAtlas, marker, tile, Fade(WHITE, 0.7f));
             }
         }
     }
+
+    EndAtlasBatch(&boardAtlas);
+}
+
+SPRITESTATS GetBoardRenderStats() {
+    return boardAtlas.stats;
 }
 
 void PlacePiece(int row, int column, int color, PIECETYPE type) {
-    pieces[pieceCount].position = chessboard[row][column].position;
-    pieces[pieceCount].color = color;
-    pieces[pieceCount].type = type;
-    pieces[pieceCount].hasMoved = false;
-    chessboard[row][column].occupiedBy = pieceCount;
-    pieceCount++;
+    PutPiece(&game, TileSquare(row, column), color, type);
 }
 
 void PlaceStartingPieces() {
-    PlacePiece(0, 0, 1, ROOK);
-    PlacePiece(0, 1, 1, KNIGHT);
-    PlacePiece(0, 2, 1, BISHOP);
-    PlacePiece(0, 3, 1, QUEEN);
-    PlacePiece(0, 4, 1, KING);
-    PlacePiece(0, 5, 1, BISHOP);
-    PlacePiece(0, 6, 1, KNIGHT);
-    PlacePiece(0, 7, 1, ROOK);
-    
-    for (int column = 0; column < BOARD_SIZE; column++) {
-        PlacePiece(1, column, 1, PAWN);
-    }
-    
-    for (int column = 0; column < BOARD_SIZE; column++) {
-        PlacePiece(6, column, 0, PAWN);
-    }
-    
-    PlacePiece(7, 0, 0, ROOK);
-    PlacePiece(7, 1, 0, KNIGHT);
-    PlacePiece(7, 2, 0, BISHOP);
-    PlacePiece(7, 3, 0, QUEEN);
-    PlacePiece(7, 4, 0, KING);
-    PlacePiece(7, 5, 0, BISHOP);
-    PlacePiece(7, 6, 0, KNIGHT);
-    PlacePiece(7, 7, 0, ROOK);
-}
-
-int FindKing(int color) {
-    for (int i = 0; i < pieceCount; i++) {
-        if (pieces[i].type == KING && 
-            pieces[i].color == color && 
-            pieces[i].position.x >= 0) {
-            return i;
-        }
+    SetStartingPosition(&game);
+    StartHistory();
+    UpdateCheckStatus();
+}
+
+bool LoadPositionFen(const char *fen) {
+    POSITION loaded;
+    if (fen == NULL || !ParseFen(&loaded, fen)) return false;
+
+    // A pasted position ends the puzzle, it is played out like any other game
+    CancelBot();
+    puzzleMode = false;
+    puzzle = NULL;
+    game = loaded;
+    StartHistory();
+    SetLastMove(MOVE_NONE);
+    ClearSelection();
+    UpdateCheckStatus();
+    return true;
+}
+
+void GetPositionFen(char *buffer, size_t size) {
+    WriteFen(&game, buffer, size);
+}
+
+// Threefold repetition, only positions since the last capture or pawn move can repeat
+static bool IsThreefoldRepetition() {
+    int repetitions = 0;
+    for (int ply = historyCount - 2; ply >= 0 && ply >= historyCount - game.halfmoveClock; ply -= 2) {
+        if (historyKeys[ply] == game.hash) repetitions++;
     }
-    return -1;
-}
-
-bool IsMoveLegal(int fromRow, int fromCol, int toRow, int toCol) {
-    // Simulate the move
-    int movingPieceIndex = chessboard[fromRow][fromCol].occupiedBy;
-    int capturedPieceIndex = chessboard[toRow][toCol].occupiedBy;
-    
-    PIECE *movingPiece = &pieces[movingPieceIndex];
-    Vector2 originalPos = movingPiece->position;
-    Vector2 capturedOriginalPos = {-1, -1};
-    
-    // Temporarily make the move
-    chessboard[fromRow][fromCol].occupiedBy = -1;
-    movingPiece->position = chessboard[toRow][toCol].position;
-    
-    if (capturedPieceIndex != -1) {
-        capturedOriginalPos = pieces[capturedPieceIndex].position;
-        pieces[capturedPieceIndex].position.x = -1000;
-        pieces[capturedPieceIndex].position.y = -1000;
+    return repetitions >= 2;
+}
+
+// King against king and at most one minor piece, no sequence of moves can mate
+static bool IsInsufficientMaterial() {
+    BITBOARD heavy = game.byType[PAWN] | game.byType[ROOK] | game.byType[QUEEN];
+    return heavy == 0 && PopCount(Occupied(&game)) <= 3;
+}
+
+void UpdateCheckStatus() {
+    PROFILE_SCOPE("UpdateCheckStatus");
+    kingInCheck = IsInCheck(&game, game.sideToMove);
+    endgameKnown = ProbeTablebase(&game, &endgame);
+
+    // Out of undo records, far past any practical game, call it a draw
+    if (historyCount == MAX_GAME_PLY) {
+        isCheckmate = true;
+        winner = -1;
+        return;
     }
-    
-    chessboard[toRow][toCol].occupiedBy = movingPieceIndex;
-    
-    // Find our king
-    int kingIndex = FindKing(movingPiece->color);
-    int kingRow = -1, kingCol = -1;
-    
-    // Find king's position on board
-    for (int r = 0; r < BOARD_SIZE; r++) {
-        for (int c = 0; c < BOARD_SIZE; c++) {
-            if (chessboard[r][c].occupiedBy == kingIndex) {
-                kingRow = r;
-                kingCol = c;
-                break;
-            }
-        }
-        if (kingRow != -1) break;
+
+    // One generator call per move, shared by the highlights and mate detection
+    {
+        PROFILE_SCOPE("GenerateLegalMoves");
+        GenerateLegalMoves(&game, &legalMoves);
     }
-    
-    // Check if king is under attack
-    int enemyColor = (movingPiece->color == 0) ? 1 : 0;
-    bool isLegal = !IsSquareUnderAttack(kingRow, kingCol, enemyColor);
-    
-    // Undo the move
-    chessboard[toRow][toCol].occupiedBy = capturedPieceIndex;
-    chessboard[fromRow][fromCol].occupiedBy = movingPieceIndex;
-    movingPiece->position = originalPos;
-    
-    if (capturedPieceIndex != -1) {
-        pieces[capturedPieceIndex].position = capturedOriginalPos;
+
+    if (legalMoves.count > 0) {
+        // A drawn tablebase position is called at once instead of after fifty more moves
+        isCheckmate = IsThreefoldRepetition() || IsInsufficientMaterial() || (endgameKnown && endgame.wdl == 0);
+        winner = -1;
+    } else if (kingInCheck) {
+        isCheckmate = true;
+        winner = !game.sideToMove;
+    } else {
+        isCheckmate = true;
+        winner = -1; // DRAW
     }
-    
-    return isLegal;
-}
-
-bool HasLegalMoves(int color) {
-    for (int fromRow = 0; fromRow < BOARD_SIZE; fromRow++) {
-        for (int fromCol = 0; fromCol < BOARD_SIZE; fromCol++) {
-            int pieceIndex = chessboard[fromRow][fromCol].occupiedBy;
-            if (pieceIndex == -1) continue;
-            if (pieces[pieceIndex].color != color) continue;
-            
-            // Check all possible destination squares
-            for (int toRow = 0; toRow < BOARD_SIZE; toRow++) {
-                for (int toCol = 0; toCol < BOARD_SIZE; toCol++) {
-                    // Temporarily set this piece as selected to check moves
-                    PIECE *tempPiece = selectedPiece;
-                    int tempRow = selectedRow;
-                    int tempCol = selectedColumn;
-                    
-                    selectedPiece = &pieces[pieceIndex];
-                    selectedRow = fromRow;
-                    selectedColumn = fromCol;
-                    
-                    // Clear and recalculate allowed moves
-                    for (int r = 0; r < BOARD_SIZE; r++)
-                        for (int c = 0; c < BOARD_SIZE; c++)
-                            chessboard[r][c].isAllowed = false;
-                    
-                    CheckAllowedMoves();
-                    
-                    // If this square is allowed and the move is legal
-                    if (chessboard[toRow][toCol].isAllowed && 
-                        IsMoveLegal(fromRow, fromCol, toRow, toCol)) {
-                        
-                        // Restore selection
-                        selectedPiece = tempPiece;
-                        selectedRow = tempRow;
-                        selectedColumn = tempCol;
-
-                        for (int r = 0; r < BOARD_SIZE; r++)
-                            for (int c = 0; c < BOARD_SIZE; c++)
-                                chessboard[r][c].isAllowed = false;
-
-                        return true;
-                    }
-                    
-                    // Restore selection
-                    selectedPiece = tempPiece;
-                    selectedRow = tempRow;
-                    selectedColumn = tempCol;
-                }
+}
+
+void RenderPieces(Vector2 mouseGamePos) {
+    PROFILE_SCOPE("RenderPieces");
+    BeginAtlasBatch(&boardAtlas, 32);
+    const POSITION *shown = ShownPosition();
+
+    // Only pieces on the board are in the lists, the dragged one is drawn last to stay on top
+    Rectangle dragged = { 0 }, draggedTile = { 0 };
+    bool dragging = false;
+    for (int piece = 0; piece < 12; piece++) {
+        for (int i = 0; i < shown->pieceCount[piece]; i++) {
+
+            int square = shown->pieceList[piece][i];
+            int row = BOARD_SIZE - 1 - RANK_OF(square);
+            int column = FILE_OF(square);
+
+            Rectangle sprite = AtlasCell(&boardAtlas, PIECE_TYPE(piece), PIECE_COLOR(piece));
+            Rectangle tile = { chessboard[row][column].position.x, chessboard[row][column].position.y, TILE_SIZE, TILE_SIZE };
+
+            if (row == selectedRow && column == selectedColumn) {
+                tile.x = mouseGamePos.x - TILE_SIZE / 2;
+                tile.y = mouseGamePos.y - TILE_SIZE / 2;
+                dragged = sprite;
+                draggedTile = tile;
+                dragging = true;
+                continue;
             }
+            DrawAtlasSprite(&boardAtlas, sprite, tile, WHITE);
         }
     }
+    if (dragging) DrawAtlasSprite(&boardAtlas, dragged, draggedTile, WHITE);
 
-    for (int r = 0; r < BOARD_SIZE; r++)
-        for (int c = 0; c < BOARD_SIZE; c++)
-            chessboard[r][c].isAllowed = false;
+    EndAtlasBatch(&boardAtlas);
+}
 
-    return false;
+// The game starts over from the current position, nothing to take back, redo or replay
+static void StartHistory() {
+    historyCount = 0;
+    InitGameLog(&gameLog, &game);
+    replayPly = -1;
 }
 
-void UpdateCheckStatus() {
-    // Check if white king is in check
-    int whiteKingIndex = FindKing(0);
-    if (whiteKingIndex != -1) {
-        int kingRow = -1, kingCol = -1;
-        for (int r = 0; r < BOARD_SIZE; r++) {
-            for (int c = 0; c < BOARD_SIZE; c++) {
-                if (chessboard[r][c].occupiedBy == whiteKingIndex) {
-                    kingRow = r;
-                    kingCol = c;
-                    break;
-                }
-            }
-            if (kingRow != -1) break;
-        }
-        whiteKingInCheck = IsSquareUnderAttack(kingRow, kingCol, 1);
+static void PlayMove(MOVE move) {
+    historyKeys[historyCount] = game.hash;
+    MakeMove(&game, move, &history[historyCount++]);
+    RecordLogMove(&gameLog, move, &game);
+
+    // A bot reply while replaying is highlighted once the replay ends
+    if (replayPly < 0) SetLastMove(move);
+
+    // Clear selection and allowed moves
+    ClearSelection();
+
+    UpdateCheckStatus();
+}
+
+void SetBotColor(int color) {
+    botColor = color;
+}
+
+bool LoadBotBook(const char *path) {
+    bookRandom = (uint64_t)time(NULL) * 0x9E3779B97F4A7C15ULL;
+    return OpenBook(&openingBook, path);
+}
+
+void UnloadBotBook() {
+    CloseBook(&openingBook);
+}
+
+bool IsBotThinking() {
+    return botJob != 0;
+}
+
+bool GetEndgameVerdict(char *buffer, size_t size) {
+    if (!endgameKnown || isCheckmate) return false;
+
+    const char *side = (game.sideToMove == COLOR_WHITE) ? "White" : "Black";
+    const char *other = (game.sideToMove == COLOR_WHITE) ? "Black" : "White";
+    if (endgame.wdl > 0) snprintf(buffer, size, "%s mates in %d", side, (endgame.dtm + 1) / 2);
+    else if (endgame.wdl < 0) snprintf(buffer, size, "%s mates in %d", other, endgame.dtm / 2);
+    else snprintf(buffer, size, "Draw");
+    return true;
+}
+
+static void CancelBot() {
+    if (botJob == 0) return;
+    CancelSearches();
+    botJob = 0;
+}
+
+// Polled once per frame, the search itself runs on the engine worker thread
+void UpdateBot() {
+    ENGINEREPLY reply;
+    while (PollEngineReply(&reply)) {
+        if (reply.id != botJob) continue;
+        botJob = 0;
+        if (reply.result.bestMove != MOVE_NONE) PlayMove(reply.result.bestMove);
     }
-    
-    // Check if black king is in check
-    int blackKingIndex = FindKing(1);
-    if (blackKingIndex != -1) {
-        int kingRow = -1, kingCol = -1;
-        for (int r = 0; r < BOARD_SIZE; r++) {
-            for (int c = 0; c < BOARD_SIZE; c++) {
-                if (chessboard[r][c].occupiedBy == blackKingIndex) {
-                    kingRow = r;
-                    kingCol = c;
-                    break;
-                }
-            }
-            if (kingRow != -1) break;
-        }
-        blackKingInCheck = IsSquareUnderAttack(kingRow, kingCol, 0);
+
+    if (botColor != game.sideToMove || isCheckmate || botJob != 0) return;
+
+    // Table and book moves are instant and go through the same path as a clicked move
+    TBRESULT result;
+    MOVE endgameMove = TablebaseBestMove(&game, &result);
+    if (endgameMove != MOVE_NONE) {
+        PlayMove(endgameMove);
+        return;
     }
-    
-    // Check for checkmate
-    if (whiteKingInCheck && !HasLegalMoves(0)) {
-        isCheckmate = true;
-        winner = 1; // Black wins
-    } else if (blackKingInCheck && !HasLegalMoves(1)) {
-        isCheckmate = true;
-        winner = 0; // White wins
-    } else if (!whiteKingInCheck && !HasLegalMoves(0)) {
-        isCheckmate = true;
-        winner = -1; // DRAW
-    } else if (!blackKingInCheck && !HasLegalMoves(1)) {
-        isCheckmate = true;
-        winner = -1; // DRAW
-    } else {
-        isCheckmate = false;
-        winner = -1;
+
+    MOVE bookMove = ProbeBook(&openingBook, &game, &bookRandom);
+    if (bookMove != MOVE_NONE) {
+        PlayMove(bookMove);
+        return;
     }
+
+    // One core stays with the render thread so frames keep coming while the bot thinks
+    int threads = AvailableCores() - 1;
+    SEARCHLIMITS limits = { .moveTimeMs = BOT_MOVE_TIME_MS, .threads = threads > 1 ? threads : 1 };
+    botJob = PostSearch(&game, historyKeys, historyCount, &limits);
 }
 
-void RenderPieces(Vector2 mouseGamePos) {
-    for (int i = 0; i < pieceCount; i++) {
+bool LoadPuzzles(const char *path) {
+    puzzleRandom = (uint64_t)time(NULL) * 0xD1B54A32D192ED03ULL | 1;
+    return OpenPuzzleDb(&puzzleDb, path);
+}
 
-        Color pieceColor = (pieces[i].color == 0) ? WHITE : BLACK;
+void UnloadPuzzles() {
+    ClosePuzzleDb(&puzzleDb);
+}
 
-        Vector2 drawPos = pieces[i].position;
+void StartPuzzleMode() {
+    puzzleMode = true;
+    botColor = -1;
+}
 
-        if (&pieces[i] == selectedPiece) {
-            drawPos.x = mouseGamePos.x - TILE_SIZE / 2;
-            drawPos.y = mouseGamePos.y - TILE_SIZE / 2;
-        }
+bool IsPuzzleMode() {
+    return puzzleMode;
+}
 
-        int x = drawPos.x + TILE_SIZE / 2 - 12;
-        int y = drawPos.y + TILE_SIZE / 2 - 25;
+bool NextPuzzle() {
+    if (!puzzleMode) return false;
 
-        switch (pieces[i].type) {
-            case PAWN:   DrawText("P", x, y, 50, pieceColor); break;
-            case ROOK:   DrawText("R", x, y, 50, pieceColor); break;
-            case KNIGHT: DrawText("N", x, y, 50, pieceColor); break;
-            case BISHOP: DrawText("B", x, y, 50, pieceColor); break;
-            case QUEEN:  DrawText("Q", x, y, 50, pieceColor); break;
-            case KING:   DrawText("K", x, y, 50, pieceColor); break;
-        }
-    }
+    puzzle = PickPuzzle(&puzzleDb, puzzleRating - PUZZLE_RATING_BAND, puzzleRating + PUZZLE_RATING_BAND, -1, &puzzleRandom);
+    if (puzzle == NULL) return false;
+
+    CancelBot();
+    UnpackPosition(&puzzle->position, &game);
+    StartHistory();
+    ClearSelection();
+    puzzleFailed = false;
+    puzzleSolved = false;
+
+    // The opponent's move that sets up the puzzle, highlighted like any last move
+    PlayMove(puzzle->moves[0]);
+    puzzleStep = 1;
+    return true;
+}
+
+bool GetPuzzleStatus(char *buffer, size_t size) {
+    if (!puzzleMode) return false;
+
+    if (puzzle == NULL) snprintf(buffer, size, "No puzzles, build %s with puzzledb", PUZZLE_DB_PATH);
+    else if (puzzleSolved) snprintf(buffer, size, "Solved! Rating %d, N for the next puzzle", puzzleRating);
+    else if (puzzleFailed) snprintf(buffer, size, "Wrong move, try again (rating %d)", puzzleRating);
+    else snprintf(buffer, size, "Puzzle %d: %s to play (rating %d)", puzzle->rating,
+                  game.sideToMove == COLOR_WHITE ? "White" : "Black", puzzleRating);
+    return true;
+}
+
+// Solving above your rating gains more than solving below it, and the reverse for misses
+static int PuzzleRatingChange(int gap) {
+    int change = 16 + gap / 25;
+    return change < 4 ? 4 : change > 32 ? 32 : change;
 }
 
-void PromotePawn(int pieceIndex) {
-    pieces[pieceIndex].type = QUEEN;
+// The last move goes back to the log's redo line, the highlight to the move before it
+static void UndoMove() {
+    UnmakeMove(&game, &history[--historyCount]);
+    StepBackLog(&gameLog);
+    SetLastMove(historyCount > 0 ? history[historyCount - 1].move : MOVE_NONE);
+}
+
+static void PlayPuzzleMove(MOVE move) {
+    MOVE expected = puzzle->moves[puzzleStep];
+    int solver = game.sideToMove;
+
+    // Clicks always promote to a queen, the solution decides the piece
+    if (MOVE_FROM(move) == MOVE_FROM(expected) && MOVE_TO(move) == MOVE_TO(expected)) move = expected;
+    PlayMove(move);
+
+    // Any mate solves the puzzle, not only the one in the solution
+    if (move != expected && !(isCheckmate && winner == solver)) {
+        if (!puzzleFailed) puzzleRating -= PuzzleRatingChange(puzzleRating - puzzle->rating);
+        puzzleFailed = true;
+
+        UndoMove();
+        ClearSelection();
+        UpdateCheckStatus();
+        return;
+    }
+
+    puzzleStep++;
+    if (puzzleStep < puzzle->moveCount && !isCheckmate) PlayMove(puzzle->moves[puzzleStep++]);
+    if (puzzleStep >= puzzle->moveCount || isCheckmate) {
+        if (!puzzleFailed) puzzleRating += PuzzleRatingChange(puzzle->rating - puzzleRating);
+        puzzleSolved = true;
+    }
 }
 
 void MovePiece(Vector2 mousePos) {
+    PROFILE_SCOPE("MovePiece");
     if (!IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) return;
 
-    if (isCheckmate) return;
-        
+    if (isCheckmate || game.sideToMove == botColor || replayPly >= 0) return;
+
     for (int row = 0; row < BOARD_SIZE; row++) {
         for (int column = 0; column < BOARD_SIZE; column++) {
             TILES *tile = &chessboard[row][column];
@@ -369,144 +525,40 @@ void MovePiece(Vector2 mousePos) {
                 TILE_SIZE,
                 TILE_SIZE
             };
-            
+
             if (!CheckCollisionPointRec(mousePos, tileRect))
                 continue;
-            
+
             // If a piece is selected and we click an allowed move, move the piece
-            if (selectedPiece != NULL && tile -> isAllowed) {
-
-                // If there's a piece on the target tile, capture it
-                if (tile -> occupiedBy != -1) {
-                    PIECE *capturedPiece = &pieces[tile -> occupiedBy];
-                    capturedPiece -> position.x = -1000;
-                    capturedPiece -> position.y = -1000;
-
-                }
-                
-                // Clear the old tile
-                chessboard[selectedRow][selectedColumn].occupiedBy = -1;
-                
-                // Move the piece to the new position
-                
-                // Check if this is a castling move
-                if (selectedPiece->type == KING && abs(column - selectedColumn) == 2) {
-                    
-                    // Determine if kingside or queenside
-                    if (column > selectedColumn) {
-                        // Kingside castling
-                        int rookIndex = chessboard[row][selectedColumn + 3].occupiedBy;
-                        PIECE *rook = &pieces[rookIndex];
-                        
-                        // Move rook
-                        chessboard[row][selectedColumn + 3].occupiedBy = -1;
-                        rook->position = chessboard[row][selectedColumn + 1].position;
-                        chessboard[row][selectedColumn + 1].occupiedBy = rookIndex;
-                        rook->hasMoved = true;
-                    } else {
-                        // Queenside castling
-                        int rookIndex = chessboard[row][selectedColumn - 4].occupiedBy;
-                        PIECE *rook = &pieces[rookIndex];
-                        
-                        // Move rook
-                        chessboard[row][selectedColumn - 4].occupiedBy = -1;
-                        rook->position = chessboard[row][selectedColumn - 1].position;
-                        chessboard[row][selectedColumn - 1].occupiedBy = rookIndex;
-                        rook->hasMoved = true;
-                    }
-                }
-
-                // Move the piece to the new position
-                selectedPiece->position = tile->position;
-                tile->occupiedBy = selectedPiece - pieces;
-                selectedPiece->hasMoved = true;  // Mark piece as moved
-
-                int movedRow = row;
-                int movedCol = column;
-                int movedIndex = tile->occupiedBy;
-
-                PIECE *movedPiece = &pieces[movedIndex];
-
-                if (movedPiece->type == PAWN) {
-                    if ((movedPiece->color == 0 && movedRow == 0) ||
-                        (movedPiece->color == 1 && movedRow == 7)) {
-                        PromotePawn(movedIndex);
-                    }
-                }
-                
-                lastMoveFromColumn = selectedColumn;
-                lastMoveFromRow = selectedRow;
-                lastMoveToColumn = column;
-                lastMoveToRow = row;
-
-                // Clear selection and allowed moves
-                for (int r = 0; r < BOARD_SIZE; r++) {
-                    for (int c = 0; c < BOARD_SIZE; c++) {
-                        chessboard[r][c].isPressed = false;
-                        chessboard[r][c].isAllowed = false;
-                    }
-                }
-                
-                selectedPiece = NULL;
-                selectedRow = -1;
-                selectedColumn = -1;
-
-                currentTurn = (currentTurn == 0) ? 1 : 0;
-
-                UpdateCheckStatus();
-
-                // Prevent further moves if checkmate
-                if (isCheckmate) {
-                    return;
-                }
+            if (IsPieceSelected() && tile -> isAllowed) {
 
+                // Captures, castling and promotion are handled by the rules library
+                MOVE move = FindLegalMove(&legalMoves, TileSquare(selectedRow, selectedColumn), TileSquare(row, column), QUEEN);
+                if (puzzle != NULL && !puzzleSolved) PlayPuzzleMove(move);
+                else PlayMove(move);
                 return;
             }
-            
+
+            int piece = GetPieceAt(&game, TileSquare(row, column));
+
             // Clicked on an empty tile - clear all selections
-            if (tile->occupiedBy == -1) {
-                for (int r = 0; r < BOARD_SIZE; r++)
-                    for (int c = 0; c < BOARD_SIZE; c++) {
-                        chessboard[r][c].isPressed = false;
-                        chessboard[r][c].isAllowed = false;
-                    }
-                selectedPiece = NULL;
-                selectedRow = -1;
-                selectedColumn = -1;
+            if (piece == NO_PIECE) {
+                ClearSelection();
                 return;
             }
-            
-            PIECE *piece = &pieces[tile->occupiedBy];
 
-            if (piece->color != currentTurn) {
+            if (PIECE_COLOR(piece) != game.sideToMove) {
                 return;
             }
-            
+
             // Clicking the same piece - deselect it
-            if (selectedPiece == piece) {
-                selectedPiece = NULL;
-                selectedRow = -1;
-                selectedColumn = -1;
-                tile->isPressed = false;
-                for (int r = 0; r < BOARD_SIZE; r++)
-                    for (int c = 0; c < BOARD_SIZE; c++)
-                        chessboard[r][c].isAllowed = false;
-            } 
             // Clicking a different piece while one is already selected - deselect only
-            else if (selectedPiece != NULL) {
-                for (int row = 0; row < BOARD_SIZE; row++)
-                    for (int column = 0; column < BOARD_SIZE; column++) {
-                        chessboard[row][column].isPressed = false;
-                        chessboard[row][column].isAllowed = false;
-                    }
-                selectedPiece = NULL;
-                selectedRow = -1;
-                selectedColumn = -1;
+            if (IsPieceSelected()) {
+                ClearSelection();
             }
             // No piece selected - select this one
             else {
                 tile->isPressed = true;
-                selectedPiece = piece;
                 selectedRow = row;
                 selectedColumn = column;
                 CheckAllowedMoves();
@@ -516,415 +568,109 @@ void MovePiece(Vector2 mousePos) {
     }
 }
 
-bool IsSquareUnderAttack(int row, int column, int byColor) {
-    // Check if square (row, column) is under attack by pieces of color 'byColor'
-
-    for (int i = 0; i < pieceCount; i++) {
-        if (pieces[i].color != byColor) continue;
-        if (pieces[i].position.x < 0) continue; // Skip captured pieces
-        
-        // Find the piece's position on the board
-        int pieceRow = -1, pieceCol = -1;
-        for (int r = 0; r < BOARD_SIZE; r++) {
-            for (int c = 0; c < BOARD_SIZE; c++) {
-                if (chessboard[r][c].occupiedBy == i) {
-                    pieceRow = r;
-                    pieceCol = c;
-                    break;
-                }
-            }
-            if (pieceRow != -1) break;
-        }
-        
-        if (pieceRow == -1) continue;
-        
-        // Check if this piece can attack the target square
-        switch (pieces[i].type) {
-            case PAWN: {
-                int direction = (pieces[i].color == 1) ? 1 : -1;
-                if (pieceRow + direction == row && 
-                    (pieceCol - 1 == column || pieceCol + 1 == column)) {
-                    return true;
-                }
-                break;
-            }
-            
-            case KNIGHT: {
-                int moves[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, 
-                                   {1, -2}, {1, 2}, {2, -1}, {2, 1}};
-                for (int m = 0; m < 8; m++) {
-                    if (pieceRow + moves[m][0] == row && pieceCol + moves[m][1] == column) {
-                        return true;
-                    }
-                }
-                break;
-            }
-            
-            case BISHOP: {
-                int directions[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
-                for (int d = 0; d < 4; d++) {
-                    for (int dist = 1; dist < BOARD_SIZE; dist++) {
-                        int newRow = pieceRow + directions[d][0] * dist;
-                        int newCol = pieceCol + directions[d][1] * dist;
-                        
-                        if (newRow < 0 || newRow >= BOARD_SIZE || 
-                            newCol < 0 || newCol >= BOARD_SIZE) break;
-                        
-                        if (newRow == row && newCol == column) return true;
-                        if (chessboard[newRow][newCol].occupiedBy != -1) break;
-                    }
-                }
-                break;
-            }
-            
-            case ROOK: {
-                int directions[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
-                for (int d = 0; d < 4; d++) {
-                    for (int dist = 1; dist < BOARD_SIZE; dist++) {
-                        int newRow = pieceRow + directions[d][0] * dist;
-                        int newCol = pieceCol + directions[d][1] * dist;
-                        
-                        if (newRow < 0 || newRow >= BOARD_SIZE || 
-                            newCol < 0 || newCol >= BOARD_SIZE) break;
-                        
-                        if (newRow == row && newCol == column) return true;
-                        if (chessboard[newRow][newCol].occupiedBy != -1) break;
-                    }
-                }
-                break;
-            }
-            
-            case QUEEN: {
-                int directions[8][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, 
-                                        {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
-                for (int d = 0; d < 8; d++) {
-                    for (int dist = 1; dist < BOARD_SIZE; dist++) {
-                        int newRow = pieceRow + directions[d][0] * dist;
-                        int newCol = pieceCol + directions[d][1] * dist;
-                        
-                        if (newRow < 0 || newRow >= BOARD_SIZE || 
-                            newCol < 0 || newCol >= BOARD_SIZE) break;
-                        
-                        if (newRow == row && newCol == column) return true;
-                        if (chessboard[newRow][newCol].occupiedBy != -1) break;
-                    }
-                }
-                break;
-            }
-            
-            case KING: {
-                int directions[8][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, 
-                                        {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
-                for (int d = 0; d < 8; d++) {
-                    if (pieceRow + directions[d][0] == row && 
-                        pieceCol + directions[d][1] == column) {
-                        return true;
-                    }
-                }
-                break;
-            }
-        }
+void TakeBackMove() {
+    // Puzzles take back wrong moves themselves, the solution must stay in step
+    if (historyCount == 0 || (puzzle != NULL && !puzzleSolved)) return;
+
+    StopReplay();
+    CancelBot();
+    UndoMove();
+
+    // Against the engine, take back its reply too so the human is to move again
+    if (game.sideToMove == botColor && historyCount > 0) UndoMove();
+
+    ClearSelection();
+    UpdateCheckStatus();
+}
+
+void RedoMove() {
+    if (NextLogMove(&gameLog) == MOVE_NONE || botJob != 0 || (puzzle != NULL && !puzzleSolved)) return;
+
+    StopReplay();
+    PlayMove(NextLogMove(&gameLog));
+
+    // Against the engine, its reply comes back with the move, or it thinks again if there was none
+    if (game.sideToMove == botColor && !isCheckmate && NextLogMove(&gameLog) != MOVE_NONE) {
+        PlayMove(NextLogMove(&gameLog));
     }
-    
-    return false;
+}
+
+bool IsReplaying() {
+    return replayPly >= 0;
+}
+
+void SeekReplay(int ply) {
+    // Reaching the live position is the same as leaving the replay
+    if (ply >= gameLog.ply) {
+        StopReplay();
+        return;
+    }
+    if (ply < 0) ply = 0;
+
+    replayPly = ply;
+    SetLastMove(SeekGameLog(&gameLog, ply, &replay));
+    ClearSelection();
+}
+
+void StepReplay(int plies) {
+    SeekReplay((replayPly >= 0 ? replayPly : gameLog.ply) + plies);
+}
+
+void StopReplay() {
+    if (replayPly < 0) return;
+    replayPly = -1;
+    SetLastMove(historyCount > 0 ? history[historyCount - 1].move : MOVE_NONE);
+}
+
+bool GetReplayStatus(char *buffer, size_t size) {
+    if (replayPly < 0) return false;
+    snprintf(buffer, size, "Replay: ply %d of %d, %s to play", replayPly, gameLog.ply,
+             replay.sideToMove == COLOR_WHITE ? "White" : "Black");
+    return true;
 }
 
 void CheckAllowedMoves() {
+    PROFILE_SCOPE("CheckAllowedMoves");
 
     // Clear all previous allowed moves
     for (int row = 0; row < BOARD_SIZE; row++)
         for (int column = 0; column < BOARD_SIZE; column++)
             chessboard[row][column].isAllowed = false;
-    
-    if (selectedPiece == NULL) return;
-    
-    int row = selectedRow;
-    int column = selectedColumn;
-    
-    switch (selectedPiece->type) {
-        case PAWN: {
-
-            int direction = (selectedPiece->color == 1) ? 1 : -1;
-            int startRow = (selectedPiece->color == 1) ? 1 : 6;
-            
-            // Move forward one square
-            if (row + direction >= 0 && row + direction < BOARD_SIZE) {
-                if (chessboard[row + direction][column].occupiedBy == -1) {
-                    chessboard[row + direction][column].isAllowed = true;
-                    
-                    // Check if in starting position to move two squares
-                    if (row == startRow && chessboard[row + 2 * direction][column].occupiedBy == -1) {
-                        chessboard[row + 2 * direction][column].isAllowed = true;
-                    }
-                }
-            }
-            
-            // Capture diagonally
-            for (int dc = -1; dc <= 1; dc += 2) {
-                int newRow = row + direction;
-                int newColumn = column + dc;
-                if (newRow >= 0 && newRow < BOARD_SIZE && newColumn >= 0 && newColumn < BOARD_SIZE) {
-                    int targetPiece = chessboard[newRow][newColumn].occupiedBy;
-                    if (targetPiece != -1 && pieces[targetPiece].color != selectedPiece->color) {
-                        chessboard[newRow][newColumn].isAllowed = true;
-                    }
-                }
-            }
-            break;
-        }
-        
-        case ROOK: {
-            // Horizontal and vertical directions
-            int directions[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
-            for (int d = 0; d < 4; d++) {
-                for (int i = 1; i < BOARD_SIZE; i++) {
-                    int newRow = row + directions[d][0] * i;
-                    int newCol = column + directions[d][1] * i;
-                    
-                    if (newRow < 0 || newRow >= BOARD_SIZE || newCol < 0 || newCol >= BOARD_SIZE)
-                        break;
-                    
-                    int targetPiece = chessboard[newRow][newCol].occupiedBy;
-                    if (targetPiece == -1) {
-                        chessboard[newRow][newCol].isAllowed = true;
-                    } else {
-                        if (pieces[targetPiece].color != selectedPiece->color)
-                            chessboard[newRow][newCol].isAllowed = true;
-                        break;
-                    }
-                }
-            }
-            break;
-        }
-        
-        case KNIGHT: {
-            int moves[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
-            for (int i = 0; i < 8; i++) {
-                int newRow = row + moves[i][0];
-                int newCol = column + moves[i][1];
-                
-                if (newRow >= 0 && newRow < BOARD_SIZE && newCol >= 0 && newCol < BOARD_SIZE) {
-                    int targetPiece = chessboard[newRow][newCol].occupiedBy;
-                    if (targetPiece == -1 || pieces[targetPiece].color != selectedPiece->color)
-                        chessboard[newRow][newCol].isAllowed = true;
-                }
-            }
-            break;
-        }
-        
-        case BISHOP: {
-            // Diagonal directions
-            int directions[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
-            for (int d = 0; d < 4; d++) {
-                for (int i = 1; i < BOARD_SIZE; i++) {
-                    int newRow = row + directions[d][0] * i;
-                    int newCol = column + directions[d][1] * i;
-                    
-                    if (newRow < 0 || newRow >= BOARD_SIZE || newCol < 0 || newCol >= BOARD_SIZE)
-                        break;
-                    
-                    int targetPiece = chessboard[newRow][newCol].occupiedBy;
-                    if (targetPiece == -1) {
-                        chessboard[newRow][newCol].isAllowed = true;
-                    } else {
-                        if (pieces[targetPiece].color != selectedPiece->color)
-                            chessboard[newRow][newCol].isAllowed = true;
-                        break;
-                    }
-                }
-            }
-            break;
-        }
-        
-        case QUEEN: {
-            // All 8 directions (rook + bishop)
-            int directions[8][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
-            for (int d = 0; d < 8; d++) {
-                for (int i = 1; i < BOARD_SIZE; i++) {
-                    int newRow = row + directions[d][0] * i;
-                    int newColumn = column + directions[d][1] * i;
-                    
-                    if (newRow < 0 || newRow >= BOARD_SIZE || newColumn < 0 || newColumn >= BOARD_SIZE)
-                        break;
-                    
-                    int targetPiece = chessboard[newRow][newColumn].occupiedBy;
-                    if (targetPiece == -1) {
-                        chessboard[newRow][newColumn].isAllowed = true;
-                    } else {
-                        if (pieces[targetPiece].color != selectedPiece->color)
-                            chessboard[newRow][newColumn].isAllowed = true;
-                        break;
-                    }
-                }
-            }
-            break;
-        }
-        
-        case KING: {
-            // Normal king moves (existing code)
-            int directions[8][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
-            for (int d = 0; d < 8; d++) {
-                int newRow = row + directions[d][0];
-                int newCol = column + directions[d][1];
-                
-                if (newRow >= 0 && newRow < BOARD_SIZE && newCol >= 0 && newCol < BOARD_SIZE) {
-                    int targetPiece = chessboard[newRow][newCol].occupiedBy;
-                    if (targetPiece == -1 || pieces[targetPiece].color != selectedPiece->color)
-                        chessboard[newRow][newCol].isAllowed = true;
-                }
-            }
-            
-            // CASTLING LOGIC - Add this section
-            if (!selectedPiece->hasMoved) {
-                int enemyColor = (selectedPiece->color == 0) ? 1 : 0;
-                
-                // Check if king is currently in check
-                if (!IsSquareUnderAttack(row, column, enemyColor)) {
-                    
-                    // Kingside castling (right)
-                    if (column + 3 < BOARD_SIZE) {
-                        int rookIndex = chessboard[row][column + 3].occupiedBy;
-                        if (rookIndex != -1 && 
-                            pieces[rookIndex].type == ROOK && 
-                            pieces[rookIndex].color == selectedPiece->color &&
-                            !pieces[rookIndex].hasMoved) {
-                            
-                            // Check if squares between are empty
-                            if (chessboard[row][column + 1].occupiedBy == -1 &&
-                                chessboard[row][column + 2].occupiedBy == -1) {
-                                
-                                // Check if king passes through or lands on attacked square
-                                if (!IsSquareUnderAttack(row, column + 1, enemyColor) &&
-                                    !IsSquareUnderAttack(row, column + 2, enemyColor)) {
-                                    chessboard[row][column + 2].isAllowed = true;
-                                }
-                            }
-                        }
-                    }
-                    
-                    // Queenside castling (left)
-                    if (column - 4 >= 0) {
-                        int rookIndex = chessboard[row][column - 4].occupiedBy;
-                        if (rookIndex != -1 && 
-                            pieces[rookIndex].type == ROOK && 
-                            pieces[rookIndex].color == selectedPiece->color &&
-                            !pieces[rookIndex].hasMoved) {
-                            
-                            // Check if squares between are empty
-                            if (chessboard[row][column - 1].occupiedBy == -1 &&
-                                chessboard[row][column - 2].occupiedBy == -1 &&
-                                chessboard[row][column - 3].occupiedBy == -1) {
-                                
-                                // Check if king passes through or lands on attacked square
-                                if (!IsSquareUnderAttack(row, column - 1, enemyColor) &&
-                                    !IsSquareUnderAttack(row, column - 2, enemyColor)) {
-                                    chessboard[row][column - 2].isAllowed = true;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-            break;
-        }
-    }
 
-    for (int r = 0; r < BOARD_SIZE; r++) {
-        for (int c = 0; c < BOARD_SIZE; c++) {
-            if (chessboard[r][c].isAllowed) {
-                if (!IsMoveLegal(selectedRow, selectedColumn, r, c)) {
-                    chessboard[r][c].isAllowed = false;
-                }
-            }
-        }
-    }
-}
+    if (!IsPieceSelected()) return;
 
-void UpdatePiecePosition(Vector2 mousePosition) {
-    if (!IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) return;
-    if (selectedPiece == NULL) return;
-    
-    for (int row = 0; row < BOARD_SIZE; row++) {
-        for (int col = 0; col < BOARD_SIZE; col++) {
-            TILES *tile = &chessboard[row][col];
-            
-            // Check if we clicked on this tile
-            Rectangle tileHitBox = {
-                tile->position.x,
-                tile->position.y,
-                TILE_SIZE,
-                TILE_SIZE
-            };
-            
-            if (!CheckCollisionPointRec(mousePosition, tileHitBox))
-                continue;
-            
-            // Check if this tile is an allowed move
-            if (!tile -> isAllowed)
-                return;
-            
-            // If there's a piece on the target tile, capture it
-            if (tile->occupiedBy != -1) {
-                PIECE *capturedPiece = &pieces[tile->occupiedBy];
-                capturedPiece->position.x = -1000; // Move off screen
-                capturedPiece->position.y = -1000;
-            }
-            
-            // Clear the old tile
-            chessboard[selectedRow][selectedColumn].occupiedBy = -1;
-            
-            // Move the piece to the new position
-            selectedPiece->position = tile->position;
-            tile->occupiedBy = selectedPiece - pieces; // Get the piece index
-            
-            // Clear selection and allowed moves
-            for (int r = 0; r < BOARD_SIZE; r++) {
-                for (int c = 0; c < BOARD_SIZE; c++) {
-                    chessboard[r][c].isPressed = false;
-                    chessboard[r][c].isAllowed = false;
-                }
-            }
-            
-            selectedPiece = NULL;
-            selectedRow = -1;
-            selectedColumn = -1;
-            
-            return;
-        }
+    int from = TileSquare(selectedRow, selectedColumn);
+
+    for (int i = 0; i < legalMoves.count; i++) {
+        if (MOVE_FROM(legalMoves.moves[i]) != from) continue;
+
+        int to = MOVE_TO(legalMoves.moves[i]);
+        chessboard[BOARD_SIZE - 1 - RANK_OF(to)][FILE_OF(to)].isAllowed = true;
     }
 }
 
 void UnloadChessboard() {
+    UnloadAtlas(&boardAtlas);
     for (int row = 0; row < BOARD_SIZE; row++) {
         for (int col = 0; col < BOARD_SIZE; col++) {
-            chessboard[row][col].occupiedBy = -1;
             chessboard[row][col].color = (row + col) % 2;
             chessboard[row][col].position.x = 0;
             chessboard[row][col].position.y = 0;
         }
     }
 
-    for (int i = 0; i < 32; i++) {
-        pieces[i].color = 0;
-        pieces[i].type = PAWN;
-        pieces[i].position.x = 0;
-        pieces[i].position.y = 0;
-        pieces[i].hasMoved = false;
-    }
-
-    pieceCount = 0;
-    currentTurn = 0; 
-    selectedPiece = NULL;
-    selectedRow = -1;
-    selectedColumn = -1;
+    CancelBot();
+    ClearPosition(&game);
+    ClearSelection();
+    StartHistory();
+    legalMoves.count = 0;
+    SetLastMove(MOVE_NONE);
 
-    lastMoveFromRow = -1;
-    lastMoveFromColumn = -1;
-    lastMoveToRow = -1;
-    lastMoveToColumn = -1;
-    
-    whiteKingInCheck = false;
-    blackKingInCheck = false;
+    kingInCheck = false;
     isCheckmate = false;
+    endgameKnown = false;
     winner = -1;
-}
\ No newline at end of file
+    botColor = -1;
+    puzzleMode = false;
+    puzzle = NULL;
+}
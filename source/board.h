@@ -4,35 +4,34 @@
 #include <stdio.h>
 #include <stdlib.h> 
 #include "raylib.h"
+#include "core/fen.h"
+#include "core/rules.h"
+#include "utilities/atlas.h"
 
 #define TILE_SIZE 100
 #define BOARD_SIZE 8
 
+// Thinking time the engine gets per move in Play Bots
+#define BOT_MOVE_TIME_MS 500
+
+// Polyglot opening book the bot plays from while it has moves for the position
+#define BOT_BOOK_PATH "assets/book.bin"
+
+// Endgame tables written by tbgen, played perfectly by the bot and used to call dead draws
+#define TABLEBASE_PATH "tablebases"
+
+// Puzzle collection packed by puzzledb, the solver's rating picks the next puzzle from it
+#define PUZZLE_DB_PATH "assets/puzzles.db"
+#define PUZZLE_START_RATING 1500
+#define PUZZLE_RATING_BAND 100
+
 typedef struct TileState {
     int color;
-    int occupiedBy;
     Vector2 position;
     bool isPressed;
     bool isAllowed;
 } TILES;
 
-typedef enum PieceType {
-    PAWN,
-    ROOK,
-    KNIGHT,
-    BISHOP,
-    QUEEN,
-    KING
-} PIECETYPE;
-
-typedef struct Piece {
-    Vector2 position;
-    Texture2D texture;
-    int color;
-    PIECETYPE type;
-    bool hasMoved;
-} PIECE;
-
 /* 
     Manage the chessboard state 
 */
@@ -46,18 +45,58 @@ void UnloadChessboard();
 void PlacePiece(int row, int column, int color, PIECETYPE type);
 void PlaceStartingPieces();
 
+// Any legal position in FEN, the game history starts over from it
+bool LoadPositionFen(const char *fen);
+void GetPositionFen(char *buffer, size_t size);
+
 /*
     Manage piece movements, game rules, interactions and rendering
 */
 
 void MovePiece(Vector2 mousePos);
+void TakeBackMove();
+
+// Plays the move last taken back again, and the engine's reply with it in Play Bots
+void RedoMove();
 void RenderPieces(Vector2 mouseGamePos);
+
+// Quads and texture batches the board and pieces took in the last frame
+SPRITESTATS GetBoardRenderStats();
 void CheckAllowedMoves();
-void UpdatePiecePosition(Vector2 mousePos);
 
-PIECE* GetSelectedPiece();
-int GetCurrentTurn();
+/*
+    Play against the engine, color -1 leaves both sides to humans
+*/
+void SetBotColor(int color);
+bool LoadBotBook(const char *path);
+void UnloadBotBook();
+void UpdateBot();
+bool IsBotThinking();
 
-bool IsSquareUnderAttack(int row, int column, int attackingColor);
+// "White mates in 12" style text while the position is in the endgame tables
+bool GetEndgameVerdict(char *buffer, size_t size);
+
+/*
+    Puzzle mode, the opponent's moves of the solution are played for the solver
+*/
+bool LoadPuzzles(const char *path);
+void UnloadPuzzles();
+void StartPuzzleMode();
+bool IsPuzzleMode();
+bool NextPuzzle();
+bool GetPuzzleStatus(char *buffer, size_t size);
+
+/*
+    Replay, the board shows any earlier ply of the game while the game itself stays put
+    Seeking to the current ply or past it goes back to the live board
+*/
+bool IsReplaying();
+void SeekReplay(int ply);
+void StepReplay(int plies);
+void StopReplay();
+bool GetReplayStatus(char *buffer, size_t size);
+
+bool IsPieceSelected();
+int GetCurrentTurn();
 
-#endif // BOARD_H
\ No newline at end of file
+#endif // BOARD_H
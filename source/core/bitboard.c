@@ -0,0 +1,157 @@
+#include "bitboard.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+BITBOARD knightAttacks[64];
+BITBOARD kingAttacks[64];
+BITBOARD pawnAttacks[2][64];
+BITBOARD betweenBB[64][64];
+BITBOARD lineBB[64][64];
+MAGIC rookMagics[64];
+MAGIC bishopMagics[64];
+
+static BITBOARD rookTable[102400];
+static BITBOARD bishopTable[5248];
+
+static const int knightSteps[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+static const int kingSteps[8][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+static const int pawnSteps[2][2][2] = {{{1, -1}, {1, 1}}, {{-1, -1}, {-1, 1}}};
+static const int rookDirections[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+static const int bishopDirections[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+
+static bool IsOnBoard(int rank, int file) {
+    return rank >= 0 && rank < 8 && file >= 0 && file < 8;
+}
+
+static BITBOARD StepAttacks(int square, const int steps[][2], int count) {
+    BITBOARD attacks = 0;
+    for (int i = 0; i < count; i++) {
+        int rank = (square >> 3) + steps[i][0];
+        int file = (square & 7) + steps[i][1];
+        if (IsOnBoard(rank, file)) attacks |= BIT(rank * 8 + file);
+    }
+    return attacks;
+}
+
+// Walk the rays one square at a time, only used to build the tables
+static BITBOARD SlowSlidingAttacks(int square, BITBOARD occupied, const int directions[4][2]) {
+    BITBOARD attacks = 0;
+    for (int d = 0; d < 4; d++) {
+        int rank = (square >> 3) + directions[d][0];
+        int file = (square & 7) + directions[d][1];
+        while (IsOnBoard(rank, file)) {
+            attacks |= BIT(rank * 8 + file);
+            if (occupied & BIT(rank * 8 + file)) break;
+            rank += directions[d][0];
+            file += directions[d][1];
+        }
+    }
+    return attacks;
+}
+
+// Relevant occupancy: the rays without the board edge they run into
+static BITBOARD RelevantMask(int square, const int directions[4][2]) {
+    BITBOARD mask = 0;
+    for (int d = 0; d < 4; d++) {
+        int rank = (square >> 3) + directions[d][0];
+        int file = (square & 7) + directions[d][1];
+        while (IsOnBoard(rank + directions[d][0], file + directions[d][1])) {
+            mask |= BIT(rank * 8 + file);
+            rank += directions[d][0];
+            file += directions[d][1];
+        }
+    }
+    return mask;
+}
+
+// Multipliers found offline with a random search over sparse 64-bit numbers
+static const BITBOARD rookMagicNumbers[64] = {
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL
+};
+
+static const BITBOARD bishopMagicNumbers[64] = {
+    0xA010041108003100ULL, 0x006082020A002900ULL, 0x6810010619200000ULL, 0x08281A0520000408ULL,
+    0x0001104001000400ULL, 0x0018901008048400ULL, 0x00040A0210245280ULL, 0x000200210808A402ULL,
+    0x9140048410821200ULL, 0x0800091010820041ULL, 0x20504804832202C0ULL, 0x0100091401081000ULL,
+    0x8021011140000012ULL, 0x0810020804450400ULL, 0x208B0542109008A2ULL, 0x0080084A08040204ULL,
+    0x0040E2A80811244CULL, 0x2505022008008108ULL, 0x0430220100420040ULL, 0x010A040420220040ULL,
+    0x1105000290400000ULL, 0x0093001200822120ULL, 0x4000A62048043004ULL, 0x280120048A015004ULL,
+    0x006090002A020814ULL, 0x44042000240800D0ULL, 0x01102800040A4400ULL, 0x1004080080220040ULL,
+    0x0001001011004024ULL, 0x0010044000805040ULL, 0x0914041200820100ULL, 0x0004821012821480ULL,
+    0x0024040500C05021ULL, 0x0088611002080200ULL, 0x0116080A00040020ULL, 0x4000020080080080ULL,
+    0x2450450140840040ULL, 0x0000880201484100ULL, 0x0222020404020092ULL, 0x8081110600002E00ULL,
+    0x2842101105000801ULL, 0x1100809008001025ULL, 0x00020202221C0400ULL, 0x0422014022009020ULL,
+    0x0210046102100C00ULL, 0xC004008082029102ULL, 0x00AA461801101200ULL, 0x0404080080201108ULL,
+    0x020542108C205002ULL, 0x0410544804100100ULL, 0x0040910841100000ULL, 0x0400200042021100ULL,
+    0x00004204850400C0ULL, 0x0200100410A42102ULL, 0x1040020801210102ULL, 0x0805040410420000ULL,
+    0x2884804130100200ULL, 0x800C262201242000ULL, 0x1058000194108800ULL, 0x0014221054420204ULL,
+    0x0104000012A02200ULL, 0x0200881003300100ULL, 0x0140400202840100ULL, 0x0402020801010201ULL
+};
+
+static void InitMagics(MAGIC magics[64], BITBOARD *table, const BITBOARD magicNumbers[64], const int directions[4][2]) {
+    for (int square = 0; square < 64; square++) {
+        MAGIC *m = &magics[square];
+        m->mask = RelevantMask(square, directions);
+        m->magic = magicNumbers[square];
+        m->shift = 64 - PopCount(m->mask);
+        m->attacks = table;
+
+        // Enumerate every subset of the mask (Carry-Rippler) and store its attacks
+        int size = 0;
+        BITBOARD subset = 0;
+        do {
+            table[MagicIndex(m, subset)] = SlowSlidingAttacks(square, subset, directions);
+            size++;
+            subset = (subset - m->mask) & m->mask;
+        } while (subset);
+
+        table += size;
+    }
+}
+
+static void BuildBitboards(void) {
+    for (int square = 0; square < 64; square++) {
+        knightAttacks[square] = StepAttacks(square, knightSteps, 8);
+        kingAttacks[square] = StepAttacks(square, kingSteps, 8);
+        pawnAttacks[0][square] = StepAttacks(square, pawnSteps[0], 2);
+        pawnAttacks[1][square] = StepAttacks(square, pawnSteps[1], 2);
+    }
+
+    InitMagics(rookMagics, rookTable, rookMagicNumbers, rookDirections);
+    InitMagics(bishopMagics, bishopTable, bishopMagicNumbers, bishopDirections);
+
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            const int (*directions)[2] = NULL;
+            if (RookAttacks(a, 0) & BIT(b)) directions = rookDirections;
+            else if (BishopAttacks(a, 0) & BIT(b)) directions = bishopDirections;
+            if (directions == NULL) continue;
+
+            // Rays from both ends, each stopped by the other square, overlap between them
+            betweenBB[a][b] = SlowSlidingAttacks(a, BIT(b), directions) & SlowSlidingAttacks(b, BIT(a), directions);
+            lineBB[a][b] = (SlowSlidingAttacks(a, 0, directions) & SlowSlidingAttacks(b, 0, directions)) | BIT(a) | BIT(b);
+        }
+    }
+}
+
+// Tools reach this from several threads on their first position, the tables are built exactly once
+void InitBitboards(void) {
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, BuildBitboards);
+}
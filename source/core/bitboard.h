@@ -0,0 +1,81 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+typedef uint64_t BITBOARD;
+
+#define BIT(square) (1ULL << (square))
+
+#define FILE_A_BB 0x0101010101010101ULL
+#define FILE_H_BB (FILE_A_BB << 7)
+#define RANK_1_BB 0xFFULL
+#define RANK_8_BB (RANK_1_BB << 56)
+
+typedef struct Magic {
+    BITBOARD mask;
+    BITBOARD magic;
+    BITBOARD *attacks;
+    int shift;
+} MAGIC;
+
+extern BITBOARD knightAttacks[64];
+extern BITBOARD kingAttacks[64];
+extern BITBOARD pawnAttacks[2][64];
+extern BITBOARD betweenBB[64][64];
+extern BITBOARD lineBB[64][64];
+extern MAGIC rookMagics[64];
+extern MAGIC bishopMagics[64];
+
+/*
+    betweenBB holds the squares strictly between two aligned squares, lineBB the whole line through them
+    Both are empty when the squares do not share a rank, file or diagonal
+
+    Fill the attack tables, safe to call more than once and from several threads at once
+*/
+void InitBitboards(void);
+
+static inline int PopCount(BITBOARD b) {
+    return __builtin_popcountll(b);
+}
+
+static inline int LsbIndex(BITBOARD b) {
+    return __builtin_ctzll(b);
+}
+
+static inline int PopLsb(BITBOARD *b) {
+    int square = __builtin_ctzll(*b);
+    *b &= *b - 1;
+    return square;
+}
+
+/*
+    Sliding attacks are one table lookup, indexed with PEXT when the CPU has BMI2
+*/
+static inline unsigned MagicIndex(const MAGIC *m, BITBOARD occupied) {
+#ifdef __BMI2__
+    return (unsigned)_pext_u64(occupied, m->mask);
+#else
+    return (unsigned)(((occupied & m->mask) * m->magic) >> m->shift);
+#endif
+}
+
+static inline BITBOARD RookAttacks(int square, BITBOARD occupied) {
+    const MAGIC *m = &rookMagics[square];
+    return m->attacks[MagicIndex(m, occupied)];
+}
+
+static inline BITBOARD BishopAttacks(int square, BITBOARD occupied) {
+    const MAGIC *m = &bishopMagics[square];
+    return m->attacks[MagicIndex(m, occupied)];
+}
+
+static inline BITBOARD QueenAttacks(int square, BITBOARD occupied) {
+    return RookAttacks(square, occupied) | BishopAttacks(square, occupied);
+}
+
+#endif // BITBOARD_H
@@ -0,0 +1,178 @@
+#include "fen.h"
+#include "rules.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char pieceLetters[] = "PRNBQK";
+
+static const char *SkipSpaces(const char *text) {
+    while (*text == ' ' || *text == '\t') text++;
+    return text;
+}
+
+static const char *ParsePlacement(POSITION *pos, const char *text) {
+    int rank = 7;
+    int file = 0;
+
+    for (; *text && *text != ' '; text++) {
+        char c = *text;
+
+        if (c == '/') {
+            if (file != 8 || rank == 0) return NULL;
+            rank--;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+            if (file > 8) return NULL;
+        } else {
+            const char *letter = strchr(pieceLetters, toupper((unsigned char)c));
+            if (letter == NULL || file > 7) return NULL;
+
+            // The piece lists have room for MAX_PIECES_PER_TYPE of each piece
+            int color = islower((unsigned char)c) ? COLOR_BLACK : COLOR_WHITE;
+            PIECETYPE type = (PIECETYPE)(letter - pieceLetters);
+            if (pos->pieceCount[PIECE_CODE(color, type)] == MAX_PIECES_PER_TYPE) return NULL;
+            PutPiece(pos, SQUARE(rank, file), color, type);
+            file++;
+        }
+    }
+
+    if (rank != 0 || file != 8) return NULL;
+    return text;
+}
+
+static const char *ParseCastling(POSITION *pos, const char *text) {
+    if (*text == '-') return text + 1;
+
+    for (; *text && *text != ' '; text++) {
+        switch (*text) {
+            case 'K': pos->castlingRights |= CASTLE_WHITE_KING; break;
+            case 'Q': pos->castlingRights |= CASTLE_WHITE_QUEEN; break;
+            case 'k': pos->castlingRights |= CASTLE_BLACK_KING; break;
+            case 'q': pos->castlingRights |= CASTLE_BLACK_QUEEN; break;
+            default: return NULL;
+        }
+    }
+    return text;
+}
+
+static bool HasPiece(const POSITION *pos, int square, int color, PIECETYPE type) {
+    return pos->board[square] == PIECE_CODE(color, type);
+}
+
+/*
+    Positions MakeMove and the generator can work on: one king each, the side not to move
+    out of check, no pawn on a back rank, castling rights only with the king and rook at
+    home, and an en passant square only behind a pawn that could have just made the double step
+*/
+static bool IsPlayablePosition(const POSITION *pos) {
+    if (pos->pieceCount[PIECE_CODE(COLOR_WHITE, KING)] != 1 || pos->pieceCount[PIECE_CODE(COLOR_BLACK, KING)] != 1) return false;
+    if (IsInCheck(pos, !pos->sideToMove)) return false;
+    if (pos->byType[PAWN] & (RANK_1_BB | RANK_8_BB)) return false;
+
+    if ((pos->castlingRights & (CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN)) && !HasPiece(pos, SQUARE(0, 4), COLOR_WHITE, KING)) return false;
+    if ((pos->castlingRights & (CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN)) && !HasPiece(pos, SQUARE(7, 4), COLOR_BLACK, KING)) return false;
+    if ((pos->castlingRights & CASTLE_WHITE_KING) && !HasPiece(pos, SQUARE(0, 7), COLOR_WHITE, ROOK)) return false;
+    if ((pos->castlingRights & CASTLE_WHITE_QUEEN) && !HasPiece(pos, SQUARE(0, 0), COLOR_WHITE, ROOK)) return false;
+    if ((pos->castlingRights & CASTLE_BLACK_KING) && !HasPiece(pos, SQUARE(7, 7), COLOR_BLACK, ROOK)) return false;
+    if ((pos->castlingRights & CASTLE_BLACK_QUEEN) && !HasPiece(pos, SQUARE(7, 0), COLOR_BLACK, ROOK)) return false;
+
+    if (pos->enPassantSquare != NO_SQUARE) {
+        int square = pos->enPassantSquare;
+        int mover = !pos->sideToMove;
+        int forward = mover == COLOR_WHITE ? 8 : -8;
+
+        // The square the pawn passed over, and the one it started from, are empty
+        if (RANK_OF(square) != (mover == COLOR_WHITE ? 2 : 5)) return false;
+        if (!HasPiece(pos, square + forward, mover, PAWN)) return false;
+        if (pos->board[square] != NO_PIECE || pos->board[square - forward] != NO_PIECE) return false;
+    }
+    return true;
+}
+
+bool ParseFen(POSITION *pos, const char *fen) {
+    ClearPosition(pos);
+
+    const char *text = ParsePlacement(pos, SkipSpaces(fen));
+    if (text == NULL) return false;
+
+    text = SkipSpaces(text);
+    if (*text == 'w') pos->sideToMove = COLOR_WHITE;
+    else if (*text == 'b') pos->sideToMove = COLOR_BLACK;
+    else return false;
+
+    text = ParseCastling(pos, SkipSpaces(text + 1));
+    if (text == NULL) return false;
+
+    text = SkipSpaces(text);
+    if (*text == '-') {
+        text++;
+    } else if (text[0] >= 'a' && text[0] <= 'h' && (text[1] == '3' || text[1] == '6')) {
+        pos->enPassantSquare = SQUARE(text[1] - '1', text[0] - 'a');
+        text += 2;
+    } else {
+        return false;
+    }
+
+    // Move counters are optional, EPD records leave them out
+    text = SkipSpaces(text);
+    if (isdigit((unsigned char)*text)) {
+        char *end;
+        pos->halfmoveClock = (uint8_t)strtol(text, &end, 10);
+        text = SkipSpaces(end);
+        if (isdigit((unsigned char)*text)) {
+            pos->fullmoveNumber = (uint16_t)strtol(text, &end, 10);
+        }
+    }
+
+    pos->hash = ComputeHash(pos);
+    return IsPlayablePosition(pos);
+}
+
+size_t WriteFen(const POSITION *pos, char *buffer, size_t size) {
+    char fen[FEN_BUFFER_SIZE];
+    int length = 0;
+
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            int piece = pos->board[SQUARE(rank, file)];
+            if (piece == NO_PIECE) {
+                empty++;
+                continue;
+            }
+            if (empty) fen[length++] = (char)('0' + empty);
+            empty = 0;
+            char letter = pieceLetters[PIECE_TYPE(piece)];
+            fen[length++] = (PIECE_COLOR(piece) == COLOR_BLACK) ? (char)tolower((unsigned char)letter) : letter;
+        }
+        if (empty) fen[length++] = (char)('0' + empty);
+        if (rank > 0) fen[length++] = '/';
+    }
+
+    fen[length++] = ' ';
+    fen[length++] = (pos->sideToMove == COLOR_WHITE) ? 'w' : 'b';
+    fen[length++] = ' ';
+
+    if (pos->castlingRights == 0) fen[length++] = '-';
+    if (pos->castlingRights & CASTLE_WHITE_KING) fen[length++] = 'K';
+    if (pos->castlingRights & CASTLE_WHITE_QUEEN) fen[length++] = 'Q';
+    if (pos->castlingRights & CASTLE_BLACK_KING) fen[length++] = 'k';
+    if (pos->castlingRights & CASTLE_BLACK_QUEEN) fen[length++] = 'q';
+
+    fen[length++] = ' ';
+    if (pos->enPassantSquare == NO_SQUARE) {
+        fen[length++] = '-';
+    } else {
+        fen[length++] = (char)('a' + FILE_OF(pos->enPassantSquare));
+        fen[length++] = (char)('1' + RANK_OF(pos->enPassantSquare));
+    }
+
+    length += snprintf(fen + length, sizeof(fen) - length, " %d %d", pos->halfmoveClock, pos->fullmoveNumber);
+    if ((size_t)length >= size) return 0;
+
+    memcpy(buffer, fen, length + 1);
+    return (size_t)length;
+}
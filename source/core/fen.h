@@ -0,0 +1,24 @@
+#ifndef FEN_H
+#define FEN_H
+
+#include "position.h"
+
+#include <stddef.h>
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+/*
+    Load a position from Forsyth-Edwards Notation, returns false if the string is malformed or
+    describes a position the rules cannot play from (see IsPlayablePosition in fen.c)
+*/
+bool ParseFen(POSITION *pos, const char *fen);
+
+// Longest FEN string including the terminator
+#define FEN_BUFFER_SIZE 96
+
+/*
+    Write the position as FEN, returns the length written or 0 if the buffer is too small
+*/
+size_t WriteFen(const POSITION *pos, char *buffer, size_t size);
+
+#endif // FEN_H
@@ -0,0 +1,42 @@
+#include "gamelog.h"
+
+void InitGameLog(GAMELOG *log, const POSITION *start) {
+    PackPosition(start, &log->snapshots[0]);
+    log->ply = 0;
+    log->length = 0;
+}
+
+void RecordLogMove(GAMELOG *log, MOVE move, const POSITION *after) {
+    if (log->ply == MAX_GAME_PLY) return;
+
+    if (log->ply == log->length || log->moves[log->ply] != move) {
+        log->moves[log->ply] = move;
+        log->length = log->ply + 1;
+    }
+    log->ply++;
+
+    // Redoing the same line passes snapshots that are already right, writing them again is harmless
+    if (log->ply % GAMELOG_SNAPSHOT_INTERVAL == 0) {
+        PackPosition(after, &log->snapshots[log->ply / GAMELOG_SNAPSHOT_INTERVAL]);
+    }
+}
+
+void StepBackLog(GAMELOG *log) {
+    if (log->ply > 0) log->ply--;
+}
+
+MOVE NextLogMove(const GAMELOG *log) {
+    return log->ply < log->length ? log->moves[log->ply] : MOVE_NONE;
+}
+
+MOVE SeekGameLog(const GAMELOG *log, int ply, POSITION *pos) {
+    if (ply < 0) ply = 0;
+    if (ply > log->length) ply = log->length;
+
+    int snapshot = ply / GAMELOG_SNAPSHOT_INTERVAL;
+    UnpackPosition(&log->snapshots[snapshot], pos);
+
+    UNDO undo;
+    for (int i = snapshot * GAMELOG_SNAPSHOT_INTERVAL; i < ply; i++) MakeMove(pos, log->moves[i], &undo);
+    return ply > 0 ? log->moves[ply - 1] : MOVE_NONE;
+}
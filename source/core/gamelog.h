@@ -0,0 +1,43 @@
+#ifndef GAMELOG_H
+#define GAMELOG_H
+
+#include "rules.h"
+
+// A snapshot every this many plies bounds any seek to that many MakeMove calls
+#define GAMELOG_SNAPSHOT_INTERVAL 16
+#define GAMELOG_SNAPSHOTS (MAX_GAME_PLY / GAMELOG_SNAPSHOT_INTERVAL + 1)
+
+/*
+    A game as its starting position and 16-bit moves, about 4.5 KB at the full MAX_GAME_PLY
+    snapshots[k] is the packed position after k * GAMELOG_SNAPSHOT_INTERVAL moves, [0] the start
+    ply is the current position, moves from ply to length were taken back and can be redone
+*/
+typedef struct GameLog {
+    MOVE moves[MAX_GAME_PLY];
+    PACKEDPOSITION snapshots[GAMELOG_SNAPSHOTS];
+    int ply;
+    int length;
+} GAMELOG;
+
+void InitGameLog(GAMELOG *log, const POSITION *start);
+
+/*
+    The move was just played, after is the position it led to
+    The same move as the next one to redo keeps the rest of the line, any other drops it
+*/
+void RecordLogMove(GAMELOG *log, MOVE move, const POSITION *after);
+
+// The last move was taken back, it stays in the log to be redone
+void StepBackLog(GAMELOG *log);
+
+// Next move to redo, MOVE_NONE at the end of the line
+MOVE NextLogMove(const GAMELOG *log);
+
+/*
+    Position after the first ply moves, from the nearest snapshot at or before it, so any
+    ply of a game costs at most GAMELOG_SNAPSHOT_INTERVAL - 1 moves to reach
+    Returns the move that led there (MOVE_NONE at ply 0), ply is clamped to [0, length]
+*/
+MOVE SeekGameLog(const GAMELOG *log, int ply, POSITION *pos);
+
+#endif // GAMELOG_H
@@ -0,0 +1,57 @@
+#ifndef MOVE_H
+#define MOVE_H
+
+#include <stdint.h>
+#include "position.h"
+
+/*
+    A move fits in 16 bits: from square (0-5), to square (6-11) and a 4-bit flag (12-15)
+*/
+typedef uint16_t MOVE;
+
+#define MOVE_NONE 0
+
+typedef enum MoveFlag {
+    MOVE_QUIET = 0,
+    MOVE_DOUBLE_PUSH = 1,
+    MOVE_CASTLE_KING = 2,
+    MOVE_CASTLE_QUEEN = 3,
+    MOVE_CAPTURE = 4,
+    MOVE_EN_PASSANT = 5,
+    MOVE_PROMOTE = 8,       // + 0..3 for knight, bishop, rook, queen, + MOVE_CAPTURE when capturing
+} MOVEFLAG;
+
+#define ENCODE_MOVE(from, to, flags) ((MOVE)((from) | ((to) << 6) | ((flags) << 12)))
+#define MOVE_FROM(move) ((move) & 63)
+#define MOVE_TO(move) (((move) >> 6) & 63)
+#define MOVE_FLAGS(move) ((move) >> 12)
+
+#define IS_CAPTURE(move) (MOVE_FLAGS(move) & MOVE_CAPTURE)
+#define IS_PROMOTION(move) (MOVE_FLAGS(move) & MOVE_PROMOTE)
+
+static inline PIECETYPE PromotionPiece(MOVE move) {
+    static const PIECETYPE pieces[4] = { KNIGHT, BISHOP, ROOK, QUEEN };
+    return pieces[MOVE_FLAGS(move) & 3];
+}
+
+static inline int PromotionFlag(PIECETYPE type) {
+    switch (type) {
+        case KNIGHT: return MOVE_PROMOTE | 0;
+        case BISHOP: return MOVE_PROMOTE | 1;
+        case ROOK:   return MOVE_PROMOTE | 2;
+        default:     return MOVE_PROMOTE | 3;
+    }
+}
+
+/*
+    Everything MakeMove overwrites, so UnmakeMove can restore the position without searching for it
+*/
+typedef struct UndoRecord {
+    MOVE move;
+    int8_t captured;
+    uint8_t castlingRights;
+    int8_t enPassantSquare;
+    uint8_t halfmoveClock;
+} UNDO;
+
+#endif // MOVE_H
@@ -0,0 +1,180 @@
+#include "notation.h"
+
+static const char pieceLetters[] = "PRNBQK";
+static const char promotionLetters[] = "nbrq";
+
+static int PieceFromLetter(char letter) {
+    for (int type = ROOK; type <= KING; type++) {
+        if (pieceLetters[type] == letter) return type;
+    }
+    return -1;
+}
+
+static int PromotionFromLetter(char letter) {
+    switch (letter) {
+        case 'N': case 'n': return KNIGHT;
+        case 'B': case 'b': return BISHOP;
+        case 'R': case 'r': return ROOK;
+        case 'Q': case 'q': return QUEEN;
+        default: return -1;
+    }
+}
+
+static char *WriteSquare(char *text, int square) {
+    *text++ = (char)('a' + FILE_OF(square));
+    *text++ = (char)('1' + RANK_OF(square));
+    return text;
+}
+
+void MoveToUci(MOVE move, char *text) {
+    text = WriteSquare(text, MOVE_FROM(move));
+    text = WriteSquare(text, MOVE_TO(move));
+    if (IS_PROMOTION(move)) *text++ = promotionLetters[MOVE_FLAGS(move) & 3];
+    *text = '\0';
+}
+
+void MoveToSan(POSITION *pos, MOVE move, char *text) {
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int type = PIECE_TYPE(pos->board[from]);
+    char *out = text;
+
+    MOVELIST list;
+    GenerateLegalMoves(pos, &list);
+
+    if (MOVE_FLAGS(move) == MOVE_CASTLE_KING || MOVE_FLAGS(move) == MOVE_CASTLE_QUEEN) {
+        const char *castle = (MOVE_FLAGS(move) == MOVE_CASTLE_KING) ? "O-O" : "O-O-O";
+        while (*castle) *out++ = *castle++;
+    } else if (type == PAWN) {
+        if (IS_CAPTURE(move)) {
+            *out++ = (char)('a' + FILE_OF(from));
+            *out++ = 'x';
+        }
+        out = WriteSquare(out, to);
+        if (IS_PROMOTION(move)) {
+            *out++ = '=';
+            *out++ = pieceLetters[PromotionPiece(move)];
+        }
+    } else {
+        *out++ = pieceLetters[type];
+
+        // Name the file if it tells the candidates apart, otherwise the rank, otherwise both
+        bool ambiguous = false, sameFile = false, sameRank = false;
+        for (int i = 0; i < list.count; i++) {
+            int other = MOVE_FROM(list.moves[i]);
+            if (other == from || MOVE_TO(list.moves[i]) != to || PIECE_TYPE(pos->board[other]) != type) continue;
+            ambiguous = true;
+            if (FILE_OF(other) == FILE_OF(from)) sameFile = true;
+            if (RANK_OF(other) == RANK_OF(from)) sameRank = true;
+        }
+        if (ambiguous && (!sameFile || sameRank)) *out++ = (char)('a' + FILE_OF(from));
+        if (ambiguous && sameFile) *out++ = (char)('1' + RANK_OF(from));
+
+        if (IS_CAPTURE(move)) *out++ = 'x';
+        out = WriteSquare(out, to);
+    }
+
+    UNDO undo;
+    MakeMove(pos, move, &undo);
+    if (IsInCheck(pos, pos->sideToMove)) {
+        *out++ = (GetGameStatus(pos) == GAME_CHECKMATE) ? '#' : '+';
+    }
+    UnmakeMove(pos, &undo);
+    *out = '\0';
+}
+
+static bool IsFileChar(char c) {
+    return c >= 'a' && c <= 'h';
+}
+
+static bool IsRankChar(char c) {
+    return c >= '1' && c <= '8';
+}
+
+static MOVE ParseUci(const MOVELIST *list, const char *text, size_t length) {
+    if (length < 4 || length > 5) return MOVE_NONE;
+    if (!IsFileChar(text[0]) || !IsRankChar(text[1]) || !IsFileChar(text[2]) || !IsRankChar(text[3])) return MOVE_NONE;
+
+    int promotion = QUEEN;
+    if (length == 5 && (promotion = PromotionFromLetter(text[4])) < 0) return MOVE_NONE;
+
+    int from = SQUARE(text[1] - '1', text[0] - 'a');
+    int to = SQUARE(text[3] - '1', text[2] - 'a');
+    MOVE move = FindLegalMove(list, from, to, (PIECETYPE)promotion);
+
+    // A promotion needs its piece spelled out
+    if (move != MOVE_NONE && IS_PROMOTION(move) && length != 5) return MOVE_NONE;
+    return move;
+}
+
+static MOVE ParseCastle(const MOVELIST *list, const char *text, size_t length) {
+    int flags;
+    if (length == 3) flags = MOVE_CASTLE_KING;
+    else if (length == 5 && (text[3] == '-') && (text[4] == text[0])) flags = MOVE_CASTLE_QUEEN;
+    else return MOVE_NONE;
+
+    for (int i = 0; i < list->count; i++) {
+        if (MOVE_FLAGS(list->moves[i]) == flags) return list->moves[i];
+    }
+    return MOVE_NONE;
+}
+
+MOVE ParseMove(POSITION *pos, const char *text, size_t length) {
+    MOVELIST list;
+    GenerateLegalMoves(pos, &list);
+
+    // Annotations and check marks carry no information for finding the move
+    while (length > 0 && (text[length - 1] == '+' || text[length - 1] == '#' ||
+                          text[length - 1] == '!' || text[length - 1] == '?')) {
+        length--;
+    }
+    if (length < 2) return MOVE_NONE;
+
+    MOVE uci = ParseUci(&list, text, length);
+    if (uci != MOVE_NONE) return uci;
+
+    if ((text[0] == 'O' || text[0] == '0') && length >= 3 && text[1] == '-') {
+        return ParseCastle(&list, text, length);
+    }
+
+    int type = PAWN;
+    size_t start = 0;
+    if (text[0] >= 'A' && text[0] <= 'Z') {
+        if ((type = PieceFromLetter(text[0])) < 0) return MOVE_NONE;
+        start = 1;
+    }
+
+    // Promotion suffix, with or without the '='
+    int promotion = -1;
+    if (type == PAWN && length >= 3 && PromotionFromLetter(text[length - 1]) >= 0 && !IsRankChar(text[length - 1])) {
+        promotion = PromotionFromLetter(text[length - 1]);
+        length--;
+        if (text[length - 1] == '=') length--;
+    }
+
+    if (length < start + 2 || !IsFileChar(text[length - 2]) || !IsRankChar(text[length - 1])) return MOVE_NONE;
+    int to = SQUARE(text[length - 1] - '1', text[length - 2] - 'a');
+
+    // Whatever sits between the piece and the target square: disambiguation and 'x'
+    int fromFile = -1, fromRank = -1;
+    for (size_t i = start; i < length - 2; i++) {
+        if (IsFileChar(text[i])) fromFile = text[i] - 'a';
+        else if (IsRankChar(text[i])) fromRank = text[i] - '1';
+        else if (text[i] != 'x' && text[i] != ':' && text[i] != '-') return MOVE_NONE;
+    }
+
+    MOVE found = MOVE_NONE;
+    for (int i = 0; i < list.count; i++) {
+        MOVE move = list.moves[i];
+        int from = MOVE_FROM(move);
+        if (MOVE_TO(move) != to || PIECE_TYPE(pos->board[from]) != type) continue;
+        if (fromFile >= 0 && FILE_OF(from) != fromFile) continue;
+        if (fromRank >= 0 && RANK_OF(from) != fromRank) continue;
+        if ((IS_PROMOTION(move) != 0) != (promotion >= 0)) continue;
+        if (promotion >= 0 && PromotionPiece(move) != promotion) continue;
+
+        if (found != MOVE_NONE) return MOVE_NONE;
+        found = move;
+    }
+    return found;
+}
@@ -0,0 +1,27 @@
+#ifndef NOTATION_H
+#define NOTATION_H
+
+#include <stddef.h>
+#include "rules.h"
+
+// Longest move text including the terminator, "Qa1xh8+" style SAN or "e7e8q" style UCI
+#define MOVE_TEXT_SIZE 8
+
+/*
+    Coordinate notation as used by UCI, castling is written as the king's two-square move
+*/
+void MoveToUci(MOVE move, char *text);
+
+/*
+    Standard Algebraic Notation, the position is the one before the move
+    It is only played and taken back to find the check suffix
+*/
+void MoveToSan(POSITION *pos, MOVE move, char *text);
+
+/*
+    Resolve a move written in SAN or UCI against the legal moves of the position
+    The text does not need to be terminated, returns MOVE_NONE if nothing or more than one move matches
+*/
+MOVE ParseMove(POSITION *pos, const char *text, size_t length);
+
+#endif // NOTATION_H
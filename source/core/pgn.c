@@ -0,0 +1,214 @@
+#include "pgn.h"
+#include <string.h>
+#include "fen.h"
+#include "notation.h"
+
+void InitPgnLexer(PGNLEXER *lexer, const char *text, size_t length) {
+    lexer->cursor = text;
+    lexer->end = text + length;
+}
+
+static bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Symbols end at whitespace or at the characters that start another token
+static const char *SymbolEnd(const char *cursor, const char *end) {
+    while (cursor < end && !IsSpace(*cursor) && !strchr("{}()[];$", *cursor)) cursor++;
+    return cursor;
+}
+
+static const char *SkipLine(const char *cursor, const char *end) {
+    const char *newline = memchr(cursor, '\n', end - cursor);
+    return newline ? newline + 1 : end;
+}
+
+static bool IsResult(const char *text, size_t length) {
+    return (length == 1 && text[0] == '*') ||
+           (length == 3 && (memcmp(text, "1-0", 3) == 0 || memcmp(text, "0-1", 3) == 0)) ||
+           (length == 7 && memcmp(text, "1/2-1/2", 7) == 0);
+}
+
+static bool ReadTag(PGNLEXER *lexer, PGNTOKEN *token) {
+    const char *cursor = lexer->cursor + 1;
+    const char *end = lexer->end;
+
+    while (cursor < end && IsSpace(*cursor)) cursor++;
+    token->text = cursor;
+    while (cursor < end && !IsSpace(*cursor) && *cursor != '"' && *cursor != ']') cursor++;
+    token->length = cursor - token->text;
+
+    while (cursor < end && *cursor != '"' && *cursor != ']') cursor++;
+    token->value = cursor;
+    token->valueLength = 0;
+    if (cursor < end && *cursor == '"') {
+        token->value = ++cursor;
+        while (cursor < end && *cursor != '"') cursor += (*cursor == '\\' && cursor + 1 < end) ? 2 : 1;
+        token->valueLength = cursor - token->value;
+    }
+
+    const char *close = memchr(cursor, ']', end - cursor);
+    lexer->cursor = close ? close + 1 : end;
+    token->type = PGN_TOKEN_TAG;
+    return true;
+}
+
+bool NextPgnToken(PGNLEXER *lexer, PGNTOKEN *token) {
+    const char *end = lexer->end;
+
+    while (lexer->cursor < end) {
+        const char *cursor = lexer->cursor;
+        char c = *cursor;
+
+        if (IsSpace(c)) {
+            lexer->cursor++;
+        } else if (c == '{') {
+            const char *close = memchr(cursor, '}', end - cursor);
+            lexer->cursor = close ? close + 1 : end;
+        } else if (c == ';' || c == '%') {
+            lexer->cursor = SkipLine(cursor, end);
+        } else if (c == '(') {
+            // Variations nest and may hold comments with parentheses in them
+            int depth = 0;
+            for (; cursor < end; cursor++) {
+                if (*cursor == '{') {
+                    const char *close = memchr(cursor, '}', end - cursor);
+                    cursor = close ? close : end - 1;
+                } else if (*cursor == '(') {
+                    depth++;
+                } else if (*cursor == ')' && --depth == 0) {
+                    break;
+                }
+            }
+            lexer->cursor = (cursor < end) ? cursor + 1 : end;
+        } else if (c == '[') {
+            return ReadTag(lexer, token);
+        } else if (c == '$' || c == ')' || c == '}') {
+            lexer->cursor = SymbolEnd(cursor + 1, end);
+        } else {
+            const char *symbolEnd = SymbolEnd(cursor, end);
+            lexer->cursor = symbolEnd;
+            if (symbolEnd == cursor) {
+                lexer->cursor++;
+                continue;
+            }
+
+            token->text = cursor;
+            token->length = symbolEnd - cursor;
+            if (IsResult(token->text, token->length)) {
+                token->type = PGN_TOKEN_RESULT;
+                return true;
+            }
+
+            // Move numbers, "12." or "12...", possibly glued to the move as in "12.e4"
+            const char *digits = token->text;
+            while (digits < symbolEnd && IsDigit(*digits)) digits++;
+            if (digits > token->text && digits < symbolEnd && *digits == '.') {
+                while (digits < symbolEnd && *digits == '.') digits++;
+                token->length -= digits - token->text;
+                token->text = digits;
+            }
+            // Move numbers standing apart, "12" before a spaced out "..."
+            if (token->length == 0 || *token->text == '.' || digits == symbolEnd) continue;
+
+            token->type = PGN_TOKEN_MOVE;
+            return true;
+        }
+    }
+
+    token->type = PGN_TOKEN_END;
+    return false;
+}
+
+/*
+    Byte scan with comment tracking: a '[' at the start of a line opens a new game once
+    movetext has been seen, unless it sits inside a multi-line comment
+*/
+bool SplitPgnGame(const char **cursor, const char *end, const char **game, size_t *length) {
+    const char *text = *cursor;
+    while (text < end && IsSpace(*text)) text++;
+    if (text >= end) {
+        *cursor = end;
+        return false;
+    }
+
+    *game = text;
+    bool seenMoves = false;
+    bool inComment = false;
+    bool lineStart = true;
+
+    for (; text < end; text++) {
+        char c = *text;
+        if (inComment) {
+            if (c == '}') inComment = false;
+        } else if (c == '{') {
+            inComment = true;
+        } else if (lineStart && c == '[') {
+            if (seenMoves) break;
+            text = SkipLine(text, end) - 1;
+            continue;
+        } else if (!IsSpace(c)) {
+            seenMoves = true;
+        }
+        lineStart = (c == '\n');
+    }
+
+    *length = text - *game;
+    *cursor = text;
+    return true;
+}
+
+static bool TagIs(const PGNTOKEN *token, const char *name) {
+    size_t length = strlen(name);
+    return token->length == length && memcmp(token->text, name, length) == 0;
+}
+
+PGNSTATUS ReplayPgnGame(const char *text, size_t length, PGNREPLAY *replay) {
+    PGNLEXER lexer;
+    PGNTOKEN token;
+    InitPgnLexer(&lexer, text, length);
+
+    replay->plies = 0;
+    replay->errorText = NULL;
+    replay->errorLength = 0;
+    SetStartingPosition(&replay->final);
+    POSITION *pos = &replay->final;
+
+    while (NextPgnToken(&lexer, &token)) {
+        if (token.type == PGN_TOKEN_TAG) {
+            if (!TagIs(&token, "FEN")) continue;
+
+            // The only copy made, ParseFen needs a terminated string
+            char fen[FEN_BUFFER_SIZE];
+            if (token.valueLength >= sizeof(fen)) return replay->status = PGN_BAD_FEN;
+            memcpy(fen, token.value, token.valueLength);
+            fen[token.valueLength] = '\0';
+            if (!ParseFen(pos, fen)) return replay->status = PGN_BAD_FEN;
+        } else if (token.type == PGN_TOKEN_MOVE) {
+            MOVE move = ParseMove(pos, token.text, token.length);
+            if (move == MOVE_NONE) {
+                replay->errorText = token.text;
+                replay->errorLength = token.length;
+                return replay->status = PGN_ILLEGAL_MOVE;
+            }
+            UNDO undo;
+            MakeMove(pos, move, &undo);
+            replay->plies++;
+        } else if (token.type == PGN_TOKEN_RESULT) {
+            // "*" leaves the result open, anything else has to agree with a mate on the board
+            if (token.length == 1 || GetGameStatus(pos) != GAME_CHECKMATE) continue;
+
+            const char *expected = (pos->sideToMove == COLOR_WHITE) ? "0-1" : "1-0";
+            if (token.length != 3 || memcmp(token.text, expected, 3) != 0) {
+                replay->errorText = token.text;
+                replay->errorLength = token.length;
+                return replay->status = PGN_WRONG_RESULT;
+            }
+        }
+    }
+    return replay->status = PGN_OK;
+}
@@ -0,0 +1,68 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include <stddef.h>
+#include "rules.h"
+
+/*
+    Zero-copy Portable Game Notation reader: tokens point into the caller's buffer,
+    which does not need to be terminated, so a memory-mapped file can be read in place
+*/
+typedef enum PgnTokenType {
+    PGN_TOKEN_END,
+    PGN_TOKEN_TAG,
+    PGN_TOKEN_MOVE,
+    PGN_TOKEN_RESULT,
+} PGNTOKENTYPE;
+
+typedef struct PgnToken {
+    PGNTOKENTYPE type;
+    const char *text;
+    size_t length;
+
+    // Tags only, still escaped as in the file
+    const char *value;
+    size_t valueLength;
+} PGNTOKEN;
+
+typedef struct PgnLexer {
+    const char *cursor;
+    const char *end;
+} PGNLEXER;
+
+void InitPgnLexer(PGNLEXER *lexer, const char *text, size_t length);
+
+// Comments, variations, annotation glyphs and move numbers are skipped, false at the end
+bool NextPgnToken(PGNLEXER *lexer, PGNTOKEN *token);
+
+/*
+    Find the next game from *cursor, a game ends where the tag section of the next one starts
+    Returns false when only whitespace is left
+*/
+bool SplitPgnGame(const char **cursor, const char *end, const char **game, size_t *length);
+
+typedef enum PgnStatus {
+    PGN_OK,
+    PGN_BAD_FEN,
+    PGN_ILLEGAL_MOVE,
+    PGN_WRONG_RESULT,
+} PGNSTATUS;
+
+typedef struct PgnReplay {
+    PGNSTATUS status;
+    int plies;
+
+    // The offending move for PGN_ILLEGAL_MOVE
+    const char *errorText;
+    size_t errorLength;
+
+    POSITION final;
+} PGNREPLAY;
+
+/*
+    Play a game's moves through the rules from the start or its FEN tag, a checkmate
+    on the board must agree with the recorded result
+*/
+PGNSTATUS ReplayPgnGame(const char *text, size_t length, PGNREPLAY *replay);
+
+#endif // PGN_H
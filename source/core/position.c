@@ -0,0 +1,136 @@
+#include "position.h"
+
+static const PIECETYPE backRank[8] = { ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK };
+
+void ClearPosition(POSITION *pos) {
+    InitBitboards();
+    InitZobrist();
+
+    for (int piece = 0; piece < 12; piece++) {
+        pos->pieceCount[piece] = 0;
+    }
+    pos->kingSquare[COLOR_WHITE] = NO_SQUARE;
+    pos->kingSquare[COLOR_BLACK] = NO_SQUARE;
+
+    for (int type = PAWN; type <= KING; type++) {
+        pos->byType[type] = 0;
+    }
+    pos->byColor[COLOR_WHITE] = 0;
+    pos->byColor[COLOR_BLACK] = 0;
+
+    for (int square = 0; square < BOARD_SQUARES; square++) {
+        pos->board[square] = NO_PIECE;
+    }
+
+    pos->sideToMove = COLOR_WHITE;
+    pos->castlingRights = 0;
+    pos->enPassantSquare = NO_SQUARE;
+    pos->halfmoveClock = 0;
+    pos->fullmoveNumber = 1;
+    pos->hash = 0;
+}
+
+void SetStartingPosition(POSITION *pos) {
+    ClearPosition(pos);
+
+    for (int file = 0; file < 8; file++) {
+        PutPiece(pos, SQUARE(0, file), COLOR_WHITE, backRank[file]);
+        PutPiece(pos, SQUARE(1, file), COLOR_WHITE, PAWN);
+        PutPiece(pos, SQUARE(6, file), COLOR_BLACK, PAWN);
+        PutPiece(pos, SQUARE(7, file), COLOR_BLACK, backRank[file]);
+    }
+
+    pos->castlingRights = CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN | CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN;
+    pos->hash = ComputeHash(pos);
+}
+
+void PutPiece(POSITION *pos, int square, int color, PIECETYPE type) {
+    if (pos->board[square] != NO_PIECE) {
+        RemovePiece(pos, square);
+    }
+    int piece = PIECE_CODE(color, type);
+    pos->board[square] = piece;
+    pos->byType[type] |= BIT(square);
+    pos->byColor[color] |= BIT(square);
+    pos->hash ^= pieceKeys[piece][square];
+
+    pos->listIndex[square] = pos->pieceCount[piece];
+    pos->pieceList[piece][pos->pieceCount[piece]++] = square;
+    if (type == KING) pos->kingSquare[color] = square;
+}
+
+void RemovePiece(POSITION *pos, int square) {
+    int piece = pos->board[square];
+    pos->byType[PIECE_TYPE(piece)] &= ~BIT(square);
+    pos->byColor[PIECE_COLOR(piece)] &= ~BIT(square);
+    pos->board[square] = NO_PIECE;
+    pos->hash ^= pieceKeys[piece][square];
+
+    // Fill the hole in the list with its last entry
+    int last = pos->pieceList[piece][--pos->pieceCount[piece]];
+    pos->pieceList[piece][pos->listIndex[square]] = last;
+    pos->listIndex[last] = pos->listIndex[square];
+    if (PIECE_TYPE(piece) == KING) pos->kingSquare[PIECE_COLOR(piece)] = NO_SQUARE;
+}
+
+void RelocatePiece(POSITION *pos, int from, int to) {
+    int piece = pos->board[from];
+    BITBOARD fromTo = BIT(from) | BIT(to);
+    pos->byType[PIECE_TYPE(piece)] ^= fromTo;
+    pos->byColor[PIECE_COLOR(piece)] ^= fromTo;
+    pos->board[from] = NO_PIECE;
+    pos->board[to] = piece;
+    pos->hash ^= pieceKeys[piece][from] ^ pieceKeys[piece][to];
+
+    pos->listIndex[to] = pos->listIndex[from];
+    pos->pieceList[piece][pos->listIndex[to]] = to;
+    if (PIECE_TYPE(piece) == KING) pos->kingSquare[PIECE_COLOR(piece)] = to;
+}
+
+int GetPieceAt(const POSITION *pos, int square) {
+    return pos->board[square];
+}
+
+uint64_t ComputeHash(const POSITION *pos) {
+    uint64_t hash = castlingKeys[pos->castlingRights];
+
+    for (int square = 0; square < BOARD_SQUARES; square++) {
+        if (pos->board[square] != NO_PIECE) {
+            hash ^= pieceKeys[pos->board[square]][square];
+        }
+    }
+    if (pos->enPassantSquare != NO_SQUARE) hash ^= enPassantKeys[FILE_OF(pos->enPassantSquare)];
+    if (pos->sideToMove == COLOR_BLACK) hash ^= sideKey;
+    return hash;
+}
+
+void PackPosition(const POSITION *pos, PACKEDPOSITION *packed) {
+    for (int i = 0; i < 32; i++) {
+        packed->squares[i] = 0;
+    }
+    for (int square = 0; square < BOARD_SQUARES; square++) {
+        int piece = pos->board[square];
+        if (piece == NO_PIECE) continue;
+        packed->squares[square / 2] |= (uint8_t)((piece + 1) << (4 * (square & 1)));
+    }
+    packed->sideToMove = pos->sideToMove;
+    packed->castlingRights = pos->castlingRights;
+    packed->enPassantSquare = pos->enPassantSquare;
+    packed->halfmoveClock = pos->halfmoveClock;
+    packed->fullmoveNumber = pos->fullmoveNumber;
+}
+
+void UnpackPosition(const PACKEDPOSITION *packed, POSITION *pos) {
+    ClearPosition(pos);
+    for (int square = 0; square < BOARD_SQUARES; square++) {
+        int code = (packed->squares[square / 2] >> (4 * (square & 1))) & 15;
+        if (code == 0) continue;
+        PutPiece(pos, square, PIECE_COLOR(code - 1), PIECE_TYPE(code - 1));
+    }
+    pos->sideToMove = packed->sideToMove;
+    pos->castlingRights = packed->castlingRights;
+    pos->enPassantSquare = packed->enPassantSquare;
+    pos->halfmoveClock = packed->halfmoveClock;
+    pos->fullmoveNumber = packed->fullmoveNumber;
+    pos->hash = ComputeHash(pos);
+}
@@ -0,0 +1,110 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bitboard.h"
+#include "zobrist.h"
+
+#define BOARD_SQUARES 64
+#define NO_SQUARE -1
+#define NO_PIECE -1
+
+#define COLOR_WHITE 0
+#define COLOR_BLACK 1
+
+/*
+    Squares are numbered a1 = 0 ... h8 = 63, rank 0 being White's back rank
+*/
+#define SQUARE(rank, file) ((rank) * 8 + (file))
+#define RANK_OF(square) ((square) >> 3)
+#define FILE_OF(square) ((square) & 7)
+
+typedef enum PieceType {
+    PAWN,
+    ROOK,
+    KNIGHT,
+    BISHOP,
+    QUEEN,
+    KING
+} PIECETYPE;
+
+/*
+    A piece is stored as color * 6 + type, NO_PIECE marks an empty square
+*/
+#define PIECE_CODE(color, type) ((color) * 6 + (type))
+#define PIECE_COLOR(piece) ((piece) / 6)
+#define PIECE_TYPE(piece) ((PIECETYPE)((piece) % 6))
+
+// Most pieces of one kind a side can have: 8 promoted pawns plus the 2 originals
+#define MAX_PIECES_PER_TYPE 10
+
+#define CASTLE_WHITE_KING  1
+#define CASTLE_WHITE_QUEEN 2
+#define CASTLE_BLACK_KING  4
+#define CASTLE_BLACK_QUEEN 8
+
+/*
+    Pieces are kept as bitboards (per type and per color), as a mailbox for square lookups
+    and as per-piece lists of squares, all updated together by PutPiece/RemovePiece/RelocatePiece
+    hash is the Zobrist key, XOR-updated by the same functions and by MakeMove/UnmakeMove
+*/
+typedef struct Position {
+    BITBOARD byType[6];
+    BITBOARD byColor[2];
+    int8_t board[BOARD_SQUARES];
+    int8_t listIndex[BOARD_SQUARES];
+    int8_t pieceCount[12];
+    int8_t pieceList[12][MAX_PIECES_PER_TYPE];
+    int8_t kingSquare[2];
+    uint8_t sideToMove;
+    uint8_t castlingRights;
+    int8_t enPassantSquare;
+    uint8_t halfmoveClock;
+    uint16_t fullmoveNumber;
+    uint64_t hash;
+} POSITION;
+
+/*
+    Position in 38 bytes for storing many of them: two squares per byte, low nibble first,
+    each nibble the piece code plus one, then the state fields; hash and lists are rebuilt on unpacking
+*/
+typedef struct PackedPosition {
+    uint8_t squares[32];
+    uint8_t sideToMove;
+    uint8_t castlingRights;
+    int8_t enPassantSquare;
+    uint8_t halfmoveClock;
+    uint16_t fullmoveNumber;
+} PACKEDPOSITION;
+
+/*
+    Set up positions
+*/
+void ClearPosition(POSITION *pos);
+void SetStartingPosition(POSITION *pos);
+void PutPiece(POSITION *pos, int square, int color, PIECETYPE type);
+void RemovePiece(POSITION *pos, int square);
+void RelocatePiece(POSITION *pos, int from, int to);
+
+int GetPieceAt(const POSITION *pos, int square);
+
+// Zobrist key from scratch, for loading positions and checking the incremental key
+uint64_t ComputeHash(const POSITION *pos);
+
+void PackPosition(const POSITION *pos, PACKEDPOSITION *packed);
+void UnpackPosition(const PACKEDPOSITION *packed, POSITION *pos);
+
+static inline BITBOARD Occupied(const POSITION *pos) {
+    return pos->byColor[COLOR_WHITE] | pos->byColor[COLOR_BLACK];
+}
+
+static inline int FindKing(const POSITION *pos, int color) {
+    return pos->kingSquare[color];
+}
+
+static inline BITBOARD PiecesOf(const POSITION *pos, int color, PIECETYPE type) {
+    return pos->byColor[color] & pos->byType[type];
+}
+
+#endif // POSITION_H
@@ -0,0 +1,408 @@
+#include "rules.h"
+
+bool IsSquareAttacked(const POSITION *pos, int square, int byColor) {
+    BITBOARD occupied = Occupied(pos);
+    BITBOARD attackers = pos->byColor[byColor];
+    BITBOARD queens = pos->byType[QUEEN];
+
+    // Look outwards from the square with each piece's own pattern
+    return (pawnAttacks[!byColor][square] & attackers & pos->byType[PAWN]) ||
+           (knightAttacks[square] & attackers & pos->byType[KNIGHT]) ||
+           (kingAttacks[square] & attackers & pos->byType[KING]) ||
+           (BishopAttacks(square, occupied) & attackers & (pos->byType[BISHOP] | queens)) ||
+           (RookAttacks(square, occupied) & attackers & (pos->byType[ROOK] | queens));
+}
+
+bool IsInCheck(const POSITION *pos, int color) {
+    int kingSquare = FindKing(pos, color);
+    if (kingSquare == NO_SQUARE) return false;
+    return IsSquareAttacked(pos, kingSquare, !color);
+}
+
+static void AddMove(MOVELIST *list, int from, int to, int flags) {
+    list->moves[list->count++] = ENCODE_MOVE(from, to, flags);
+}
+
+// A pawn reaching the last rank adds one move per promotion piece, queen first
+static void AddPawnMove(MOVELIST *list, int from, int to, int flags) {
+    if (RANK_OF(to) == 0 || RANK_OF(to) == 7) {
+        for (int piece = 3; piece >= 0; piece--) {
+            AddMove(list, from, to, flags | MOVE_PROMOTE | piece);
+        }
+    } else {
+        AddMove(list, from, to, flags);
+    }
+}
+
+BITBOARD AttackersTo(const POSITION *pos, int square, BITBOARD occupied) {
+    BITBOARD queens = pos->byType[QUEEN];
+
+    return (pawnAttacks[COLOR_BLACK][square] & PiecesOf(pos, COLOR_WHITE, PAWN)) |
+           (pawnAttacks[COLOR_WHITE][square] & PiecesOf(pos, COLOR_BLACK, PAWN)) |
+           (knightAttacks[square] & pos->byType[KNIGHT]) |
+           (kingAttacks[square] & pos->byType[KING]) |
+           (BishopAttacks(square, occupied) & (pos->byType[BISHOP] | queens)) |
+           (RookAttacks(square, occupied) & (pos->byType[ROOK] | queens));
+}
+
+/*
+    Everything the generator needs to emit only legal moves, computed once per position
+*/
+typedef struct LegalityMasks {
+    int king;
+    BITBOARD checkers;
+    BITBOARD checkMask;     // squares a non-king move must land on (or capture on) to answer a check
+    BITBOARD pinned;
+    BITBOARD enemyAttacks;  // squares the king cannot step to
+} LEGALITYMASKS;
+
+static BITBOARD PieceAttacks(PIECETYPE type, int from, BITBOARD occupied) {
+    switch (type) {
+        case ROOK:   return RookAttacks(from, occupied);
+        case KNIGHT: return knightAttacks[from];
+        case BISHOP: return BishopAttacks(from, occupied);
+        case QUEEN:  return QueenAttacks(from, occupied);
+        case KING:   return kingAttacks[from];
+        default:     return 0;
+    }
+}
+
+static BITBOARD EnemyAttacks(const POSITION *pos, int them, BITBOARD occupied) {
+    BITBOARD pawns = PiecesOf(pos, them, PAWN);
+    BITBOARD attacks = (them == COLOR_WHITE)
+        ? ((pawns & ~FILE_A_BB) << 7) | ((pawns & ~FILE_H_BB) << 9)
+        : ((pawns & ~FILE_A_BB) >> 9) | ((pawns & ~FILE_H_BB) >> 7);
+
+    for (PIECETYPE type = ROOK; type <= KING; type++) {
+        int piece = PIECE_CODE(them, type);
+        for (int i = 0; i < pos->pieceCount[piece]; i++) {
+            attacks |= PieceAttacks(type, pos->pieceList[piece][i], occupied);
+        }
+    }
+    return attacks;
+}
+
+static void ComputeLegalityMasks(const POSITION *pos, LEGALITYMASKS *masks) {
+    int us = pos->sideToMove;
+    int them = !us;
+    int king = FindKing(pos, us);
+    BITBOARD occupied = Occupied(pos);
+
+    masks->king = king;
+    masks->checkers = 0;
+    masks->checkMask = ~0ULL;
+    masks->pinned = 0;
+    masks->enemyAttacks = 0;
+    if (king == NO_SQUARE) return;
+
+    // Sliders see through our king, so it cannot step back along the checking ray
+    masks->enemyAttacks = EnemyAttacks(pos, them, occupied ^ BIT(king));
+    masks->checkers = AttackersTo(pos, king, occupied) & pos->byColor[them];
+
+    if (masks->checkers) {
+        int checker = LsbIndex(masks->checkers);
+        masks->checkMask = betweenBB[king][checker] | masks->checkers;
+    }
+
+    // An enemy slider on an empty line to our king, but for exactly one of our pieces, pins it
+    BITBOARD queens = PiecesOf(pos, them, QUEEN);
+    BITBOARD snipers = (RookAttacks(king, 0) & (PiecesOf(pos, them, ROOK) | queens)) |
+                       (BishopAttacks(king, 0) & (PiecesOf(pos, them, BISHOP) | queens));
+    while (snipers) {
+        BITBOARD blockers = betweenBB[king][PopLsb(&snipers)] & occupied;
+        if (blockers && !(blockers & (blockers - 1)) && (blockers & pos->byColor[us])) {
+            masks->pinned |= blockers;
+        }
+    }
+}
+
+// A pinned piece may only move along the line through its king and the pinner
+static BITBOARD AllowedTargets(const LEGALITYMASKS *masks, int from) {
+    if (masks->pinned & BIT(from)) return masks->checkMask & lineBB[masks->king][from];
+    return masks->checkMask;
+}
+
+// En passant removes two pieces from the capturing rank, test the uncovered lines directly
+static bool IsEnPassantLegal(const POSITION *pos, int from, int to, int king) {
+    int us = pos->sideToMove;
+    int captured = SQUARE(RANK_OF(from), FILE_OF(to));
+    BITBOARD occupied = (Occupied(pos) ^ BIT(from) ^ BIT(captured)) | BIT(to);
+    BITBOARD queens = PiecesOf(pos, !us, QUEEN);
+
+    if (king == NO_SQUARE) return true;
+    return !(RookAttacks(king, occupied) & (PiecesOf(pos, !us, ROOK) | queens)) &&
+           !(BishopAttacks(king, occupied) & (PiecesOf(pos, !us, BISHOP) | queens)) &&
+           !(pawnAttacks[us][king] & PiecesOf(pos, !us, PAWN) & ~BIT(captured)) &&
+           !(knightAttacks[king] & PiecesOf(pos, !us, KNIGHT));
+}
+
+static void GeneratePawnMoves(const POSITION *pos, MOVELIST *list, const LEGALITYMASKS *masks) {
+    int us = pos->sideToMove;
+    BITBOARD pawns = PiecesOf(pos, us, PAWN);
+    BITBOARD empty = ~Occupied(pos);
+    BITBOARD enemies = pos->byColor[!us];
+    int forward = (us == COLOR_WHITE) ? 8 : -8;
+
+    // Push the unpinned pawns as a set, double pushes start from the ones that reached rank 3 or 6
+    BITBOARD free = pawns & ~masks->pinned;
+    BITBOARD single, twice;
+    if (us == COLOR_WHITE) {
+        single = (free << 8) & empty;
+        twice = ((single & (RANK_1_BB << 16)) << 8) & empty;
+    } else {
+        single = (free >> 8) & empty;
+        twice = ((single & (RANK_1_BB << 40)) >> 8) & empty;
+    }
+    single &= masks->checkMask;
+    twice &= masks->checkMask;
+
+    while (single) {
+        int to = PopLsb(&single);
+        AddPawnMove(list, to - forward, to, MOVE_QUIET);
+    }
+    while (twice) {
+        int to = PopLsb(&twice);
+        AddMove(list, to - 2 * forward, to, MOVE_DOUBLE_PUSH);
+    }
+
+    // Pinned pawns can still push along a file pin, one at a time
+    for (BITBOARD pinned = pawns & masks->pinned; pinned; ) {
+        int from = PopLsb(&pinned);
+        int to = from + forward;
+        if (!(empty & BIT(to))) continue;
+        if (AllowedTargets(masks, from) & BIT(to)) AddPawnMove(list, from, to, MOVE_QUIET);
+        int startRank = (us == COLOR_WHITE) ? 1 : 6;
+        if (RANK_OF(from) == startRank && (empty & BIT(to + forward)) && (AllowedTargets(masks, from) & BIT(to + forward))) {
+            AddMove(list, from, to + forward, MOVE_DOUBLE_PUSH);
+        }
+    }
+
+    for (BITBOARD remaining = pawns; remaining; ) {
+        int from = PopLsb(&remaining);
+        BITBOARD captures = pawnAttacks[us][from] & enemies & AllowedTargets(masks, from);
+        while (captures) {
+            AddPawnMove(list, from, PopLsb(&captures), MOVE_CAPTURE);
+        }
+    }
+
+    if (pos->enPassantSquare != NO_SQUARE) {
+        int to = pos->enPassantSquare;
+        BITBOARD capturers = pawnAttacks[!us][to] & pawns;
+        while (capturers) {
+            int from = PopLsb(&capturers);
+            if (IsEnPassantLegal(pos, from, to, masks->king)) {
+                AddMove(list, from, to, MOVE_EN_PASSANT);
+            }
+        }
+    }
+}
+
+static void GeneratePieceMoves(const POSITION *pos, MOVELIST *list, const LEGALITYMASKS *masks) {
+    int us = pos->sideToMove;
+    BITBOARD occupied = Occupied(pos);
+    BITBOARD enemies = pos->byColor[!us];
+
+    for (PIECETYPE type = ROOK; type <= QUEEN; type++) {
+        int piece = PIECE_CODE(us, type);
+        for (int i = 0; i < pos->pieceCount[piece]; i++) {
+            int from = pos->pieceList[piece][i];
+            BITBOARD targets = PieceAttacks(type, from, occupied) & ~pos->byColor[us] & AllowedTargets(masks, from);
+            while (targets) {
+                int to = PopLsb(&targets);
+                AddMove(list, from, to, (enemies & BIT(to)) ? MOVE_CAPTURE : MOVE_QUIET);
+            }
+        }
+    }
+}
+
+static void GenerateKingMoves(const POSITION *pos, MOVELIST *list, const LEGALITYMASKS *masks) {
+    int us = pos->sideToMove;
+    int from = masks->king;
+    BITBOARD occupied = Occupied(pos);
+    BITBOARD enemies = pos->byColor[!us];
+
+    if (from == NO_SQUARE) return;
+
+    BITBOARD targets = kingAttacks[from] & ~pos->byColor[us] & ~masks->enemyAttacks;
+    while (targets) {
+        int to = PopLsb(&targets);
+        AddMove(list, from, to, (enemies & BIT(to)) ? MOVE_CAPTURE : MOVE_QUIET);
+    }
+
+    // King passes through and lands on squares that must be empty and not attacked
+    int kingSide = (us == COLOR_WHITE) ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+    int queenSide = (us == COLOR_WHITE) ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+
+    if (masks->checkers || !(pos->castlingRights & (kingSide | queenSide))) return;
+
+    if ((pos->castlingRights & kingSide) &&
+        !(occupied & (BIT(from + 1) | BIT(from + 2))) &&
+        !(masks->enemyAttacks & (BIT(from + 1) | BIT(from + 2)))) {
+        AddMove(list, from, from + 2, MOVE_CASTLE_KING);
+    }
+
+    if ((pos->castlingRights & queenSide) &&
+        !(occupied & (BIT(from - 1) | BIT(from - 2) | BIT(from - 3))) &&
+        !(masks->enemyAttacks & (BIT(from - 1) | BIT(from - 2)))) {
+        AddMove(list, from, from - 2, MOVE_CASTLE_QUEEN);
+    }
+}
+
+void GenerateLegalMoves(POSITION *pos, MOVELIST *list) {
+    LEGALITYMASKS masks;
+    ComputeLegalityMasks(pos, &masks);
+
+    list->count = 0;
+    GenerateKingMoves(pos, list, &masks);
+
+    // In double check only the king can move
+    if (masks.checkers & (masks.checkers - 1)) return;
+
+    GeneratePawnMoves(pos, list, &masks);
+    GeneratePieceMoves(pos, list, &masks);
+}
+
+MOVE FindLegalMove(const MOVELIST *list, int from, int to, PIECETYPE promotion) {
+    for (int i = 0; i < list->count; i++) {
+        MOVE move = list->moves[i];
+        if (MOVE_FROM(move) != from || MOVE_TO(move) != to) continue;
+        if (IS_PROMOTION(move) && PromotionPiece(move) != promotion) continue;
+        return move;
+    }
+    return MOVE_NONE;
+}
+
+// Castling rights that survive a move touching each square (king and rook home squares)
+static const uint8_t castlingMask[64] = {
+    [SQUARE(0, 0)] = 15 & ~CASTLE_WHITE_QUEEN,
+    [SQUARE(0, 4)] = 15 & ~(CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN),
+    [SQUARE(0, 7)] = 15 & ~CASTLE_WHITE_KING,
+    [SQUARE(7, 0)] = 15 & ~CASTLE_BLACK_QUEEN,
+    [SQUARE(7, 4)] = 15 & ~(CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN),
+    [SQUARE(7, 7)] = 15 & ~CASTLE_BLACK_KING,
+};
+
+static void ClearCastlingRightsAt(POSITION *pos, int square) {
+    if (castlingMask[square]) {
+        pos->castlingRights &= castlingMask[square];
+    }
+}
+
+// Castling also moves the rook next to the king
+static void CastlingRookSquares(MOVE move, int *rookFrom, int *rookTo) {
+    int from = MOVE_FROM(move);
+    *rookFrom = (MOVE_FLAGS(move) == MOVE_CASTLE_KING) ? from + 3 : from - 4;
+    *rookTo = (MOVE_FLAGS(move) == MOVE_CASTLE_KING) ? from + 1 : from - 1;
+}
+
+// En passant takes the pawn that just passed the target square
+static int CapturedSquare(MOVE move) {
+    if (MOVE_FLAGS(move) == MOVE_EN_PASSANT) {
+        return SQUARE(RANK_OF(MOVE_FROM(move)), FILE_OF(MOVE_TO(move)));
+    }
+    return MOVE_TO(move);
+}
+
+// Part of the Zobrist key that is not pieces on squares, swapped out and in around each move
+static uint64_t StateKey(const POSITION *pos) {
+    uint64_t key = castlingKeys[pos->castlingRights];
+    if (pos->enPassantSquare != NO_SQUARE) key ^= enPassantKeys[FILE_OF(pos->enPassantSquare)];
+    return key;
+}
+
+void MakeMove(POSITION *pos, MOVE move, UNDO *undo) {
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int flags = MOVE_FLAGS(move);
+    int color = pos->sideToMove;
+    PIECETYPE type = PIECE_TYPE(pos->board[from]);
+
+    undo->move = move;
+    undo->captured = NO_PIECE;
+    undo->castlingRights = pos->castlingRights;
+    undo->enPassantSquare = pos->enPassantSquare;
+    undo->halfmoveClock = pos->halfmoveClock;
+    pos->hash ^= StateKey(pos);
+
+    if (flags & MOVE_CAPTURE) {
+        int capturedSquare = CapturedSquare(move);
+        undo->captured = pos->board[capturedSquare];
+        RemovePiece(pos, capturedSquare);
+    }
+    RelocatePiece(pos, from, to);
+
+    if (flags == MOVE_CASTLE_KING || flags == MOVE_CASTLE_QUEEN) {
+        int rookFrom, rookTo;
+        CastlingRookSquares(move, &rookFrom, &rookTo);
+        RelocatePiece(pos, rookFrom, rookTo);
+    }
+
+    if (flags & MOVE_PROMOTE) {
+        PutPiece(pos, to, color, PromotionPiece(move));
+    }
+
+    ClearCastlingRightsAt(pos, from);
+    ClearCastlingRightsAt(pos, to);
+
+    pos->enPassantSquare = (flags == MOVE_DOUBLE_PUSH) ? (from + to) / 2 : NO_SQUARE;
+    pos->halfmoveClock = (type == PAWN || (flags & MOVE_CAPTURE)) ? 0 : pos->halfmoveClock + 1;
+    if (color == COLOR_BLACK) pos->fullmoveNumber++;
+    pos->sideToMove = !color;
+    pos->hash ^= StateKey(pos) ^ sideKey;
+}
+
+void UnmakeMove(POSITION *pos, const UNDO *undo) {
+    MOVE move = undo->move;
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int flags = MOVE_FLAGS(move);
+    int color = !pos->sideToMove;
+
+    pos->hash ^= StateKey(pos) ^ sideKey;
+
+    if (flags & MOVE_PROMOTE) {
+        PutPiece(pos, to, color, PAWN);
+    }
+    RelocatePiece(pos, to, from);
+
+    if (flags == MOVE_CASTLE_KING || flags == MOVE_CASTLE_QUEEN) {
+        int rookFrom, rookTo;
+        CastlingRookSquares(move, &rookFrom, &rookTo);
+        RelocatePiece(pos, rookTo, rookFrom);
+    }
+
+    if (undo->captured != NO_PIECE) {
+        PutPiece(pos, CapturedSquare(move), PIECE_COLOR(undo->captured), PIECE_TYPE(undo->captured));
+    }
+
+    pos->castlingRights = undo->castlingRights;
+    pos->enPassantSquare = undo->enPassantSquare;
+    pos->halfmoveClock = undo->halfmoveClock;
+    if (color == COLOR_BLACK) pos->fullmoveNumber--;
+    pos->sideToMove = color;
+    pos->hash ^= StateKey(pos);
+}
+
+GAMESTATUS GetGameStatus(POSITION *pos) {
+    MOVELIST list;
+    GenerateLegalMoves(pos, &list);
+    if (list.count > 0) return GAME_ONGOING;
+    return IsInCheck(pos, pos->sideToMove) ? GAME_CHECKMATE : GAME_STALEMATE;
+}
+
+uint64_t Perft(POSITION *pos, int depth) {
+    MOVELIST list;
+    GenerateLegalMoves(pos, &list);
+
+    // Bulk count the last ply, every legal move is a leaf
+    if (depth <= 1) return depth == 1 ? (uint64_t)list.count : 1;
+
+    uint64_t nodes = 0;
+    for (int i = 0; i < list.count; i++) {
+        UNDO undo;
+        MakeMove(pos, list.moves[i], &undo);
+        nodes += Perft(pos, depth - 1);
+        UnmakeMove(pos, &undo);
+    }
+    return nodes;
+}
@@ -0,0 +1,50 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include "position.h"
+#include "move.h"
+
+// Longest game history the GUI keeps undo records for
+#define MAX_GAME_PLY 1024
+
+// No legal position has more than 218 moves
+#define MAX_MOVES 256
+
+typedef struct MoveList {
+    MOVE moves[MAX_MOVES];
+    int count;
+} MOVELIST;
+
+typedef enum GameStatus {
+    GAME_ONGOING,
+    GAME_CHECKMATE,
+    GAME_STALEMATE
+} GAMESTATUS;
+
+/*
+    Attacks and checks
+*/
+bool IsSquareAttacked(const POSITION *pos, int square, int byColor);
+bool IsInCheck(const POSITION *pos, int color);
+BITBOARD AttackersTo(const POSITION *pos, int square, BITBOARD occupied);
+
+/*
+    Fill the list with every legal move of the side to move in one pass, checks and pins
+    are computed once up front so no candidate move has to be played to test it
+    FindLegalMove looks up a from/to pair in it, promotion is only compared for promoting moves
+*/
+void GenerateLegalMoves(POSITION *pos, MOVELIST *list);
+MOVE FindLegalMove(const MOVELIST *list, int from, int to, PIECETYPE promotion);
+
+/*
+    Play and take back moves for the side to move, both are O(1)
+*/
+void MakeMove(POSITION *pos, MOVE move, UNDO *undo);
+void UnmakeMove(POSITION *pos, const UNDO *undo);
+
+GAMESTATUS GetGameStatus(POSITION *pos);
+
+// Leaf nodes of the legal move tree to the given depth, the reference check for move generation
+uint64_t Perft(POSITION *pos, int depth);
+
+#endif // RULES_H
@@ -0,0 +1,47 @@
+#include "zobrist.h"
+#include <pthread.h>
+
+uint64_t pieceKeys[12][64];
+uint64_t castlingKeys[16];
+uint64_t enPassantKeys[8];
+uint64_t sideKey;
+
+// SplitMix64, fixed seed so keys are the same in every build and process
+static uint64_t NextKey(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void BuildZobrist(void) {
+    uint64_t state = 0x43484553534B4559ULL;
+
+    for (int piece = 0; piece < 12; piece++) {
+        for (int square = 0; square < 64; square++) {
+            pieceKeys[piece][square] = NextKey(&state);
+        }
+    }
+
+    // Rights combine by XOR of the single-right keys, so clearing one right is one XOR
+    uint64_t rightKeys[4];
+    for (int right = 0; right < 4; right++) {
+        rightKeys[right] = NextKey(&state);
+    }
+    for (int rights = 0; rights < 16; rights++) {
+        castlingKeys[rights] = 0;
+        for (int right = 0; right < 4; right++) {
+            if (rights & (1 << right)) castlingKeys[rights] ^= rightKeys[right];
+        }
+    }
+
+    for (int file = 0; file < 8; file++) {
+        enPassantKeys[file] = NextKey(&state);
+    }
+    sideKey = NextKey(&state);
+}
+
+void InitZobrist(void) {
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, BuildZobrist);
+}
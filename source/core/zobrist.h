@@ -0,0 +1,20 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <stdint.h>
+
+/*
+    Random keys XORed together to identify a position: one per piece and square,
+    one per castling rights combination, one per en passant file and one for Black to move
+*/
+extern uint64_t pieceKeys[12][64];
+extern uint64_t castlingKeys[16];
+extern uint64_t enPassantKeys[8];
+extern uint64_t sideKey;
+
+/*
+    Fill the key tables, safe to call more than once and from several threads at once
+*/
+void InitZobrist(void);
+
+#endif // ZOBRIST_H
@@ -0,0 +1,140 @@
+#define _POSIX_C_SOURCE 200809L
+#include "analysis.h"
+#include <string.h>
+
+static unsigned char *PutBytes(unsigned char *out, uint64_t value, int count) {
+    for (int i = 0; i < count; i++) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+    return out + count;
+}
+
+static uint64_t GetBytes(const unsigned char *in, int count) {
+    uint64_t value = 0;
+    for (int i = count - 1; i >= 0; i--) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+size_t EncodeAnalysisRequest(const ANALYSISREQUEST *request, unsigned char *frame) {
+    size_t fenLength = strnlen(request->fen, sizeof(request->fen) - 1);
+    unsigned char *out = frame + ANALYSIS_FRAME_HEADER;
+    out = PutBytes(out, request->id, 4);
+    out = PutBytes(out, request->depth, 2);
+    out = PutBytes(out, request->moveTimeMs, 4);
+    out = PutBytes(out, request->deadlineMs, 4);
+    out = PutBytes(out, request->nodes, 8);
+    out = PutBytes(out, fenLength, 1);
+    memcpy(out, request->fen, fenLength);
+    out += fenLength;
+
+    size_t payload = (size_t)(out - frame) - ANALYSIS_FRAME_HEADER;
+    PutBytes(frame, payload, 4);
+    return (size_t)(out - frame);
+}
+
+bool DecodeAnalysisRequest(const unsigned char *payload, size_t length, ANALYSISREQUEST *request) {
+    if (length < 23) return false;
+    request->id = (uint32_t)GetBytes(payload, 4);
+    request->depth = (uint16_t)GetBytes(payload + 4, 2);
+    request->moveTimeMs = (uint32_t)GetBytes(payload + 6, 4);
+    request->deadlineMs = (uint32_t)GetBytes(payload + 10, 4);
+    request->nodes = GetBytes(payload + 14, 8);
+
+    size_t fenLength = payload[22];
+    if (fenLength >= sizeof(request->fen) || 23 + fenLength != length) return false;
+    memcpy(request->fen, payload + 23, fenLength);
+    request->fen[fenLength] = '\0';
+    return true;
+}
+
+size_t EncodeAnalysisReply(const ANALYSISREPLY *reply, unsigned char *frame) {
+    size_t moveLength = strnlen(reply->bestMove, sizeof(reply->bestMove) - 1);
+    unsigned char *out = frame + ANALYSIS_FRAME_HEADER;
+    out = PutBytes(out, reply->id, 4);
+    out = PutBytes(out, reply->status, 1);
+    out = PutBytes(out, reply->depth, 1);
+    out = PutBytes(out, (uint16_t)reply->score, 2);
+    out = PutBytes(out, reply->nodes, 8);
+    out = PutBytes(out, reply->queueMicros, 4);
+    out = PutBytes(out, reply->searchMicros, 4);
+    out = PutBytes(out, moveLength, 1);
+    memcpy(out, reply->bestMove, moveLength);
+    out += moveLength;
+
+    size_t payload = (size_t)(out - frame) - ANALYSIS_FRAME_HEADER;
+    PutBytes(frame, payload, 4);
+    return (size_t)(out - frame);
+}
+
+bool DecodeAnalysisReply(const unsigned char *payload, size_t length, ANALYSISREPLY *reply) {
+    if (length < 25) return false;
+    reply->id = (uint32_t)GetBytes(payload, 4);
+    reply->status = payload[4];
+    reply->depth = payload[5];
+    reply->score = (int16_t)GetBytes(payload + 6, 2);
+    reply->nodes = GetBytes(payload + 8, 8);
+    reply->queueMicros = (uint32_t)GetBytes(payload + 16, 4);
+    reply->searchMicros = (uint32_t)GetBytes(payload + 20, 4);
+
+    size_t moveLength = payload[24];
+    if (moveLength >= sizeof(reply->bestMove) || 25 + moveLength != length) return false;
+    memcpy(reply->bestMove, payload + 25, moveLength);
+    reply->bestMove[moveLength] = '\0';
+    return true;
+}
+
+long AnalysisFrameSize(const unsigned char *buffer, size_t used) {
+    if (used < ANALYSIS_FRAME_HEADER) return 0;
+    uint64_t payload = GetBytes(buffer, 4);
+    if (payload == 0 || payload > ANALYSIS_MAX_PAYLOAD) return -1;
+    return (used >= ANALYSIS_FRAME_HEADER + payload) ? (long)(ANALYSIS_FRAME_HEADER + payload) : 0;
+}
+
+// Below 8 one bucket per microsecond, above it 8 buckets per power of two
+static int LatencyBucket(uint64_t micros) {
+    if (micros < 8) return (int)micros;
+    int exponent = 63 - __builtin_clzll(micros);
+    int bucket = 8 * (exponent - 2) + (int)((micros >> (exponent - 3)) & 7);
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+static uint64_t BucketMicros(int bucket) {
+    if (bucket < 8) return (uint64_t)bucket;
+    int exponent = bucket / 8 + 2;
+    return (uint64_t)(8 + bucket % 8) << (exponent - 3);
+}
+
+void AddLatency(LATENCYHISTOGRAM *histogram, uint64_t micros) {
+    __atomic_add_fetch(&histogram->counts[LatencyBucket(micros)], 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&histogram->total, 1, __ATOMIC_RELAXED);
+
+    uint64_t current = __atomic_load_n(&histogram->maxMicros, __ATOMIC_RELAXED);
+    while (micros > current && !__atomic_compare_exchange_n(&histogram->maxMicros, &current, micros, true,
+                                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+uint64_t LatencyPercentile(const LATENCYHISTOGRAM *histogram, double percentile) {
+    uint64_t total = __atomic_load_n(&histogram->total, __ATOMIC_RELAXED);
+    if (total == 0) return 0;
+
+    uint64_t rank = (uint64_t)(percentile / 100.0 * total);
+    if (rank >= total) rank = total - 1;
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += __atomic_load_n(&histogram->counts[bucket], __ATOMIC_RELAXED);
+        if (seen > rank) return BucketMicros(bucket);
+    }
+    return __atomic_load_n(&histogram->maxMicros, __ATOMIC_RELAXED);
+}
+
+// Field by field, AddLatency may be running on other threads while this clears them
+void ResetLatency(LATENCYHISTOGRAM *histogram) {
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        __atomic_store_n(&histogram->counts[bucket], 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&histogram->total, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&histogram->maxMicros, 0, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,82 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core/fen.h"
+#include "core/notation.h"
+
+#define ANALYSIS_SOCKET_PATH "/tmp/chess-analysis.sock"
+
+/*
+    Wire format on the analysis socket, every frame is a little-endian uint32 payload length
+    followed by the payload, requests and replies in the same framing
+
+    Request:  id u32, depth u16, moveTimeMs u32, deadlineMs u32, nodes u64, fen length u8, fen
+    Reply:    id u32, status u8, depth u8, score i16, nodes u64, queue us u32, search us u32,
+              best move length u8, best move in UCI notation
+
+    deadlineMs counts from the moment the server reads the request, zero means none
+*/
+#define ANALYSIS_FRAME_HEADER 4
+#define ANALYSIS_MAX_PAYLOAD 128
+#define ANALYSIS_MAX_FRAME (ANALYSIS_FRAME_HEADER + ANALYSIS_MAX_PAYLOAD)
+
+typedef enum AnalysisStatus {
+    ANALYSIS_OK,
+    ANALYSIS_BAD_REQUEST,
+    ANALYSIS_OVERLOADED,  // queue full, the request was never queued
+    ANALYSIS_EXPIRED      // deadline passed before a worker got to it
+} ANALYSISSTATUS;
+
+typedef struct AnalysisRequest {
+    uint32_t id;
+    uint16_t depth;
+    uint32_t moveTimeMs;
+    uint32_t deadlineMs;
+    uint64_t nodes;
+    char fen[FEN_BUFFER_SIZE];
+} ANALYSISREQUEST;
+
+typedef struct AnalysisReply {
+    uint32_t id;
+    uint8_t status;
+    uint8_t depth;
+    int16_t score;
+    uint64_t nodes;
+    uint32_t queueMicros;
+    uint32_t searchMicros;
+    char bestMove[MOVE_TEXT_SIZE];
+} ANALYSISREPLY;
+
+// Whole frames including the length prefix, frame must hold ANALYSIS_MAX_FRAME bytes
+size_t EncodeAnalysisRequest(const ANALYSISREQUEST *request, unsigned char *frame);
+size_t EncodeAnalysisReply(const ANALYSISREPLY *reply, unsigned char *frame);
+
+// Payloads without the length prefix, false on truncated or oversized fields
+bool DecodeAnalysisRequest(const unsigned char *payload, size_t length, ANALYSISREQUEST *request);
+bool DecodeAnalysisReply(const unsigned char *payload, size_t length, ANALYSISREPLY *reply);
+
+/*
+    Length of the first frame in a receive buffer: 0 while incomplete, -1 if the peer sent
+    a length no frame can have and the connection should be dropped
+*/
+long AnalysisFrameSize(const unsigned char *buffer, size_t used);
+
+/*
+    Latency histogram, buckets an eighth of a power of two wide so percentiles are within
+    about 9% over microseconds to minutes, updated with atomics from any thread
+*/
+#define LATENCY_BUCKETS (8 * 40)
+
+typedef struct LatencyHistogram {
+    uint64_t counts[LATENCY_BUCKETS];
+    uint64_t total;
+    uint64_t maxMicros;
+} LATENCYHISTOGRAM;
+
+void AddLatency(LATENCYHISTOGRAM *histogram, uint64_t micros);
+uint64_t LatencyPercentile(const LATENCYHISTOGRAM *histogram, double percentile);
+void ResetLatency(LATENCYHISTOGRAM *histogram);
+
+#endif // ANALYSIS_H
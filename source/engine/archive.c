@@ -0,0 +1,64 @@
+#define _DEFAULT_SOURCE
+#include "archive.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool OpenArchive(ARCHIVE *archive, const char *path) {
+    memset(archive, 0, sizeof(*archive));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(ARCHIVEHEADER)) {
+        close(fd);
+        return false;
+    }
+
+    const unsigned char *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    // Every entry is checked against the file size once so lookups can trust them
+    const ARCHIVEHEADER *header = (const ARCHIVEHEADER *)mapped;
+    const ARCHIVEENTRY *entries = (const ARCHIVEENTRY *)(mapped + sizeof(ARCHIVEHEADER));
+    bool valid = memcmp(header->magic, ARCHIVE_MAGIC, 4) == 0 && header->entrySize == sizeof(ARCHIVEENTRY) &&
+                 sizeof(ARCHIVEHEADER) + (size_t)header->entryCount * sizeof(ARCHIVEENTRY) <= (size_t)info.st_size;
+    for (uint32_t i = 0; valid && i < header->entryCount; i++) {
+        valid = entries[i].offset <= (uint64_t)info.st_size && entries[i].size <= (uint64_t)info.st_size - entries[i].offset &&
+                memchr(entries[i].name, '\0', ARCHIVE_NAME_SIZE) != NULL;
+    }
+    if (!valid) {
+        munmap((void *)mapped, info.st_size);
+        return false;
+    }
+
+    archive->mapped = mapped;
+    archive->mappedSize = info.st_size;
+    archive->entries = entries;
+    archive->entryCount = header->entryCount;
+    return true;
+}
+
+void CloseArchive(ARCHIVE *archive) {
+    if (archive->mapped) munmap((void *)archive->mapped, archive->mappedSize);
+    memset(archive, 0, sizeof(*archive));
+}
+
+const unsigned char *FindArchiveFile(const ARCHIVE *archive, const char *name, size_t *size) {
+    uint32_t low = 0, high = archive->entryCount;
+    while (low < high) {
+        uint32_t middle = (low + high) / 2;
+        int order = strncmp(archive->entries[middle].name, name, ARCHIVE_NAME_SIZE);
+        if (order == 0) {
+            *size = archive->entries[middle].size;
+            return archive->mapped + archive->entries[middle].offset;
+        }
+        if (order < 0) low = middle + 1;
+        else high = middle;
+    }
+    return NULL;
+}
@@ -0,0 +1,44 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARCHIVE_MAGIC "CAR1"
+#define ARCHIVE_NAME_SIZE 48
+#define ARCHIVE_ALIGNMENT 16
+
+/*
+    File layout, all native-endian:
+    header, the index sorted by name, then the files themselves each starting on an
+    ARCHIVE_ALIGNMENT boundary, stored as they were (PNGs stay compressed)
+*/
+typedef struct ArchiveEntry {
+    char name[ARCHIVE_NAME_SIZE];
+    uint64_t offset;
+    uint64_t size;
+} ARCHIVEENTRY;
+
+typedef struct ArchiveHeader {
+    char magic[4];
+    uint32_t entrySize;
+    uint32_t entryCount;
+    uint32_t reserved;
+} ARCHIVEHEADER;
+
+typedef struct Archive {
+    const unsigned char *mapped;
+    size_t mappedSize;
+    const ARCHIVEENTRY *entries;
+    uint32_t entryCount;
+} ARCHIVE;
+
+// Maps the file read-only, an asset's pages are read when it is first looked at
+bool OpenArchive(ARCHIVE *archive, const char *path);
+void CloseArchive(ARCHIVE *archive);
+
+// The stored bytes of a file by the name it was packed under, NULL if there is none
+const unsigned char *FindArchiveFile(const ARCHIVE *archive, const char *name, size_t *size);
+
+#endif // ARCHIVE_H
@@ -0,0 +1,162 @@
+#define _DEFAULT_SOURCE
+#include "book.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define POLYGLOT_CASTLE_OFFSET 768
+#define POLYGLOT_EN_PASSANT_OFFSET 772
+#define POLYGLOT_TURN_OFFSET 780
+
+bool OpenBook(BOOK *book, const char *path) {
+    book->entries = NULL;
+    book->entryCount = 0;
+    book->mappedSize = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < POLYGLOT_ENTRY_SIZE) {
+        close(fd);
+        return false;
+    }
+
+    // No MAP_POPULATE: a large book costs nothing until lookups touch its pages
+    void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+    madvise(mapped, info.st_size, MADV_RANDOM);
+
+    book->entries = mapped;
+    book->entryCount = info.st_size / POLYGLOT_ENTRY_SIZE;
+    book->mappedSize = info.st_size;
+    return true;
+}
+
+void CloseBook(BOOK *book) {
+    if (book->entries) munmap((void *)book->entries, book->mappedSize);
+    book->entries = NULL;
+    book->entryCount = 0;
+    book->mappedSize = 0;
+}
+
+static uint64_t ReadBigEndian(const unsigned char *bytes, int count) {
+    uint64_t value = 0;
+    for (int i = 0; i < count; i++) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+// Polyglot orders pieces black pawn, white pawn, black knight ... white king
+static int PolyglotKind(int piece) {
+    static const int kindOfType[6] = { [PAWN] = 0, [KNIGHT] = 1, [BISHOP] = 2, [ROOK] = 3, [QUEEN] = 4, [KING] = 5 };
+    return kindOfType[PIECE_TYPE(piece)] * 2 + (PIECE_COLOR(piece) == COLOR_WHITE);
+}
+
+uint64_t PolyglotKey(const POSITION *pos) {
+    uint64_t key = 0;
+
+    for (int piece = 0; piece < 12; piece++) {
+        for (int i = 0; i < pos->pieceCount[piece]; i++) {
+            key ^= polyglotRandom[64 * PolyglotKind(piece) + pos->pieceList[piece][i]];
+        }
+    }
+
+    static const uint8_t rights[4] = { CASTLE_WHITE_KING, CASTLE_WHITE_QUEEN, CASTLE_BLACK_KING, CASTLE_BLACK_QUEEN };
+    for (int i = 0; i < 4; i++) {
+        if (pos->castlingRights & rights[i]) key ^= polyglotRandom[POLYGLOT_CASTLE_OFFSET + i];
+    }
+
+    // The en passant file only counts when a pawn of the side to move can actually capture
+    if (pos->enPassantSquare != NO_SQUARE &&
+        (pawnAttacks[!pos->sideToMove][pos->enPassantSquare] & PiecesOf(pos, pos->sideToMove, PAWN))) {
+        key ^= polyglotRandom[POLYGLOT_EN_PASSANT_OFFSET + FILE_OF(pos->enPassantSquare)];
+    }
+
+    if (pos->sideToMove == COLOR_WHITE) key ^= polyglotRandom[POLYGLOT_TURN_OFFSET];
+    return key;
+}
+
+static int CastlingRookSquare(MOVE move) {
+    int from = MOVE_FROM(move);
+    return (MOVE_FLAGS(move) == MOVE_CASTLE_KING) ? from + 3 : from - 4;
+}
+
+uint16_t EncodePolyglotMove(MOVE move) {
+    static const int promotionCodes[6] = { [KNIGHT] = 1, [BISHOP] = 2, [ROOK] = 3, [QUEEN] = 4 };
+    int to = MOVE_TO(move);
+
+    if (MOVE_FLAGS(move) == MOVE_CASTLE_KING || MOVE_FLAGS(move) == MOVE_CASTLE_QUEEN) to = CastlingRookSquare(move);
+    uint16_t encoded = (uint16_t)(to | MOVE_FROM(move) << 6);
+    if (IS_PROMOTION(move)) encoded |= (uint16_t)(promotionCodes[PromotionPiece(move)] << 12);
+    return encoded;
+}
+
+MOVE DecodePolyglotMove(const MOVELIST *legal, uint16_t bookMove) {
+    for (int i = 0; i < legal->count; i++) {
+        if (EncodePolyglotMove(legal->moves[i]) == bookMove) return legal->moves[i];
+    }
+    return MOVE_NONE;
+}
+
+void ReadBookEntry(const BOOK *book, size_t index, BOOKENTRY *entry) {
+    const unsigned char *bytes = book->entries + index * POLYGLOT_ENTRY_SIZE;
+    entry->key = ReadBigEndian(bytes, 8);
+    entry->move = (uint16_t)ReadBigEndian(bytes + 8, 2);
+    entry->weight = (uint16_t)ReadBigEndian(bytes + 10, 2);
+    entry->learn = (uint32_t)ReadBigEndian(bytes + 12, 4);
+}
+
+// Binary search for the first entry, only about log2(entries) pages are touched
+size_t FindBookEntries(const BOOK *book, uint64_t key, size_t *first) {
+    size_t low = 0, high = book->entryCount;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (ReadBigEndian(book->entries + middle * POLYGLOT_ENTRY_SIZE, 8) < key) low = middle + 1;
+        else high = middle;
+    }
+
+    size_t last = low;
+    while (last < book->entryCount && ReadBigEndian(book->entries + last * POLYGLOT_ENTRY_SIZE, 8) == key) last++;
+    *first = low;
+    return last - low;
+}
+
+MOVE ProbeBook(const BOOK *book, POSITION *pos, uint64_t *rng) {
+    if (book->entries == NULL) return MOVE_NONE;
+
+    size_t first;
+    size_t count = FindBookEntries(book, PolyglotKey(pos), &first);
+    if (count == 0) return MOVE_NONE;
+
+    uint32_t totalWeight = 0;
+    BOOKENTRY entry;
+    for (size_t i = first; i < first + count; i++) {
+        ReadBookEntry(book, i, &entry);
+        totalWeight += entry.weight;
+    }
+
+    // xorshift64, zero-weight entries are never picked unless all of them are zero
+    uint64_t x = *rng ? *rng : 0x9E3779B97F4A7C15ULL;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *rng = x;
+
+    MOVELIST legal;
+    GenerateLegalMoves(pos, &legal);
+
+    uint32_t pick = totalWeight ? (uint32_t)(x % totalWeight) : 0;
+    for (size_t i = first; i < first + count; i++) {
+        ReadBookEntry(book, i, &entry);
+        if (totalWeight && pick >= entry.weight) {
+            pick -= entry.weight;
+            continue;
+        }
+        return DecodePolyglotMove(&legal, entry.move);
+    }
+    return MOVE_NONE;
+}
@@ -0,0 +1,49 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core/rules.h"
+
+#define POLYGLOT_RANDOM_COUNT 781
+#define POLYGLOT_ENTRY_SIZE 16
+
+extern const uint64_t polyglotRandom[POLYGLOT_RANDOM_COUNT];
+
+/*
+    Polyglot .bin opening book, mapped read-only and paged in by the kernel as lookups touch it
+    Entries are 16 big-endian bytes: key, move, weight, learn, sorted by key
+*/
+typedef struct OpeningBook {
+    const unsigned char *entries;
+    size_t entryCount;
+    size_t mappedSize;
+} BOOK;
+
+typedef struct BookEntry {
+    uint64_t key;
+    uint16_t move;
+    uint16_t weight;
+    uint32_t learn;
+} BOOKENTRY;
+
+bool OpenBook(BOOK *book, const char *path);
+void CloseBook(BOOK *book);
+
+uint64_t PolyglotKey(const POSITION *pos);
+
+// Book moves are king-takes-rook for castling, this turns them into our move encoding
+uint16_t EncodePolyglotMove(MOVE move);
+MOVE DecodePolyglotMove(const MOVELIST *legal, uint16_t bookMove);
+
+// Entries of one position are adjacent, returns how many there are from *first
+size_t FindBookEntries(const BOOK *book, uint64_t key, size_t *first);
+void ReadBookEntry(const BOOK *book, size_t index, BOOKENTRY *entry);
+
+/*
+    Weighted random pick among the book moves of the position, MOVE_NONE when out of book
+    rng is the caller's xorshift state, no allocation and no global state
+*/
+MOVE ProbeBook(const BOOK *book, POSITION *pos, uint64_t *rng);
+
+#endif // BOOK_H
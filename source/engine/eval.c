@@ -0,0 +1,120 @@
+#include "eval.h"
+
+// Indexed by PIECETYPE: pawn, rook, knight, bishop, queen, king
+const int pieceValues[6] = { 100, 500, 320, 330, 900, 0 };
+
+/*
+    Piece-square tables from White's side, rank 8 first as on a diagram
+    (values from Tomasz Michniewski's Simplified Evaluation Function)
+*/
+static const int pawnTable[64] = {
+     0,  0,  0,  0,  0,  0,  0,  0,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    10, 10, 20, 30, 30, 20, 10, 10,
+     5,  5, 10, 25, 25, 10,  5,  5,
+     0,  0,  0, 20, 20,  0,  0,  0,
+     5, -5,-10,  0,  0,-10, -5,  5,
+     5, 10, 10,-20,-20, 10, 10,  5,
+     0,  0,  0,  0,  0,  0,  0,  0
+};
+
+static const int knightTable[64] = {
+    -50,-40,-30,-30,-30,-30,-40,-50,
+    -40,-20,  0,  0,  0,  0,-20,-40,
+    -30,  0, 10, 15, 15, 10,  0,-30,
+    -30,  5, 15, 20, 20, 15,  5,-30,
+    -30,  0, 15, 20, 20, 15,  0,-30,
+    -30,  5, 10, 15, 15, 10,  5,-30,
+    -40,-20,  0,  5,  5,  0,-20,-40,
+    -50,-40,-30,-30,-30,-30,-40,-50
+};
+
+static const int bishopTable[64] = {
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20
+};
+
+static const int rookTable[64] = {
+      0,  0,  0,  0,  0,  0,  0,  0,
+      5, 10, 10, 10, 10, 10, 10,  5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+      0,  0,  0,  5,  5,  0,  0,  0
+};
+
+static const int queenTable[64] = {
+    -20,-10,-10, -5, -5,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5,  5,  5,  5,  0,-10,
+     -5,  0,  5,  5,  5,  5,  0, -5,
+      0,  0,  5,  5,  5,  5,  0, -5,
+    -10,  5,  5,  5,  5,  5,  0,-10,
+    -10,  0,  5,  0,  0,  0,  0,-10,
+    -20,-10,-10, -5, -5,-10,-10,-20
+};
+
+static const int kingMiddleTable[64] = {
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -20,-30,-30,-40,-40,-30,-30,-20,
+    -10,-20,-20,-20,-20,-20,-20,-10,
+     20, 20,  0,  0,  0,  0, 20, 20,
+     20, 30, 10,  0,  0, 10, 30, 20
+};
+
+static const int kingEndTable[64] = {
+    -50,-40,-30,-20,-20,-30,-40,-50,
+    -30,-20,-10,  0,  0,-10,-20,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-30,  0,  0,  0,  0,-30,-30,
+    -50,-30,-30,-30,-30,-30,-30,-50
+};
+
+static const int *const pieceTables[5] = { pawnTable, rookTable, knightTable, bishopTable, queenTable };
+
+// Non-pawn material of both sides at the start, the king blend runs from here down to zero
+#define OPENING_PHASE (2 * (2 * 320 + 2 * 330 + 2 * 500 + 900))
+
+int Evaluate(const POSITION *pos) {
+    int score[2] = { 0, 0 };
+    int phase = 0;
+
+    for (int color = COLOR_WHITE; color <= COLOR_BLACK; color++) {
+        // Tables are drawn from White's side, flip the rank for White's pieces
+        int flip = (color == COLOR_WHITE) ? 56 : 0;
+
+        for (PIECETYPE type = PAWN; type <= QUEEN; type++) {
+            int piece = PIECE_CODE(color, type);
+            for (int i = 0; i < pos->pieceCount[piece]; i++) {
+                score[color] += pieceValues[type] + pieceTables[type][pos->pieceList[piece][i] ^ flip];
+            }
+            if (type != PAWN) phase += pos->pieceCount[piece] * pieceValues[type];
+        }
+    }
+
+    if (phase > OPENING_PHASE) phase = OPENING_PHASE;
+
+    for (int color = COLOR_WHITE; color <= COLOR_BLACK; color++) {
+        int king = FindKing(pos, color);
+        if (king == NO_SQUARE) continue;
+        int square = king ^ ((color == COLOR_WHITE) ? 56 : 0);
+        score[color] += (kingMiddleTable[square] * phase + kingEndTable[square] * (OPENING_PHASE - phase)) / OPENING_PHASE;
+    }
+
+    int us = pos->sideToMove;
+    return score[us] - score[!us];
+}
@@ -0,0 +1,14 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "core/position.h"
+
+extern const int pieceValues[6];
+
+/*
+    Static evaluation in centipawns from the side to move's point of view:
+    material plus piece-square tables, king table blended from middlegame to endgame
+*/
+int Evaluate(const POSITION *pos);
+
+#endif // EVAL_H
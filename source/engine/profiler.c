@@ -0,0 +1,207 @@
+#define _POSIX_C_SOURCE 200809L
+#include "profiler.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    One producer per ring, written counts every event so readers know which slots are still
+    valid. Slots are copied field by field and checked against written afterwards, like a
+    seqlock: a copy the writer may have started overwriting meanwhile is thrown away
+*/
+typedef struct ProfileRing {
+    PROFILEEVENT events[PROFILE_RING_EVENTS];
+    uint64_t written;
+    uint64_t collected;
+    const char *threadName;
+} PROFILERING;
+
+bool profilingEnabled = false;
+
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+static const char *zoneNames[PROFILE_MAX_ZONES];
+static int zoneCount = 0;
+static PROFILERING *rings[PROFILE_MAX_THREADS];
+static int ringCount = 0;
+static __thread PROFILERING *threadRing = NULL;
+static __thread bool threadWithoutRing = false;
+
+// Ticks are related to the monotonic clock from the moment profiling was first enabled
+static uint64_t originTicks = 0;
+static uint64_t originNanos = 0;
+static double ticksPerMicro = 1000.0;
+
+static PROFILEZONESTATS zoneStats[PROFILE_MAX_ZONES];
+static float frameMillis[PROFILE_FRAME_HISTORY];
+static uint64_t frameCount = 0;
+static uint64_t lastFrameTicks = 0;
+
+uint64_t MonotonicNanos(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+// The longer profiling runs the better the estimate, a 5 ms sample gets it started
+static void Calibrate(void) {
+    uint64_t nanos = MonotonicNanos() - originNanos;
+    if (nanos > 1000000) ticksPerMicro = (double)(ProfileTicks() - originTicks) * 1000.0 / nanos;
+}
+
+void EnableProfiling(bool enabled) {
+    if (enabled && originTicks == 0) {
+        originNanos = MonotonicNanos();
+        originTicks = ProfileTicks();
+        struct timespec pause = { 0, 5000000 };
+        nanosleep(&pause, NULL);
+        Calibrate();
+    }
+    lastFrameTicks = 0;
+    __atomic_store_n(&profilingEnabled, enabled, __ATOMIC_RELAXED);
+}
+
+bool IsProfilingEnabled(void) {
+    return __atomic_load_n(&profilingEnabled, __ATOMIC_RELAXED);
+}
+
+int RegisterProfileZone(const char *name) {
+    pthread_mutex_lock(&registryLock);
+    int zone = 0;
+    while (zone < zoneCount && strcmp(zoneNames[zone], name) != 0) zone++;
+    if (zone == zoneCount && zoneCount < PROFILE_MAX_ZONES) {
+        zoneNames[zoneCount] = name;
+        zoneStats[zoneCount].name = name;
+        zoneCount++;
+    }
+    pthread_mutex_unlock(&registryLock);
+
+    // Zones past the limit share the last one rather than losing their time
+    return zone < PROFILE_MAX_ZONES ? zone : PROFILE_MAX_ZONES - 1;
+}
+
+static PROFILERING *ClaimRing(void) {
+    if (threadRing || threadWithoutRing) return threadRing;
+
+    pthread_mutex_lock(&registryLock);
+    if (ringCount < PROFILE_MAX_THREADS && (threadRing = calloc(1, sizeof(PROFILERING)))) {
+        __atomic_store_n(&rings[ringCount], threadRing, __ATOMIC_RELEASE);
+        __atomic_store_n(&ringCount, ringCount + 1, __ATOMIC_RELEASE);
+    }
+    threadWithoutRing = threadRing == NULL;
+    pthread_mutex_unlock(&registryLock);
+    return threadRing;
+}
+
+void NameProfileThread(const char *name) {
+    PROFILERING *ring = ClaimRing();
+    if (ring) ring->threadName = name;
+}
+
+void RecordProfileEvent(int zone, uint64_t start, uint64_t end) {
+    PROFILERING *ring = threadRing ? threadRing : ClaimRing();
+    if (!ring) return;
+
+    uint64_t index = ring->written;
+    PROFILEEVENT *slot = &ring->events[index % PROFILE_RING_EVENTS];
+
+    // A reader that sees any of the stores below also sees written at index or later
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&slot->start, start, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->end, end, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->zone, zone, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->written, index + 1, __ATOMIC_RELEASE);
+}
+
+// False when the writer has reached the slot again, the copy may mix two events
+static bool ReadRingEvent(PROFILERING *ring, uint64_t index, PROFILEEVENT *event) {
+    const PROFILEEVENT *slot = &ring->events[index % PROFILE_RING_EVENTS];
+    event->start = __atomic_load_n(&slot->start, __ATOMIC_RELAXED);
+    event->end = __atomic_load_n(&slot->end, __ATOMIC_RELAXED);
+    event->zone = __atomic_load_n(&slot->zone, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    // Writing event index + PROFILE_RING_EVENTS reuses the slot, and starts once written gets there
+    return __atomic_load_n(&ring->written, __ATOMIC_RELAXED) < index + PROFILE_RING_EVENTS;
+}
+
+void EndProfileFrame(void) {
+    if (!IsProfilingEnabled()) return;
+
+    uint64_t now = ProfileTicks();
+    Calibrate();
+    if (lastFrameTicks) frameMillis[frameCount++ % PROFILE_FRAME_HISTORY] = (float)((now - lastFrameTicks) / ticksPerMicro / 1000.0);
+    lastFrameTicks = now;
+
+    double micros[PROFILE_MAX_ZONES] = { 0 };
+    uint32_t calls[PROFILE_MAX_ZONES] = { 0 };
+    int threads = __atomic_load_n(&ringCount, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < threads; i++) {
+        PROFILERING *ring = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+        uint64_t written = __atomic_load_n(&ring->written, __ATOMIC_ACQUIRE);
+        uint64_t first = ring->collected;
+        if (written - first > PROFILE_RING_EVENTS) first = written - PROFILE_RING_EVENTS;
+
+        for (uint64_t index = first; index < written; index++) {
+            PROFILEEVENT event;
+            if (!ReadRingEvent(ring, index, &event) || event.zone < 0 || event.zone >= PROFILE_MAX_ZONES) continue;
+            micros[event.zone] += (event.end - event.start) / ticksPerMicro;
+            calls[event.zone]++;
+        }
+        ring->collected = written;
+    }
+
+    // About a second of smoothing at 60 frames per second
+    int zones = __atomic_load_n(&zoneCount, __ATOMIC_ACQUIRE);
+    for (int zone = 0; zone < zones; zone++) {
+        PROFILEZONESTATS *stats = &zoneStats[zone];
+        stats->calls = calls[zone];
+        stats->lastMicros = micros[zone];
+        stats->averageMicros += (micros[zone] - stats->averageMicros) / 60.0;
+        if (micros[zone] > stats->maxMicros) stats->maxMicros = micros[zone];
+    }
+}
+
+int GetProfileZones(PROFILEZONESTATS *zones, int capacity) {
+    int count = __atomic_load_n(&zoneCount, __ATOMIC_ACQUIRE);
+    if (count > capacity) count = capacity;
+    for (int zone = 0; zone < count; zone++) zones[zone] = zoneStats[zone];
+    return count;
+}
+
+int GetProfileFrames(float *milliseconds, int capacity) {
+    int count = frameCount < PROFILE_FRAME_HISTORY ? (int)frameCount : PROFILE_FRAME_HISTORY;
+    if (count > capacity) count = capacity;
+    for (int i = 0; i < count; i++) {
+        milliseconds[i] = frameMillis[(frameCount - count + i) % PROFILE_FRAME_HISTORY];
+    }
+    return count;
+}
+
+bool WriteProfileTrace(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) return false;
+
+    Calibrate();
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    int threads = __atomic_load_n(&ringCount, __ATOMIC_ACQUIRE);
+    for (int thread = 0; thread < threads; thread++) {
+        PROFILERING *ring = __atomic_load_n(&rings[thread], __ATOMIC_ACQUIRE);
+        fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", thread, ring->threadName ? ring->threadName : "thread");
+        first = false;
+
+        uint64_t written = __atomic_load_n(&ring->written, __ATOMIC_ACQUIRE);
+        uint64_t index = written > PROFILE_RING_EVENTS ? written - PROFILE_RING_EVENTS : 0;
+        for (; index < written; index++) {
+            PROFILEEVENT event;
+            if (!ReadRingEvent(ring, index, &event) || event.start < originTicks || event.zone < 0 || event.zone >= zoneCount) continue;
+            fprintf(file, ",\n{\"ph\":\"X\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    zoneNames[event.zone], thread, (event.start - originTicks) / ticksPerMicro,
+                    (event.end - event.start) / ticksPerMicro);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
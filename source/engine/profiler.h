@@ -0,0 +1,101 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+    Scoped timers for hot paths, each thread writes its zones into its own ring of events
+    While profiling is off a scope costs one load and one branch on entry and on exit
+
+        void RenderPieces(...) {
+            PROFILE_SCOPE("RenderPieces");
+            ...
+        }
+*/
+#define PROFILE_MAX_THREADS 16
+#define PROFILE_MAX_ZONES 32
+#define PROFILE_RING_EVENTS 8192
+#define PROFILE_FRAME_HISTORY 240
+
+typedef struct ProfileEvent {
+    uint64_t start;
+    uint64_t end;
+    int zone;
+} PROFILEEVENT;
+
+// Per-zone times over the last frame and smoothed over the last second or so
+typedef struct ProfileZoneStats {
+    const char *name;
+    uint32_t calls;
+    double lastMicros;
+    double averageMicros;
+    double maxMicros;
+} PROFILEZONESTATS;
+
+typedef struct ProfileScope {
+    uint64_t start;
+    int zone;
+} PROFILESCOPE;
+
+extern bool profilingEnabled;
+
+void EnableProfiling(bool enabled);
+bool IsProfilingEnabled(void);
+
+// Label for the calling thread in the trace, threads that do not set one are "thread"
+void NameProfileThread(const char *name);
+
+int RegisterProfileZone(const char *name);
+void RecordProfileEvent(int zone, uint64_t start, uint64_t end);
+
+uint64_t MonotonicNanos(void);
+
+// Time stamp counter where there is one, else the monotonic clock in nanoseconds
+static inline uint64_t ProfileTicks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return MonotonicNanos();
+#endif
+}
+
+static inline PROFILESCOPE BeginProfileScope(int *zone, const char *name) {
+    if (!__atomic_load_n(&profilingEnabled, __ATOMIC_RELAXED)) return (PROFILESCOPE){ 0, -1 };
+    if (__atomic_load_n(zone, __ATOMIC_ACQUIRE) < 0) __atomic_store_n(zone, RegisterProfileZone(name), __ATOMIC_RELEASE);
+    return (PROFILESCOPE){ ProfileTicks(), *zone };
+}
+
+static inline void EndProfileScope(PROFILESCOPE *scope) {
+    if (scope->zone >= 0) RecordProfileEvent(scope->zone, scope->start, ProfileTicks());
+}
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// Times the rest of the enclosing block, the zone is named once on first use
+#define PROFILE_SCOPE(name)                                                                  \
+    static int PROFILE_CONCAT(profileZone, __LINE__) = -1;                                  \
+    PROFILESCOPE PROFILE_CONCAT(profileScope, __LINE__) __attribute__((cleanup(EndProfileScope))) = \
+        BeginProfileScope(&PROFILE_CONCAT(profileZone, __LINE__), name)
+
+/*
+    Called once per frame by the thread that draws: the frame time goes into the history and
+    the zones that ended since the last call into the per-zone stats
+*/
+void EndProfileFrame(void);
+
+int GetProfileZones(PROFILEZONESTATS *zones, int capacity);
+
+// Frame times in milliseconds, oldest first, returns how many there are
+int GetProfileFrames(float *milliseconds, int capacity);
+
+/*
+    Everything still in the rings as Chrome trace-event JSON, for chrome://tracing or Perfetto
+*/
+bool WriteProfileTrace(const char *path);
+
+#endif // PROFILER_H
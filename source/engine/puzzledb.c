@@ -0,0 +1,115 @@
+#define _DEFAULT_SOURCE
+#include "puzzledb.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool OpenPuzzleDb(PUZZLEDB *db, const char *path) {
+    memset(db, 0, sizeof(*db));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(PUZZLEHEADER)) {
+        close(fd);
+        return false;
+    }
+
+    const unsigned char *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+    madvise((void *)mapped, info.st_size, MADV_RANDOM);
+
+    // The header, theme ranges and postings are checked, the puzzles themselves are only read when picked
+    const PUZZLEHEADER *header = (const PUZZLEHEADER *)mapped;
+    size_t size = (size_t)info.st_size;
+    size_t puzzlesEnd = sizeof(PUZZLEHEADER) + (size_t)header->puzzleCount * sizeof(PUZZLE);
+    bool valid = memcmp(header->magic, PUZZLE_MAGIC, 4) == 0 && header->puzzleSize == sizeof(PUZZLE) &&
+                 header->themeOffset >= puzzlesEnd && header->postingOffset >= header->themeOffset &&
+                 header->postingOffset <= size && header->postingOffset % sizeof(uint32_t) == 0 &&
+                 header->themeOffset % sizeof(uint32_t) == 0 &&
+                 (uint64_t)header->themeCount * sizeof(PUZZLETHEME) <= header->postingOffset - header->themeOffset;
+
+    if (valid) {
+        const PUZZLETHEME *themes = (const PUZZLETHEME *)(mapped + header->themeOffset);
+        const uint32_t *postings = (const uint32_t *)(mapped + header->postingOffset);
+        uint64_t postingCount = (size - header->postingOffset) / sizeof(uint32_t);
+
+        for (uint32_t i = 0; valid && i < header->themeCount; i++) {
+            valid = (uint64_t)themes[i].first + themes[i].count <= postingCount;
+        }
+        for (uint64_t i = 0; valid && i < postingCount; i++) {
+            valid = postings[i] < header->puzzleCount;
+        }
+    }
+    if (!valid) {
+        munmap((void *)mapped, info.st_size);
+        return false;
+    }
+
+    db->mapped = mapped;
+    db->mappedSize = info.st_size;
+    db->puzzles = (const PUZZLE *)(mapped + sizeof(PUZZLEHEADER));
+    db->puzzleCount = header->puzzleCount;
+    db->themes = (const PUZZLETHEME *)(mapped + header->themeOffset);
+    db->themeCount = header->themeCount;
+    db->postings = (const uint32_t *)(mapped + header->postingOffset);
+    return true;
+}
+
+void ClosePuzzleDb(PUZZLEDB *db) {
+    if (db->mapped) munmap((void *)db->mapped, db->mappedSize);
+    memset(db, 0, sizeof(*db));
+}
+
+int FindPuzzleTheme(const PUZZLEDB *db, const char *name) {
+    for (uint32_t i = 0; i < db->themeCount; i++) {
+        if (strncmp(db->themes[i].name, name, PUZZLE_THEME_NAME_SIZE) == 0) return (int)i;
+    }
+    return -1;
+}
+
+// Rating of the n-th puzzle of a theme list, or of the whole database when the list is NULL
+static uint16_t RatingAt(const PUZZLEDB *db, const uint32_t *list, uint32_t n) {
+    return db->puzzles[list ? list[n] : n].rating;
+}
+
+// First position in [0, count) whose rating is at least the given one
+static uint32_t LowerBound(const PUZZLEDB *db, const uint32_t *list, uint32_t count, int rating) {
+    uint32_t low = 0, high = count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if (RatingAt(db, list, middle) < rating) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+const PUZZLE *PickPuzzle(const PUZZLEDB *db, int minRating, int maxRating, int theme, uint64_t *rng) {
+    const uint32_t *list = NULL;
+    uint32_t count = db->puzzleCount;
+    if (theme >= 0 && (uint32_t)theme < db->themeCount) {
+        list = db->postings + db->themes[theme].first;
+        count = db->themes[theme].count;
+    }
+    if (count == 0) return NULL;
+
+    uint32_t first = LowerBound(db, list, count, minRating);
+    uint32_t last = LowerBound(db, list, count, maxRating + 1);
+
+    // Empty band: the nearest rating on either side of it
+    if (first >= last) {
+        if (first == count) first = count - 1;
+        else if (first > 0 && minRating - RatingAt(db, list, first - 1) < RatingAt(db, list, first) - maxRating) first--;
+        last = first + 1;
+    }
+
+    *rng ^= *rng << 13;
+    *rng ^= *rng >> 7;
+    *rng ^= *rng << 17;
+    uint32_t n = first + (uint32_t)(*rng % (last - first));
+    return &db->puzzles[list ? list[n] : n];
+}
@@ -0,0 +1,75 @@
+#ifndef PUZZLEDB_H
+#define PUZZLEDB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core/rules.h"
+
+#define PUZZLE_MAGIC "CPZ1"
+#define PUZZLE_MAX_MOVES 16
+#define PUZZLE_MAX_THEMES 8
+#define PUZZLE_NO_THEME 255
+#define PUZZLE_THEME_NAME_SIZE 24
+
+/*
+    One puzzle, ready to use without parsing: the position as packed squares, the moves
+    already in our encoding and the themes as ids into the theme table
+    moves[0] is the opponent's move that sets the puzzle up, the solver answers moves[1]
+*/
+typedef struct Puzzle {
+    char id[8];
+    PACKEDPOSITION position;
+    uint16_t rating;
+    uint8_t moveCount;
+    uint8_t themes[PUZZLE_MAX_THEMES];
+    uint8_t reserved[7];
+    MOVE moves[PUZZLE_MAX_MOVES];
+} PUZZLE;
+
+typedef struct PuzzleTheme {
+    char name[PUZZLE_THEME_NAME_SIZE];
+    uint32_t first;
+    uint32_t count;
+} PUZZLETHEME;
+
+/*
+    File layout, all native-endian:
+    header, puzzles sorted by rating, theme table, then for every theme the indices of its
+    puzzles in rating order, so a rating band is two binary searches under either index
+*/
+typedef struct PuzzleHeader {
+    char magic[4];
+    uint32_t puzzleSize;
+    uint32_t puzzleCount;
+    uint32_t themeCount;
+    uint64_t themeOffset;
+    uint64_t postingOffset;
+} PUZZLEHEADER;
+
+typedef struct PuzzleDatabase {
+    const unsigned char *mapped;
+    size_t mappedSize;
+    const PUZZLE *puzzles;
+    uint32_t puzzleCount;
+    const PUZZLETHEME *themes;
+    uint32_t themeCount;
+    const uint32_t *postings;
+} PUZZLEDB;
+
+/*
+    Maps the file read-only and refuses it if an offset, theme range or posting points outside
+    it, only the pages of the puzzles actually picked are ever read
+*/
+bool OpenPuzzleDb(PUZZLEDB *db, const char *path);
+void ClosePuzzleDb(PUZZLEDB *db);
+
+// Theme id by name, -1 if the database has no such theme
+int FindPuzzleTheme(const PUZZLEDB *db, const char *name);
+
+/*
+    Random puzzle with a rating in [minRating, maxRating], of one theme or any theme with -1
+    Falls back to the closest rating when the band is empty, NULL only for an empty database
+*/
+const PUZZLE *PickPuzzle(const PUZZLEDB *db, int minRating, int maxRating, int theme, uint64_t *rng);
+
+#endif // PUZZLEDB_H
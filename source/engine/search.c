@@ -0,0 +1,416 @@
+#define _POSIX_C_SOURCE 200809L
+#include "search.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "eval.h"
+#include "tablebase.h"
+#include "timer.h"
+#include "tt.h"
+
+// Game plies before the root plus plies inside the search
+#define MAX_KEYS (MAX_GAME_PLY + MAX_SEARCH_DEPTH + 1)
+
+// How often the clock and node budget are looked at
+#define CHECK_INTERVAL 2048
+
+// History scores stay below the killer and capture scores, the table is halved when one gets here
+#define HISTORY_MAX (1 << 20)
+
+/*
+    State every thread of one search sees: the stop flag the main thread raises once its
+    search is over, and the node count all threads add to at every limit check
+*/
+typedef struct SharedSearch {
+    bool helpersStop;
+    uint64_t nodes;
+} SHAREDSEARCH;
+
+typedef struct Searcher {
+    POSITION pos;
+    uint64_t keys[MAX_KEYS];
+    int keyCount;
+
+    SEARCHLIMITS limits;
+    double startTime;
+    double deadline;
+    uint64_t nodes;
+    bool stopped;
+    bool pondering;
+
+    SHAREDSEARCH *shared;
+
+    TTSTATS ttStats;
+
+    MOVE killers[MAX_SEARCH_DEPTH][2];
+    int history[12][64];
+    MOVE pv[MAX_SEARCH_DEPTH][MAX_SEARCH_DEPTH];
+    int pvLength[MAX_SEARCH_DEPTH];
+} SEARCHER;
+
+static void CheckLimits(SEARCHER *s) {
+    uint64_t totalNodes = __atomic_add_fetch(&s->shared->nodes, CHECK_INTERVAL, __ATOMIC_RELAXED);
+    if (s->limits.nodes && (s->nodes >= s->limits.nodes || totalNodes >= s->limits.nodes)) s->stopped = true;
+    if (s->pondering && !__atomic_load_n(s->limits.ponder, __ATOMIC_RELAXED)) {
+        // The predicted move was played, the clock for this move starts now
+        s->pondering = false;
+        s->deadline = NowSeconds() + s->limits.moveTimeMs / 1000.0;
+    }
+    if (s->limits.moveTimeMs && !s->pondering && NowSeconds() >= s->deadline) s->stopped = true;
+    if (s->limits.stop && __atomic_load_n(s->limits.stop, __ATOMIC_RELAXED)) s->stopped = true;
+    if (__atomic_load_n(&s->shared->helpersStop, __ATOMIC_RELAXED)) s->stopped = true;
+}
+
+// Any earlier occurrence since the last irreversible move counts as a draw inside the search
+static bool IsRepetition(const SEARCHER *s) {
+    int oldest = s->keyCount - s->pos.halfmoveClock;
+    for (int i = s->keyCount - 2; i >= 0 && i >= oldest; i -= 2) {
+        if (s->keys[i] == s->pos.hash) return true;
+    }
+    return false;
+}
+
+static void PlayMove(SEARCHER *s, MOVE move, UNDO *undo) {
+    s->keys[s->keyCount++] = s->pos.hash;
+    MakeMove(&s->pos, move, undo);
+}
+
+static void TakeBack(SEARCHER *s, const UNDO *undo) {
+    UnmakeMove(&s->pos, undo);
+    s->keyCount--;
+}
+
+// Mate scores are stored relative to the node so they stay valid when reached at another ply
+static int ScoreToTable(int score, int ply) {
+    if (score >= MATE_BOUND) return score + ply;
+    if (score <= -MATE_BOUND) return score - ply;
+    return score;
+}
+
+static int ScoreFromTable(int score, int ply) {
+    if (score >= MATE_BOUND) return score - ply;
+    if (score <= -MATE_BOUND) return score + ply;
+    return score;
+}
+
+/*
+    Move ordering: transposition table move, captures by most valuable victim and least
+    valuable attacker, promotions, killer moves, then quiet moves by history
+*/
+static int ScoreMove(const SEARCHER *s, MOVE move, MOVE ttMove, int ply) {
+    if (move == ttMove) return 1 << 30;
+
+    int attacker = PIECE_TYPE(s->pos.board[MOVE_FROM(move)]);
+    if (IS_CAPTURE(move)) {
+        int victim = (MOVE_FLAGS(move) == MOVE_EN_PASSANT) ? PAWN : PIECE_TYPE(s->pos.board[MOVE_TO(move)]);
+        return (1 << 24) + pieceValues[victim] * 16 - pieceValues[attacker] / 16;
+    }
+    if (IS_PROMOTION(move)) return (1 << 23) + pieceValues[PromotionPiece(move)];
+    if (move == s->killers[ply][0]) return (1 << 22);
+    if (move == s->killers[ply][1]) return (1 << 22) - 1;
+    return s->history[s->pos.board[MOVE_FROM(move)]][MOVE_TO(move)];
+}
+
+// Halving keeps the order between moves while old cutoffs count for less in a long search
+static void AddHistory(SEARCHER *s, MOVE move, int depth) {
+    int *entry = &s->history[s->pos.board[MOVE_FROM(move)]][MOVE_TO(move)];
+    *entry += depth * depth;
+    if (*entry < HISTORY_MAX) return;
+
+    for (int piece = 0; piece < 12; piece++) {
+        for (int square = 0; square < 64; square++) {
+            s->history[piece][square] /= 2;
+        }
+    }
+}
+
+static void ScoreMoves(const SEARCHER *s, const MOVELIST *list, int scores[], MOVE ttMove, int ply) {
+    for (int i = 0; i < list->count; i++) {
+        scores[i] = ScoreMove(s, list->moves[i], ttMove, ply);
+    }
+}
+
+// Selection sort one step at a time, most nodes cut off after the first few moves
+static MOVE PickMove(MOVELIST *list, int scores[], int index) {
+    int best = index;
+    for (int i = index + 1; i < list->count; i++) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    MOVE move = list->moves[best];
+    int score = scores[best];
+    list->moves[best] = list->moves[index];
+    scores[best] = scores[index];
+    list->moves[index] = move;
+    scores[index] = score;
+    return move;
+}
+
+static int Quiescence(SEARCHER *s, int alpha, int beta, int ply) {
+    if (++s->nodes % CHECK_INTERVAL == 0) CheckLimits(s);
+    if (s->stopped) return 0;
+
+    bool inCheck = IsInCheck(&s->pos, s->pos.sideToMove);
+    if (ply >= MAX_SEARCH_DEPTH - 1) return Evaluate(&s->pos);
+
+    // Standing pat is not an option while in check, every evasion is searched instead
+    if (!inCheck) {
+        int standPat = Evaluate(&s->pos);
+        if (standPat >= beta) return standPat;
+        if (standPat > alpha) alpha = standPat;
+    }
+
+    MOVELIST list;
+    int scores[MAX_MOVES];
+    GenerateLegalMoves(&s->pos, &list);
+    if (list.count == 0) return inCheck ? -MATE_SCORE + ply : 0;
+    ScoreMoves(s, &list, scores, MOVE_NONE, ply);
+
+    int bestScore = inCheck ? -INFINITE_SCORE : alpha;
+    for (int i = 0; i < list.count; i++) {
+        MOVE move = PickMove(&list, scores, i);
+        if (!inCheck && !IS_CAPTURE(move) && !IS_PROMOTION(move)) continue;
+
+        UNDO undo;
+        PlayMove(s, move, &undo);
+        int score = -Quiescence(s, -beta, -alpha, ply + 1);
+        TakeBack(s, &undo);
+
+        if (s->stopped) return 0;
+        if (score > bestScore) bestScore = score;
+        if (score > alpha) alpha = score;
+        if (score >= beta) break;
+    }
+    return bestScore;
+}
+
+static int Search(SEARCHER *s, int alpha, int beta, int depth, int ply) {
+    s->pvLength[ply] = ply;
+
+    if (ply > 0 && (s->pos.halfmoveClock >= 100 || IsRepetition(s))) return 0;
+
+    // Exact result once few enough pieces are left, the root still searches to pick a move
+    TBRESULT endgame;
+    if (ply > 0 && PopCount(Occupied(&s->pos)) <= TablebasePieceLimit() && ProbeTablebase(&s->pos, &endgame)) {
+        if (endgame.wdl > 0) return MATE_SCORE - ply - endgame.dtm;
+        if (endgame.wdl < 0) return -MATE_SCORE + ply + endgame.dtm;
+        return 0;
+    }
+
+    bool inCheck = IsInCheck(&s->pos, s->pos.sideToMove);
+    if (inCheck) depth++;
+    if (depth <= 0) return Quiescence(s, alpha, beta, ply);
+
+    if (++s->nodes % CHECK_INTERVAL == 0) CheckLimits(s);
+    if (s->stopped) return 0;
+    if (ply >= MAX_SEARCH_DEPTH - 1) return Evaluate(&s->pos);
+
+    // Cutoffs only outside the principal variation, which must come from a real search
+    bool pvNode = beta - alpha > 1;
+    MOVE ttMove = MOVE_NONE;
+    TTHIT hit;
+    if (ProbeTable(s->pos.hash, &hit, &s->ttStats)) {
+        ttMove = hit.move;
+        int score = ScoreFromTable(hit.score, ply);
+        if (!pvNode && ply > 0 && hit.depth >= depth) {
+            if (hit.bound == BOUND_EXACT) return score;
+            if (hit.bound == BOUND_LOWER && score >= beta) return score;
+            if (hit.bound == BOUND_UPPER && score <= alpha) return score;
+        }
+    }
+
+    MOVELIST list;
+    int scores[MAX_MOVES];
+    GenerateLegalMoves(&s->pos, &list);
+    if (list.count == 0) return inCheck ? -MATE_SCORE + ply : 0;
+    ScoreMoves(s, &list, scores, ttMove, ply);
+
+    int originalAlpha = alpha;
+    int bestScore = -INFINITE_SCORE;
+    MOVE bestMove = MOVE_NONE;
+    for (int i = 0; i < list.count; i++) {
+        MOVE move = PickMove(&list, scores, i);
+        UNDO undo;
+        int score;
+
+        PlayMove(s, move, &undo);
+        PrefetchTable(s->pos.hash);
+        if (i == 0) {
+            score = -Search(s, -beta, -alpha, depth - 1, ply + 1);
+        } else {
+            // Zero-window probe, searched again with the full window only if it beats alpha
+            score = -Search(s, -alpha - 1, -alpha, depth - 1, ply + 1);
+            if (score > alpha && score < beta) {
+                score = -Search(s, -beta, -alpha, depth - 1, ply + 1);
+            }
+        }
+        TakeBack(s, &undo);
+
+        if (s->stopped) return 0;
+        if (score <= bestScore) continue;
+
+        bestScore = score;
+        bestMove = move;
+        if (score <= alpha) continue;
+        alpha = score;
+
+        s->pv[ply][ply] = move;
+        for (int next = ply + 1; next < s->pvLength[ply + 1]; next++) {
+            s->pv[ply][next] = s->pv[ply + 1][next];
+        }
+        s->pvLength[ply] = s->pvLength[ply + 1];
+
+        if (score >= beta) {
+            if (!IS_CAPTURE(move) && !IS_PROMOTION(move)) {
+                if (s->killers[ply][0] != move) {
+                    s->killers[ply][1] = s->killers[ply][0];
+                    s->killers[ply][0] = move;
+                }
+                AddHistory(s, move, depth);
+            }
+            break;
+        }
+    }
+
+    BOUND bound = (bestScore >= beta) ? BOUND_LOWER : (bestScore > originalAlpha) ? BOUND_EXACT : BOUND_UPPER;
+    StoreTable(s->pos.hash, bestMove, ScoreToTable(bestScore, ply), depth, bound, &s->ttStats);
+    return bestScore;
+}
+
+static void InitSearcher(SEARCHER *s, const POSITION *root, const uint64_t *gameKeys, int gameKeyCount,
+                         const SEARCHLIMITS *limits, double startTime, SHAREDSEARCH *shared) {
+    s->pos = *root;
+    s->limits = *limits;
+    s->startTime = startTime;
+    s->deadline = startTime + limits->moveTimeMs / 1000.0;
+    s->nodes = 0;
+    s->stopped = false;
+    s->pondering = limits->ponder && __atomic_load_n(limits->ponder, __ATOMIC_RELAXED);
+    s->shared = shared;
+    s->ttStats = (TTSTATS){0};
+
+    // Only the most recent game positions can repeat, the rest are cut off by the halfmove clock
+    if (gameKeyCount > MAX_GAME_PLY) {
+        gameKeys += gameKeyCount - MAX_GAME_PLY;
+        gameKeyCount = MAX_GAME_PLY;
+    }
+    for (int i = 0; i < gameKeyCount; i++) {
+        s->keys[i] = gameKeys[i];
+    }
+    s->keyCount = gameKeyCount;
+
+    for (int ply = 0; ply < MAX_SEARCH_DEPTH; ply++) {
+        s->killers[ply][0] = s->killers[ply][1] = MOVE_NONE;
+    }
+    for (int piece = 0; piece < 12; piece++) {
+        for (int square = 0; square < 64; square++) {
+            s->history[piece][square] = 0;
+        }
+    }
+}
+
+static void IterativeDeepening(SEARCHER *s, int maxDepth, SEARCHRESULT *result) {
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        int score = Search(s, -INFINITE_SCORE, INFINITE_SCORE, depth, 0);
+        if (s->stopped) break;
+
+        result->bestMove = s->pv[0][0];
+        result->score = score;
+        result->depth = depth;
+        result->pvLength = s->pvLength[0];
+        for (int i = 0; i < s->pvLength[0]; i++) {
+            result->pv[i] = s->pv[0][i];
+        }
+
+        if (s->limits.onIteration) {
+            result->nodes = __atomic_load_n(&s->shared->nodes, __ATOMIC_RELAXED);
+            if (result->nodes < s->nodes) result->nodes = s->nodes;
+            result->seconds = NowSeconds() - s->startTime;
+            s->limits.onIteration(result, s->limits.context);
+        }
+
+        // A forced mate will not get shorter with more depth
+        if (score >= MATE_BOUND || score <= -MATE_BOUND) break;
+
+        // The next iteration takes several times longer than this one, do not start what cannot finish
+        if (s->limits.moveTimeMs && !s->pondering && s->deadline - NowSeconds() < s->limits.moveTimeMs / 2000.0) break;
+    }
+}
+
+typedef struct HelperThread {
+    pthread_t thread;
+    SEARCHER *searcher;
+    int index;
+} HELPERTHREAD;
+
+/*
+    Lazy SMP helper: the same root searched without a depth limit until the main thread is
+    done, odd helpers one ply deeper so the threads spread over different iterations
+    Their only output is what they leave in the shared transposition table
+*/
+static void *HelperMain(void *argument) {
+    HELPERTHREAD *helper = argument;
+    SEARCHER *s = helper->searcher;
+    int startDepth = 1 + (helper->index & 1);
+
+    for (int depth = startDepth; depth < MAX_SEARCH_DEPTH && !s->stopped; depth++) {
+        Search(s, -INFINITE_SCORE, INFINITE_SCORE, depth, 0);
+    }
+    return NULL;
+}
+
+int AvailableCores(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores < 1) ? 1 : (cores > MAX_SEARCH_THREADS) ? MAX_SEARCH_THREADS : (int)cores;
+}
+
+void SearchPosition(const POSITION *root, const uint64_t *gameKeys, int gameKeyCount,
+                    const SEARCHLIMITS *limits, SEARCHRESULT *result) {
+    double startTime = NowSeconds();
+    SHAREDSEARCH shared = { false, 0 };
+    NewTableGeneration();
+    int threadCount = (limits->threads < 1) ? 1 : (limits->threads > MAX_SEARCH_THREADS) ? MAX_SEARCH_THREADS : limits->threads;
+
+    // Too large for the stack of a worker thread, one allocation per search is noise
+    SEARCHER *s = malloc(sizeof(SEARCHER));
+    InitSearcher(s, root, gameKeys, gameKeyCount, limits, startTime, &shared);
+
+    // Always have a move to play, even if the first iteration is cut short
+    MOVELIST rootMoves;
+    GenerateLegalMoves(&s->pos, &rootMoves);
+    result->bestMove = rootMoves.count ? rootMoves.moves[0] : MOVE_NONE;
+    result->score = 0;
+    result->depth = 0;
+    result->pvLength = 0;
+
+    HELPERTHREAD helpers[MAX_SEARCH_THREADS];
+    int helperCount = 0;
+    if (rootMoves.count > 1) {
+        for (int i = 1; i < threadCount; i++) {
+            HELPERTHREAD *helper = &helpers[helperCount];
+            helper->searcher = malloc(sizeof(SEARCHER));
+            helper->index = i;
+            InitSearcher(helper->searcher, root, gameKeys, gameKeyCount, limits, startTime, &shared);
+            if (pthread_create(&helper->thread, NULL, HelperMain, helper) != 0) {
+                free(helper->searcher);
+                break;
+            }
+            helperCount++;
+        }
+    }
+
+    int maxDepth = (limits->depth > 0 && limits->depth < MAX_SEARCH_DEPTH) ? limits->depth : MAX_SEARCH_DEPTH - 1;
+    if (rootMoves.count > 0) IterativeDeepening(s, maxDepth, result);
+
+    __atomic_store_n(&shared.helpersStop, true, __ATOMIC_RELAXED);
+    result->nodes = s->nodes;
+    AddTableStats(&s->ttStats);
+    for (int i = 0; i < helperCount; i++) {
+        pthread_join(helpers[i].thread, NULL);
+        result->nodes += helpers[i].searcher->nodes;
+        AddTableStats(&helpers[i].searcher->ttStats);
+        free(helpers[i].searcher);
+    }
+
+    result->seconds = NowSeconds() - startTime;
+    free(s);
+}
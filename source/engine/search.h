@@ -0,0 +1,59 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "core/rules.h"
+
+#define MAX_SEARCH_DEPTH 64
+#define MAX_SEARCH_THREADS 64
+
+/*
+    Scores are centipawns for the side to move, mates are MATE_SCORE minus the distance in plies
+*/
+#define INFINITE_SCORE 32767
+#define MATE_SCORE 32000
+// Wide enough for a tablebase distance to mate on top of the search depth
+#define MATE_BOUND (MATE_SCORE - 512)
+
+typedef struct SearchResult {
+    MOVE bestMove;
+    int score;
+    int depth;
+    uint64_t nodes;
+    double seconds;
+    int pvLength;
+    MOVE pv[MAX_SEARCH_DEPTH];
+} SEARCHRESULT;
+
+/*
+    Budget for one search, zero means no limit on that axis
+*/
+typedef struct SearchLimits {
+    int depth;
+    uint64_t nodes;
+    int moveTimeMs;
+
+    // Lazy SMP, helper threads share work through the transposition table
+    int threads;
+
+    // Optional, another thread sets it to abort the search
+    const bool *stop;
+
+    // Optional, while set the search ponders without a clock, moveTimeMs starts once another thread clears it
+    const bool *ponder;
+
+    // Optional, called on the searching thread after every completed iteration
+    void (*onIteration)(const SEARCHRESULT *progress, void *context);
+    void *context;
+} SEARCHLIMITS;
+
+int AvailableCores(void);
+
+/*
+    Iterative deepening principal variation search from root
+    gameKeys holds the Zobrist keys of the positions played before root, for repetition draws
+    Safe to call from several threads at once, the transposition table is shared by all of them
+*/
+void SearchPosition(const POSITION *root, const uint64_t *gameKeys, int gameKeyCount,
+                    const SEARCHLIMITS *limits, SEARCHRESULT *result);
+
+#endif // SEARCH_H
@@ -0,0 +1,392 @@
+#define _POSIX_C_SOURCE 200809L
+#include "session.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SESSION_SLOT_BITS 24
+#define SESSION_SLOT_MASK ((1u << SESSION_SLOT_BITS) - 1)
+#define SESSION_NO_SLOT UINT32_MAX
+
+void InitSessionPool(SESSIONPOOL *pool) {
+    memset(pool, 0, sizeof(*pool));
+    pool->freeSlot = SESSION_NO_SLOT;
+}
+
+void FreeSessionPool(SESSIONPOOL *pool) {
+    for (uint32_t i = 0; i < pool->slabCount; i++) free(pool->slabs[i]);
+    for (uint32_t i = 0; i < pool->chunkSlabCount; i++) free(pool->chunkSlabs[i]);
+    free(pool->slabs);
+    free(pool->chunkSlabs);
+    InitSessionPool(pool);
+}
+
+uint32_t SessionSlotCount(const SESSIONPOOL *pool) {
+    return pool->slabCount * SESSION_SLAB_GAMES;
+}
+
+GAMESESSION *SessionAtSlot(const SESSIONPOOL *pool, uint32_t slot) {
+    return &pool->slabs[slot / SESSION_SLAB_GAMES][slot % SESSION_SLAB_GAMES];
+}
+
+// New slab threaded onto the free list in slot order, false when out of memory or ids
+static bool GrowSessions(SESSIONPOOL *pool) {
+    if (SessionSlotCount(pool) + SESSION_SLAB_GAMES > SESSION_SLOT_MASK) return false;
+
+    GAMESESSION **slabs = realloc(pool->slabs, (pool->slabCount + 1) * sizeof(*slabs));
+    if (!slabs) return false;
+    pool->slabs = slabs;
+
+    GAMESESSION *slab = calloc(SESSION_SLAB_GAMES, sizeof(*slab));
+    if (!slab) return false;
+    uint32_t base = SessionSlotCount(pool);
+    pool->slabs[pool->slabCount++] = slab;
+
+    for (uint32_t i = 0; i < SESSION_SLAB_GAMES; i++) {
+        slab[i].nextFree = (i + 1 < SESSION_SLAB_GAMES) ? base + i + 1 : pool->freeSlot;
+    }
+    pool->freeSlot = base;
+    return true;
+}
+
+static MOVECHUNK *TakeChunk(SESSIONPOOL *pool) {
+    if (!pool->freeChunks) {
+        MOVECHUNK **slabs = realloc(pool->chunkSlabs, (pool->chunkSlabCount + 1) * sizeof(*slabs));
+        if (!slabs) return NULL;
+        pool->chunkSlabs = slabs;
+
+        MOVECHUNK *slab = malloc(SESSION_SLAB_CHUNKS * sizeof(*slab));
+        if (!slab) return NULL;
+        pool->chunkSlabs[pool->chunkSlabCount++] = slab;
+        for (int i = 0; i < SESSION_SLAB_CHUNKS; i++) {
+            slab[i].next = (i + 1 < SESSION_SLAB_CHUNKS) ? &slab[i + 1] : NULL;
+        }
+        pool->freeChunks = slab;
+    }
+
+    MOVECHUNK *chunk = pool->freeChunks;
+    pool->freeChunks = chunk->next;
+    chunk->next = NULL;
+    pool->chunksInUse++;
+    return chunk;
+}
+
+static void ReleaseChunks(SESSIONPOOL *pool, GAMESESSION *session) {
+    if (!session->firstChunk) return;
+    for (MOVECHUNK *chunk = session->firstChunk; chunk; chunk = chunk->next) pool->chunksInUse--;
+    session->lastChunk->next = pool->freeChunks;
+    pool->freeChunks = session->firstChunk;
+    session->firstChunk = session->lastChunk = NULL;
+}
+
+uint32_t CreateSession(SESSIONPOOL *pool, uint32_t whitePlayer, uint32_t blackPlayer,
+                       uint32_t clockMs, uint32_t incrementMs, uint64_t nowMs) {
+    if (pool->freeSlot == SESSION_NO_SLOT && !GrowSessions(pool)) return SESSION_NONE;
+
+    uint32_t slot = pool->freeSlot;
+    GAMESESSION *session = SessionAtSlot(pool, slot);
+    pool->freeSlot = session->nextFree;
+
+    POSITION start;
+    SetStartingPosition(&start);
+    uint8_t generation = session->generation;
+    memset(session, 0, sizeof(*session));
+    PackPosition(&start, &session->position);
+    session->generation = generation;
+    session->slot = slot;
+    session->live = true;
+    session->players[COLOR_WHITE] = whitePlayer;
+    session->players[COLOR_BLACK] = blackPlayer;
+    session->clockMs[COLOR_WHITE] = session->clockMs[COLOR_BLACK] = clockMs;
+    session->incrementMs = incrementMs;
+    session->lastMoveMs = nowMs;
+    pool->liveCount++;
+    return SessionId(session);
+}
+
+GAMESESSION *FindSession(const SESSIONPOOL *pool, uint32_t id) {
+    uint32_t slot = (id & SESSION_SLOT_MASK) - 1;
+    if ((id & SESSION_SLOT_MASK) == 0 || slot >= SessionSlotCount(pool)) return NULL;
+
+    GAMESESSION *session = SessionAtSlot(pool, slot);
+    if (!session->live || session->generation != (id >> SESSION_SLOT_BITS)) return NULL;
+    return session;
+}
+
+uint32_t SessionId(const GAMESESSION *session) {
+    return ((uint32_t)session->generation << SESSION_SLOT_BITS) | (session->slot + 1);
+}
+
+void EndSession(SESSIONPOOL *pool, uint32_t id) {
+    GAMESESSION *session = FindSession(pool, id);
+    if (!session) return;
+
+    ReleaseChunks(pool, session);
+    session->live = false;
+    session->generation++;
+    session->nextFree = pool->freeSlot;
+    pool->freeSlot = session->slot;
+    pool->liveCount--;
+}
+
+static void FinishSession(GAMESESSION *session, SESSIONENDING ending, int winner) {
+    session->ending = ending;
+    session->result = (winner == COLOR_WHITE) ? SESSION_WHITE_WINS
+                    : (winner == COLOR_BLACK) ? SESSION_BLACK_WINS : SESSION_DRAWN;
+}
+
+static uint64_t StoredKey(const GAMESESSION *session, uint32_t ply) {
+    const MOVECHUNK *chunk = session->firstChunk;
+    for (uint32_t i = ply / SESSION_MOVES_PER_CHUNK; i > 0; i--) chunk = chunk->next;
+    return chunk->keys[ply % SESSION_MOVES_PER_CHUNK];
+}
+
+// Same reversible stretch as the board's check, keys[ply] being the key before move ply
+static bool IsSessionRepetition(const GAMESESSION *session, const POSITION *pos) {
+    uint64_t key = pos->hash;
+    int repetitions = 0;
+    for (int64_t ply = (int64_t)session->plyCount - 2;
+         ply >= 0 && ply >= (int64_t)session->plyCount - pos->halfmoveClock; ply -= 2) {
+        if (StoredKey(session, (uint32_t)ply) == key) repetitions++;
+    }
+    return repetitions >= 2;
+}
+
+static bool IsDeadPosition(const POSITION *pos) {
+    BITBOARD heavy = pos->byType[PAWN] | pos->byType[ROOK] | pos->byType[QUEEN];
+    return heavy == 0 && PopCount(Occupied(pos)) <= 3;
+}
+
+// A clock of zero is an untimed game
+bool CheckSessionClock(GAMESESSION *session, uint64_t nowMs) {
+    if (!session->live || session->result != SESSION_ONGOING) return false;
+
+    int mover = session->position.sideToMove;
+    uint64_t elapsed = nowMs > session->lastMoveMs ? nowMs - session->lastMoveMs : 0;
+    if (session->clockMs[mover] == 0 || elapsed < session->clockMs[mover]) return false;
+
+    session->clockMs[mover] = 0;
+    FinishSession(session, SESSION_TIMEOUT, !mover);
+    return true;
+}
+
+SESSIONMOVESTATUS PlaySessionMove(SESSIONPOOL *pool, GAMESESSION *session, uint32_t player,
+                                  const char *text, size_t length, uint64_t nowMs, char *played) {
+    if (!session || !session->live) return SESSION_MOVE_NO_GAME;
+    if (session->result != SESSION_ONGOING) return SESSION_MOVE_GAME_OVER;
+
+    int mover = session->position.sideToMove;
+    if (session->players[mover] != player) return SESSION_MOVE_NOT_YOUR_TURN;
+
+    if (CheckSessionClock(session, nowMs)) return SESSION_MOVE_GAME_OVER;
+    uint64_t elapsed = nowMs > session->lastMoveMs ? nowMs - session->lastMoveMs : 0;
+
+    POSITION pos;
+    UnpackPosition(&session->position, &pos);
+    MOVE move = ParseMove(&pos, text, length);
+    if (move == MOVE_NONE) return SESSION_MOVE_ILLEGAL;
+
+    if (session->plyCount >= MAX_GAME_PLY) return SESSION_MOVE_GAME_OVER;
+    uint32_t index = session->plyCount % SESSION_MOVES_PER_CHUNK;
+    if (index == 0) {
+        MOVECHUNK *chunk = TakeChunk(pool);
+        if (!chunk) return SESSION_MOVE_ILLEGAL;
+        if (session->lastChunk) session->lastChunk->next = chunk;
+        else session->firstChunk = chunk;
+        session->lastChunk = chunk;
+    }
+    session->lastChunk->moves[index] = move;
+    session->lastChunk->keys[index] = pos.hash;
+
+    UNDO undo;
+    MakeMove(&pos, move, &undo);
+    PackPosition(&pos, &session->position);
+    session->plyCount++;
+    if (session->clockMs[mover] > 0) {
+        session->clockMs[mover] -= (uint32_t)elapsed;
+        session->clockMs[mover] += session->incrementMs;
+    }
+    session->lastMoveMs = nowMs;
+    MoveToUci(move, played);
+
+    GAMESTATUS status = GetGameStatus(&pos);
+    if (status == GAME_CHECKMATE) {
+        FinishSession(session, SESSION_CHECKMATE, mover);
+    } else if (status == GAME_STALEMATE) {
+        FinishSession(session, SESSION_STALEMATE, -1);
+    } else if (IsDeadPosition(&pos)) {
+        FinishSession(session, SESSION_DEAD_POSITION, -1);
+    } else if (pos.halfmoveClock >= 100) {
+        FinishSession(session, SESSION_FIFTY_MOVES, -1);
+    } else if (IsSessionRepetition(session, &pos)) {
+        FinishSession(session, SESSION_REPETITION, -1);
+    } else if (session->plyCount == MAX_GAME_PLY) {
+        FinishSession(session, SESSION_MOVE_LIMIT, -1);
+    }
+    return SESSION_MOVE_OK;
+}
+
+// In a one-player game the side to move is the one resigning
+void ResignSession(GAMESESSION *session, uint32_t player) {
+    if (!session || !session->live || session->result != SESSION_ONGOING) return;
+
+    int loser = session->position.sideToMove;
+    if (session->players[loser] != player) loser = !loser;
+    if (session->players[loser] != player) return;
+    FinishSession(session, SESSION_RESIGNATION, !loser);
+}
+
+size_t SessionPoolBytes(const SESSIONPOOL *pool) {
+    return (size_t)pool->slabCount * SESSION_SLAB_GAMES * sizeof(GAMESESSION)
+         + (size_t)pool->chunkSlabCount * SESSION_SLAB_CHUNKS * sizeof(MOVECHUNK);
+}
+
+size_t SessionMoveBytes(const SESSIONPOOL *pool) {
+    return (size_t)pool->chunksInUse * sizeof(MOVECHUNK);
+}
+
+static unsigned char *PutBytes(unsigned char *out, uint64_t value, int count) {
+    for (int i = 0; i < count; i++) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+    return out + count;
+}
+
+static uint64_t GetBytes(const unsigned char *in, int count) {
+    uint64_t value = 0;
+    for (int i = count - 1; i >= 0; i--) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+static unsigned char *PutMove(unsigned char *out, const char *move) {
+    size_t length = strnlen(move, MOVE_TEXT_SIZE - 1);
+    out = PutBytes(out, length, 1);
+    memcpy(out, move, length);
+    return out + length;
+}
+
+static bool GetMove(const unsigned char *in, size_t remaining, char *move) {
+    if (remaining < 1) return false;
+    size_t length = in[0];
+    if (length >= MOVE_TEXT_SIZE || 1 + length != remaining) return false;
+    memcpy(move, in + 1, length);
+    move[length] = '\0';
+    return true;
+}
+
+size_t EncodeGameMessage(const GAMEMESSAGE *message, unsigned char *frame) {
+    unsigned char *out = frame + GAME_FRAME_HEADER;
+    out = PutBytes(out, message->type, 1);
+    switch (message->type) {
+        case GAME_MSG_NEW_GAME:
+            out = PutBytes(out, message->tag, 4);
+            out = PutBytes(out, message->clockMs, 4);
+            out = PutBytes(out, message->incrementMs, 4);
+            out = PutBytes(out, message->solo, 1);
+            break;
+        case GAME_MSG_JOIN:
+        case GAME_MSG_RESIGN:
+            out = PutBytes(out, message->game, 4);
+            break;
+        case GAME_MSG_MOVE:
+            out = PutBytes(out, message->game, 4);
+            out = PutMove(out, message->move);
+            break;
+        case GAME_MSG_CREATED:
+            out = PutBytes(out, message->tag, 4);
+            out = PutBytes(out, message->game, 4);
+            break;
+        case GAME_MSG_JOINED:
+            out = PutBytes(out, message->game, 4);
+            out = PutBytes(out, message->status, 1);
+            break;
+        case GAME_MSG_MOVED:
+            out = PutBytes(out, message->game, 4);
+            out = PutBytes(out, message->status, 1);
+            out = PutBytes(out, message->result, 1);
+            out = PutBytes(out, message->ending, 1);
+            out = PutBytes(out, message->ply, 4);
+            out = PutBytes(out, message->clocks[0], 4);
+            out = PutBytes(out, message->clocks[1], 4);
+            out = PutMove(out, message->move);
+            break;
+        case GAME_MSG_STATS_REPLY:
+            out = PutBytes(out, message->liveGames, 4);
+            out = PutBytes(out, message->movesPlayed, 8);
+            out = PutBytes(out, message->poolBytes, 8);
+            out = PutBytes(out, message->moveBytes, 8);
+            break;
+        default:
+            break;
+    }
+
+    size_t payload = (size_t)(out - frame) - GAME_FRAME_HEADER;
+    PutBytes(frame, payload, 4);
+    return (size_t)(out - frame);
+}
+
+bool DecodeGameMessage(const unsigned char *payload, size_t length, GAMEMESSAGE *message) {
+    if (length < 1) return false;
+    memset(message, 0, sizeof(*message));
+    message->type = payload[0];
+    const unsigned char *in = payload + 1;
+    length--;
+
+    switch (message->type) {
+        case GAME_MSG_NEW_GAME:
+            if (length != 13) return false;
+            message->tag = (uint32_t)GetBytes(in, 4);
+            message->clockMs = (uint32_t)GetBytes(in + 4, 4);
+            message->incrementMs = (uint32_t)GetBytes(in + 8, 4);
+            message->solo = in[12];
+            return true;
+        case GAME_MSG_JOIN:
+        case GAME_MSG_RESIGN:
+            if (length != 4) return false;
+            message->game = (uint32_t)GetBytes(in, 4);
+            return true;
+        case GAME_MSG_MOVE:
+            if (length < 4) return false;
+            message->game = (uint32_t)GetBytes(in, 4);
+            return GetMove(in + 4, length - 4, message->move);
+        case GAME_MSG_STATS:
+            return length == 0;
+        case GAME_MSG_CREATED:
+            if (length != 8) return false;
+            message->tag = (uint32_t)GetBytes(in, 4);
+            message->game = (uint32_t)GetBytes(in + 4, 4);
+            return true;
+        case GAME_MSG_JOINED:
+            if (length != 5) return false;
+            message->game = (uint32_t)GetBytes(in, 4);
+            message->status = in[4];
+            return true;
+        case GAME_MSG_MOVED:
+            if (length < 19) return false;
+            message->game = (uint32_t)GetBytes(in, 4);
+            message->status = in[4];
+            message->result = in[5];
+            message->ending = in[6];
+            message->ply = (uint32_t)GetBytes(in + 7, 4);
+            message->clocks[0] = (uint32_t)GetBytes(in + 11, 4);
+            message->clocks[1] = (uint32_t)GetBytes(in + 15, 4);
+            return GetMove(in + 19, length - 19, message->move);
+        case GAME_MSG_STATS_REPLY:
+            if (length != 28) return false;
+            message->liveGames = (uint32_t)GetBytes(in, 4);
+            message->movesPlayed = GetBytes(in + 4, 8);
+            message->poolBytes = GetBytes(in + 12, 8);
+            message->moveBytes = GetBytes(in + 20, 8);
+            return true;
+        default:
+            return false;
+    }
+}
+
+long GameFrameSize(const unsigned char *buffer, size_t used) {
+    if (used < GAME_FRAME_HEADER) return 0;
+    uint64_t payload = GetBytes(buffer, 4);
+    if (payload == 0 || payload > GAME_MAX_PAYLOAD) return -1;
+    return (used >= GAME_FRAME_HEADER + payload) ? (long)(GAME_FRAME_HEADER + payload) : 0;
+}
@@ -0,0 +1,176 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core/notation.h"
+#include "core/rules.h"
+
+#define GAME_SOCKET_PATH "/tmp/chess-games.sock"
+
+#define SESSION_NONE 0
+#define SESSION_SLAB_GAMES 4096
+#define SESSION_SLAB_CHUNKS 4096
+#define SESSION_MOVES_PER_CHUNK 12
+
+typedef enum SessionResult {
+    SESSION_ONGOING,
+    SESSION_WHITE_WINS,
+    SESSION_BLACK_WINS,
+    SESSION_DRAWN
+} SESSIONRESULT;
+
+typedef enum SessionEnding {
+    SESSION_NOT_OVER,
+    SESSION_CHECKMATE,
+    SESSION_STALEMATE,
+    SESSION_REPETITION,
+    SESSION_FIFTY_MOVES,
+    SESSION_DEAD_POSITION,
+    SESSION_TIMEOUT,
+    SESSION_RESIGNATION,
+    SESSION_MOVE_LIMIT
+} SESSIONENDING;
+
+typedef enum SessionMoveStatus {
+    SESSION_MOVE_OK,
+    SESSION_MOVE_ILLEGAL,
+    SESSION_MOVE_NOT_YOUR_TURN,
+    SESSION_MOVE_GAME_OVER,
+    SESSION_MOVE_NO_GAME
+} SESSIONMOVESTATUS;
+
+/*
+    Played moves in fixed 128-byte chunks from the pool, with the full position key before
+    each move so repetitions are found without replaying the game
+*/
+typedef struct MoveChunk {
+    struct MoveChunk *next;
+    MOVE moves[SESSION_MOVES_PER_CHUNK];
+    uint64_t keys[SESSION_MOVES_PER_CHUNK];
+} MOVECHUNK;
+
+/*
+    One hosted game: packed position, clocks and the move list, about a hundred bytes plus
+    one chunk per SESSION_MOVES_PER_CHUNK plies
+    players are opaque tokens of the two seats, the same token on both for a one-player game
+*/
+typedef struct GameSession {
+    PACKEDPOSITION position;
+    uint8_t result;
+    uint8_t ending;
+    uint8_t generation;
+    bool live;
+    uint32_t players[2];
+    uint32_t clockMs[2];
+    uint32_t incrementMs;
+    uint32_t plyCount;
+    uint64_t lastMoveMs;
+    MOVECHUNK *firstChunk;
+    MOVECHUNK *lastChunk;
+    uint32_t slot;
+    uint32_t nextFree;
+} GAMESESSION;
+
+/*
+    Sessions live in slabs of SESSION_SLAB_GAMES that are never moved or returned, so a
+    session pointer stays valid and a free slot is reused in O(1) through the free list
+    Ids are slot + 1 in the low 24 bits and the slot's generation above, a stale id finds nothing
+*/
+typedef struct SessionPool {
+    GAMESESSION **slabs;
+    uint32_t slabCount;
+    uint32_t freeSlot;
+    uint32_t liveCount;
+    MOVECHUNK *freeChunks;
+    MOVECHUNK **chunkSlabs;
+    uint32_t chunkSlabCount;
+    uint64_t chunksInUse;
+} SESSIONPOOL;
+
+void InitSessionPool(SESSIONPOOL *pool);
+void FreeSessionPool(SESSIONPOOL *pool);
+
+uint32_t CreateSession(SESSIONPOOL *pool, uint32_t whitePlayer, uint32_t blackPlayer,
+                       uint32_t clockMs, uint32_t incrementMs, uint64_t nowMs);
+GAMESESSION *FindSession(const SESSIONPOOL *pool, uint32_t id);
+uint32_t SessionId(const GAMESESSION *session);
+void EndSession(SESSIONPOOL *pool, uint32_t id);
+
+// Slots handed out so far, live or free, for walking every session
+uint32_t SessionSlotCount(const SESSIONPOOL *pool);
+GAMESESSION *SessionAtSlot(const SESSIONPOOL *pool, uint32_t slot);
+
+/*
+    Checks the mover's seat, the clock and the move (SAN or UCI) against the rules, plays it
+    and decides whether the game is over; played gets the move in UCI notation
+*/
+SESSIONMOVESTATUS PlaySessionMove(SESSIONPOOL *pool, GAMESESSION *session, uint32_t player,
+                                  const char *text, size_t length, uint64_t nowMs, char *played);
+void ResignSession(GAMESESSION *session, uint32_t player);
+
+// Ends the game on time if the side to move has run out, true when it just did
+bool CheckSessionClock(GAMESESSION *session, uint64_t nowMs);
+
+// Bytes held by the pool's slabs and by the chunks handed out
+size_t SessionPoolBytes(const SESSIONPOOL *pool);
+size_t SessionMoveBytes(const SESSIONPOOL *pool);
+
+/*
+    Wire format of the game server, u32 little-endian payload length then the payload,
+    the first payload byte is the message type and the rest depends on it:
+
+    client  NEW_GAME  tag u32, clock ms u32, increment ms u32, solo u8
+            JOIN      game u32
+            MOVE      game u32, move length u8, move
+            RESIGN    game u32
+            STATS
+    server  CREATED   tag u32, game u32
+            JOINED    game u32, status u8
+            MOVED     game u32, status u8, result u8, ending u8, ply u32, clocks 2 x u32, move length u8, move
+                      also sent to the opponent's connection when the move was played
+            STATS     live games u32, moves played u64, pool bytes u64, move bytes u64
+*/
+#define GAME_FRAME_HEADER 4
+#define GAME_MAX_PAYLOAD 64
+#define GAME_MAX_FRAME (GAME_FRAME_HEADER + GAME_MAX_PAYLOAD)
+
+typedef enum GameMessageType {
+    GAME_MSG_NEW_GAME = 1,
+    GAME_MSG_JOIN,
+    GAME_MSG_MOVE,
+    GAME_MSG_RESIGN,
+    GAME_MSG_STATS,
+    GAME_MSG_CREATED = 101,
+    GAME_MSG_JOINED,
+    GAME_MSG_MOVED,
+    GAME_MSG_STATS_REPLY
+} GAMEMESSAGETYPE;
+
+typedef struct GameMessage {
+    uint8_t type;
+    uint8_t solo;
+    uint8_t status;
+    uint8_t result;
+    uint8_t ending;
+    uint32_t tag;
+    uint32_t game;
+    uint32_t clockMs;
+    uint32_t incrementMs;
+    uint32_t ply;
+    uint32_t clocks[2];
+    uint32_t liveGames;
+    uint64_t movesPlayed;
+    uint64_t poolBytes;
+    uint64_t moveBytes;
+    char move[MOVE_TEXT_SIZE];
+} GAMEMESSAGE;
+
+// Whole frame including the length prefix, frame must hold GAME_MAX_FRAME bytes
+size_t EncodeGameMessage(const GAMEMESSAGE *message, unsigned char *frame);
+bool DecodeGameMessage(const unsigned char *payload, size_t length, GAMEMESSAGE *message);
+
+// 0 while the first frame is incomplete, -1 for a length no frame can have
+long GameFrameSize(const unsigned char *buffer, size_t used);
+
+#endif // SESSION_H
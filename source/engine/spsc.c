@@ -0,0 +1,45 @@
+#include "spsc.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool InitQueue(SPSCQUEUE *queue, size_t itemSize, uint32_t capacity) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) return false;
+
+    queue->slots = malloc(itemSize * capacity);
+    if (queue->slots == NULL) return false;
+
+    queue->itemSize = itemSize;
+    queue->mask = capacity - 1;
+    queue->head = 0;
+    queue->tail = 0;
+    return true;
+}
+
+void FreeQueue(SPSCQUEUE *queue) {
+    free(queue->slots);
+    queue->slots = NULL;
+}
+
+/*
+    head and tail run freely and wrap around, their difference is the number of items
+    The release store publishes the slot contents before the index that hands them over
+*/
+bool QueuePush(SPSCQUEUE *queue, const void *item) {
+    uint32_t tail = queue->tail;
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+    if (tail - head > queue->mask) return false;
+
+    memcpy(queue->slots + (size_t)(tail & queue->mask) * queue->itemSize, item, queue->itemSize);
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool QueuePop(SPSCQUEUE *queue, void *item) {
+    uint32_t head = queue->head;
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    if (head == tail) return false;
+
+    memcpy(item, queue->slots + (size_t)(head & queue->mask) * queue->itemSize, queue->itemSize);
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
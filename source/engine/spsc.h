@@ -0,0 +1,36 @@
+#ifndef SPSC_H
+#define SPSC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define CACHE_LINE 64
+
+/*
+    Lock-free ring buffer for exactly one producer thread and one consumer thread
+    Items are copied in and out by value, capacity must be a power of two
+*/
+typedef struct SpscQueue {
+    unsigned char *slots;
+    size_t itemSize;
+    uint32_t mask;
+
+    // head belongs to the consumer and tail to the producer, each on its own cache line
+    char padHead[CACHE_LINE];
+    uint32_t head;
+    char padTail[CACHE_LINE];
+    uint32_t tail;
+    char padEnd[CACHE_LINE];
+} SPSCQUEUE;
+
+bool InitQueue(SPSCQUEUE *queue, size_t itemSize, uint32_t capacity);
+void FreeQueue(SPSCQUEUE *queue);
+
+// Producer side, false when the queue is full
+bool QueuePush(SPSCQUEUE *queue, const void *item);
+
+// Consumer side, false when the queue is empty
+bool QueuePop(SPSCQUEUE *queue, void *item);
+
+#endif // SPSC_H
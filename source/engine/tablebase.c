@@ -0,0 +1,359 @@
+#define _DEFAULT_SOURCE
+#include "tablebase.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TB_MAGIC "CTB1"
+#define MAX_TABLES 16
+
+static const char materialLetters[] = "QRBNP";
+static const PIECETYPE materialTypes[] = { QUEEN, ROOK, BISHOP, KNIGHT, PAWN };
+
+typedef struct TableHeader {
+    char magic[4];
+    char name[8];
+    uint32_t blockEntries;
+    uint64_t entryCount;
+    uint64_t blockCount;
+} TBHEADER;
+
+typedef struct LoadedTable {
+    TBMATERIAL material;
+    const unsigned char *mapped;
+    size_t mappedSize;
+    const uint32_t *offsets;
+    const unsigned char *data;
+} LOADEDTABLE;
+
+static LOADEDTABLE tables[MAX_TABLES];
+static int tableCount = 0;
+static int pieceLimit = 0;
+
+bool ParseTablebaseMaterial(const char *name, TBMATERIAL *material) {
+    size_t length = strlen(name);
+    if (length < 3 || length > 2 + TB_MAX_EXTRA || name[0] != 'K' || name[length - 1] != 'K') return false;
+
+    memset(material, 0, sizeof(*material));
+    memcpy(material->name, name, length);
+
+    // Letters in Q R B N P order and no piece twice, so every material set has one name
+    int lastOrder = -1;
+    for (size_t i = 1; i + 1 < length; i++) {
+        const char *letter = strchr(materialLetters, name[i]);
+        if (letter == NULL || letter - materialLetters <= lastOrder) return false;
+        lastOrder = (int)(letter - materialLetters);
+        material->extra[material->extraCount++] = materialTypes[lastOrder];
+        if (materialTypes[lastOrder] == PAWN) material->hasPawns = true;
+    }
+
+    material->kingSlots = material->hasPawns ? 32 : 16;
+    material->entryCount = 2ULL * material->kingSlots * 64;
+    for (int i = 0; i < material->extraCount; i++) material->entryCount *= 64;
+    return true;
+}
+
+uint64_t TablebaseIndex(const TBMATERIAL *material, int side, const int squares[]) {
+    int flip = 0;
+    if (FILE_OF(squares[0]) > 3) flip ^= 7;
+    if (!material->hasPawns && RANK_OF(squares[0]) > 3) flip ^= 56;
+
+    int strongKing = squares[0] ^ flip;
+    uint64_t index = (uint64_t)side * material->kingSlots + RANK_OF(strongKing) * 4 + FILE_OF(strongKing);
+    index = index * 64 + (squares[1] ^ flip);
+    for (int i = 0; i < material->extraCount; i++) {
+        index = index * 64 + (squares[2 + i] ^ flip);
+    }
+    return index;
+}
+
+void TablebaseDecode(const TBMATERIAL *material, uint64_t index, int *side, int squares[]) {
+    for (int i = material->extraCount - 1; i >= 0; i--) {
+        squares[2 + i] = (int)(index % 64);
+        index /= 64;
+    }
+    squares[1] = (int)(index % 64);
+    index /= 64;
+
+    int slot = (int)(index % material->kingSlots);
+    squares[0] = SQUARE(slot / 4, slot % 4);
+    *side = (int)(index / material->kingSlots);
+}
+
+// Control byte below 128: that many plus one literal bytes follow, otherwise the next byte repeats c - 126 times
+static size_t CompressBlock(const uint8_t *values, size_t count, unsigned char *out) {
+    size_t used = 0;
+    size_t i = 0;
+
+    while (i < count) {
+        size_t run = 1;
+        while (i + run < count && run < 129 && values[i + run] == values[i]) run++;
+
+        if (run >= 2) {
+            out[used++] = (unsigned char)(run + 126);
+            out[used++] = values[i];
+            i += run;
+            continue;
+        }
+
+        size_t literal = 1;
+        while (i + literal < count && literal < 128 &&
+               !(i + literal + 1 < count && values[i + literal] == values[i + literal + 1])) {
+            literal++;
+        }
+        out[used++] = (unsigned char)(literal - 1);
+        memcpy(out + used, values + i, literal);
+        used += literal;
+        i += literal;
+    }
+    return used;
+}
+
+static uint8_t DecodeEntry(const unsigned char *block, size_t blockSize, size_t position) {
+    size_t used = 0;
+    size_t entry = 0;
+
+    while (used < blockSize) {
+        unsigned char control = block[used++];
+        if (control < 128) {
+            size_t literal = (size_t)control + 1;
+            if (position < entry + literal) return block[used + position - entry];
+            entry += literal;
+            used += literal;
+        } else {
+            size_t run = (size_t)control - 126;
+            if (position < entry + run) return block[used];
+            entry += run;
+            used++;
+        }
+    }
+    return TB_DRAW;
+}
+
+bool WriteTablebase(const char *path, const TBMATERIAL *material, const uint8_t *values, size_t *bytesWritten) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) return false;
+
+    TBHEADER header = { { 0 }, { 0 }, TB_BLOCK_ENTRIES, material->entryCount, 0 };
+    memcpy(header.magic, TB_MAGIC, 4);
+    memcpy(header.name, material->name, sizeof(header.name));
+    header.blockCount = (material->entryCount + TB_BLOCK_ENTRIES - 1) / TB_BLOCK_ENTRIES;
+
+    // Offsets go in front, they are only known once every block is compressed
+    long offsetsStart = (long)sizeof(header);
+    long dataStart = offsetsStart + (long)((header.blockCount + 1) * sizeof(uint32_t));
+    fwrite(&header, sizeof(header), 1, file);
+    fseek(file, dataStart, SEEK_SET);
+
+    unsigned char compressed[TB_BLOCK_ENTRIES * 2];
+    uint32_t offset = 0;
+    uint32_t *offsets = calloc(header.blockCount + 1, sizeof(uint32_t));
+    if (offsets == NULL) {
+        fclose(file);
+        return false;
+    }
+    for (uint64_t block = 0; block < header.blockCount; block++) {
+        uint64_t first = block * TB_BLOCK_ENTRIES;
+        size_t count = (size_t)((material->entryCount - first < TB_BLOCK_ENTRIES) ? material->entryCount - first : TB_BLOCK_ENTRIES);
+        size_t size = CompressBlock(values + first, count, compressed);
+        fwrite(compressed, 1, size, file);
+        offsets[block] = offset;
+        offset += (uint32_t)size;
+    }
+    offsets[header.blockCount] = offset;
+
+    fseek(file, offsetsStart, SEEK_SET);
+    fwrite(offsets, sizeof(uint32_t), header.blockCount + 1, file);
+    free(offsets);
+
+    bool ok = ferror(file) == 0;
+    if (fclose(file) != 0) ok = false;
+    if (bytesWritten) *bytesWritten = (size_t)dataStart + offset;
+    return ok;
+}
+
+static bool MapTable(const char *path, LOADEDTABLE *table) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(TBHEADER)) {
+        close(fd);
+        return false;
+    }
+    const unsigned char *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return false;
+
+    TBHEADER header;
+    memcpy(&header, mapped, sizeof(header));
+    char name[sizeof(header.name) + 1] = { 0 };
+    memcpy(name, header.name, sizeof(header.name));
+
+    if (memcmp(header.magic, TB_MAGIC, 4) != 0 || header.blockEntries != TB_BLOCK_ENTRIES ||
+        !ParseTablebaseMaterial(name, &table->material) || header.entryCount != table->material.entryCount ||
+        header.blockCount != (header.entryCount + TB_BLOCK_ENTRIES - 1) / TB_BLOCK_ENTRIES ||
+        sizeof(header) + (header.blockCount + 1) * sizeof(uint32_t) > (size_t)info.st_size) {
+        munmap((void *)mapped, info.st_size);
+        return false;
+    }
+
+    // Blocks follow one another and the last one ends inside the file, so no probe reads past it
+    const uint32_t *offsets = (const uint32_t *)(mapped + sizeof(header));
+    size_t dataStart = sizeof(header) + (header.blockCount + 1) * sizeof(uint32_t);
+    bool inside = offsets[0] == 0 && dataStart + offsets[header.blockCount] <= (size_t)info.st_size;
+    for (uint64_t block = 0; inside && block < header.blockCount; block++) {
+        inside = offsets[block] <= offsets[block + 1];
+    }
+    if (!inside) {
+        munmap((void *)mapped, info.st_size);
+        return false;
+    }
+
+    table->mapped = mapped;
+    table->mappedSize = info.st_size;
+    table->offsets = offsets;
+    table->data = mapped + dataStart;
+    return true;
+}
+
+int LoadTablebases(const char *directory) {
+    UnloadTablebases();
+
+    DIR *dir = opendir(directory);
+    if (dir == NULL) return 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && tableCount < MAX_TABLES) {
+        size_t length = strlen(entry->d_name);
+        if (length < 4 || strcmp(entry->d_name + length - 3, ".tb") != 0) continue;
+
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        if (!MapTable(path, &tables[tableCount])) continue;
+
+        int pieces = 2 + tables[tableCount].material.extraCount;
+        if (pieces > pieceLimit) pieceLimit = pieces;
+        tableCount++;
+    }
+    closedir(dir);
+    return tableCount;
+}
+
+void UnloadTablebases(void) {
+    for (int i = 0; i < tableCount; i++) {
+        munmap((void *)tables[i].mapped, tables[i].mappedSize);
+    }
+    tableCount = 0;
+    pieceLimit = 0;
+}
+
+int TablebasePieceLimit(void) {
+    return pieceLimit;
+}
+
+static uint8_t ReadValue(const LOADEDTABLE *table, uint64_t index) {
+    uint64_t block = index / TB_BLOCK_ENTRIES;
+    return DecodeEntry(table->data + table->offsets[block], table->offsets[block + 1] - table->offsets[block],
+                       (size_t)(index % TB_BLOCK_ENTRIES));
+}
+
+bool DescribeTablebasePosition(const POSITION *pos, char *name, int *side, int squares[]) {
+    int total = PopCount(Occupied(pos));
+    if (total < 3 || total > 2 + TB_MAX_EXTRA || pos->castlingRights != 0) return false;
+
+    // The side with more than its king is the strong side, the other must have the king alone
+    int strong = (PopCount(pos->byColor[COLOR_WHITE]) > 1) ? COLOR_WHITE : COLOR_BLACK;
+    if (PopCount(pos->byColor[!strong]) != 1) return false;
+
+    // Name the material the way the tables are named, Q R B N P order
+    int length = 0, extras = 0;
+    name[length++] = 'K';
+    for (int i = 0; i < 5; i++) {
+        int piece = PIECE_CODE(strong, materialTypes[i]);
+        if (pos->pieceCount[piece] == 0) continue;
+        if (pos->pieceCount[piece] > 1) return false;
+        name[length++] = materialLetters[i];
+        squares[2 + extras++] = pos->pieceList[piece][0];
+    }
+    name[length++] = 'K';
+    name[length] = '\0';
+
+    squares[0] = pos->kingSquare[strong];
+    squares[1] = pos->kingSquare[!strong];
+
+    // Black as the strong side is the same table seen from the other end of the board
+    *side = pos->sideToMove;
+    if (strong == COLOR_BLACK) {
+        for (int i = 0; i < 2 + extras; i++) squares[i] ^= 56;
+        *side = !*side;
+    }
+    return true;
+}
+
+bool ProbeTablebase(const POSITION *pos, TBRESULT *result) {
+    char name[8];
+    int side;
+    int squares[2 + TB_MAX_EXTRA];
+    if (PopCount(Occupied(pos)) > pieceLimit || !DescribeTablebasePosition(pos, name, &side, squares)) return false;
+
+    const LOADEDTABLE *table = NULL;
+    for (int i = 0; i < tableCount; i++) {
+        if (strcmp(tables[i].material.name, name) == 0) table = &tables[i];
+    }
+    if (table == NULL) return false;
+
+    uint8_t value = ReadValue(table, TablebaseIndex(&table->material, side, squares));
+    if (value == TB_DRAW) {
+        result->wdl = 0;
+        result->dtm = 0;
+    } else {
+        result->dtm = value - 1;
+        result->wdl = (result->dtm & 1) ? 1 : -1;
+    }
+    return true;
+}
+
+// Children are scored from the mover's side: quick wins first, then draws, then slow losses
+static int MoveRank(const TBRESULT *child) {
+    if (child->wdl < 0) return 1000 - child->dtm;
+    if (child->wdl == 0) return 0;
+    return -1000 + child->dtm;
+}
+
+MOVE TablebaseBestMove(POSITION *pos, TBRESULT *result) {
+    if (!ProbeTablebase(pos, result)) return MOVE_NONE;
+
+    MOVELIST list;
+    GenerateLegalMoves(pos, &list);
+
+    MOVE best = MOVE_NONE;
+    int bestRank = -100000;
+    for (int i = 0; i < list.count; i++) {
+        UNDO undo;
+        TBRESULT child;
+        MakeMove(pos, list.moves[i], &undo);
+
+        // Out of the tables means a capture into a dead draw, or a position we cannot rate
+        bool known = ProbeTablebase(pos, &child);
+        if (!known) {
+            child.wdl = 0;
+            child.dtm = 0;
+            known = PopCount(Occupied(pos)) <= 3 && !(pos->byType[PAWN] | pos->byType[ROOK] | pos->byType[QUEEN]);
+        }
+        UnmakeMove(pos, &undo);
+
+        if (!known) continue;
+        int rank = MoveRank(&child);
+        if (rank > bestRank) {
+            bestRank = rank;
+            best = list.moves[i];
+        }
+    }
+    return best;
+}
@@ -0,0 +1,66 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "core/rules.h"
+
+#define TB_MAX_EXTRA 2
+#define TB_BLOCK_ENTRIES 1024
+#define TB_DEFAULT_DIRECTORY "tablebases"
+
+/*
+    A material set of king and up to two other pieces against a lone king, named as in
+    "KQK" or "KBNK" with the strong side's pieces in Q R B N P order
+    Tables are built with the strong side as White, the prober mirrors the board for Black
+*/
+typedef struct TablebaseMaterial {
+    char name[8];
+    int extraCount;
+    PIECETYPE extra[TB_MAX_EXTRA];
+    bool hasPawns;
+    int kingSlots;
+    uint64_t entryCount;
+} TBMATERIAL;
+
+bool ParseTablebaseMaterial(const char *name, TBMATERIAL *material);
+
+/*
+    Compact index: side to move, strong king folded into one half of the board (one quarter
+    without pawns) by mirroring, then weak king and each extra piece on any square
+    squares[] is strong king, weak king, extras, in the strong-side-is-White orientation
+*/
+uint64_t TablebaseIndex(const TBMATERIAL *material, int side, const int squares[]);
+void TablebaseDecode(const TBMATERIAL *material, uint64_t index, int *side, int squares[]);
+
+// Material name, side to move and squares of a position as the tables see it, false if no table could hold it
+bool DescribeTablebasePosition(const POSITION *pos, char *name, int *side, int squares[]);
+
+/*
+    One byte per position, 0 is a draw, otherwise distance to mate in plies plus one
+    An odd distance is a win for the side to move, an even one a loss
+*/
+#define TB_DRAW 0
+
+/*
+    On disk: header, block offsets, then blocks of TB_BLOCK_ENTRIES bytes each compressed with
+    a literal/repeat run-length code, so one probe decodes at most one small block
+*/
+bool WriteTablebase(const char *path, const TBMATERIAL *material, const uint8_t *values, size_t *bytesWritten);
+
+typedef struct TablebaseResult {
+    int wdl;  // 1 win, 0 draw, -1 loss for the side to move
+    int dtm;  // plies to mate, 0 for draws
+} TBRESULT;
+
+// Maps every table found in the directory, returns how many were loaded
+int LoadTablebases(const char *directory);
+void UnloadTablebases(void);
+int TablebasePieceLimit(void);
+
+bool ProbeTablebase(const POSITION *pos, TBRESULT *result);
+
+// Fastest win, slowest loss, or any move that holds the draw, MOVE_NONE if not in the tables
+MOVE TablebaseBestMove(POSITION *pos, TBRESULT *result);
+
+#endif // TABLEBASE_H
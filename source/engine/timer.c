@@ -0,0 +1,10 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "timer.h"
+#include <time.h>
+
+double NowSeconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
@@ -0,0 +1,9 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+/*
+    Monotonic wall clock in seconds, for time budgets and nodes/second reports
+*/
+double NowSeconds(void);
+
+#endif // TIMER_H
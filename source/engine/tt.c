@@ -0,0 +1,211 @@
+#define _DEFAULT_SOURCE
+#include "tt.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define GENERATION_MASK 63
+#define FILL_SAMPLE_BUCKETS 250
+
+static TTBUCKET *buckets = NULL;
+static uint64_t bucketCount = 0;
+static size_t mappedSize = 0;
+static bool hugePages = false;
+static uint8_t generation = 0;
+static TTSTATS totals;
+
+// data layout: move bits 0-15, score bits 16-31, depth bits 32-39, bound bits 40-41, generation bits 42-47
+static uint64_t PackData(MOVE move, int score, int depth, BOUND bound) {
+    return (uint64_t)move | (uint64_t)(uint16_t)(int16_t)score << 16 |
+           (uint64_t)(uint8_t)depth << 32 | (uint64_t)bound << 40 |
+           (uint64_t)__atomic_load_n(&generation, __ATOMIC_RELAXED) << 42;
+}
+
+static void UnpackData(uint64_t data, TTHIT *hit) {
+    hit->move = (MOVE)(data & 0xFFFF);
+    hit->score = (int16_t)(data >> 16);
+    hit->depth = (uint8_t)(data >> 32);
+    hit->bound = (BOUND)((data >> 40) & 3);
+}
+
+static int EntryDepth(uint64_t data) {
+    return (uint8_t)(data >> 32);
+}
+
+static int EntryAge(uint64_t data) {
+    return (__atomic_load_n(&generation, __ATOMIC_RELAXED) - (int)(data >> 42)) & GENERATION_MASK;
+}
+
+/*
+    Map the table aligned to a huge page and ask for transparent huge pages, with gigabytes
+    of table nearly every probe is a TLB miss on 4 KB pages
+    The mapping is kept on normal pages if the kernel refuses the advice
+*/
+static void *MapTable(size_t size) {
+    size_t mapped = size + HUGE_PAGE_SIZE;
+    unsigned char *base = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return NULL;
+
+    // Trim the slack on both sides so the table starts on a huge page boundary
+    uintptr_t start = ((uintptr_t)base + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    size_t before = start - (uintptr_t)base;
+    if (before > 0) munmap(base, before);
+    munmap((unsigned char *)start + size, mapped - before - size);
+
+#ifdef MADV_HUGEPAGE
+    hugePages = madvise((void *)start, size, MADV_HUGEPAGE) == 0;
+#endif
+    mappedSize = size;
+    return (void *)start;
+}
+
+bool ResizeTable(int megabytes) {
+    FreeTable();
+    if (megabytes < 1) megabytes = 1;
+
+    size_t size = (size_t)megabytes * 1024 * 1024;
+    bucketCount = size / sizeof(TTBUCKET);
+
+    // Fresh anonymous pages are already zero, only the fallback needs clearing
+    buckets = (size >= HUGE_PAGE_SIZE) ? MapTable(size) : NULL;
+    if (buckets == NULL) {
+        void *memory = NULL;
+        if (posix_memalign(&memory, sizeof(TTBUCKET), size) != 0) {
+            bucketCount = 0;
+            return false;
+        }
+        buckets = memory;
+        ClearTable();
+    }
+    ResetTableStats();
+    return true;
+}
+
+void ClearTable(void) {
+    if (buckets) memset(buckets, 0, bucketCount * sizeof(TTBUCKET));
+    generation = 0;
+}
+
+void FreeTable(void) {
+    if (mappedSize) {
+        munmap(buckets, mappedSize);
+    } else {
+        free(buckets);
+    }
+    buckets = NULL;
+    bucketCount = 0;
+    mappedSize = 0;
+    hugePages = false;
+}
+
+bool TableUsesHugePages(void) {
+    return hugePages;
+}
+
+void NewTableGeneration(void) {
+    uint8_t next = (__atomic_load_n(&generation, __ATOMIC_RELAXED) + 1) & GENERATION_MASK;
+    __atomic_store_n(&generation, next, __ATOMIC_RELAXED);
+}
+
+// Bucket from the high bits of the key, any table size without a division
+static TTBUCKET *BucketFor(uint64_t key) {
+    return &buckets[(uint64_t)(((unsigned __int128)key * bucketCount) >> 64)];
+}
+
+void PrefetchTable(uint64_t key) {
+    if (buckets) __builtin_prefetch(BucketFor(key));
+}
+
+/*
+    Words are read and written with relaxed atomics: no ordering is needed between
+    threads, only the XOR check decides whether the pair belongs together
+*/
+bool ProbeTable(uint64_t key, TTHIT *hit, TTSTATS *stats) {
+    if (buckets == NULL) return false;
+
+    stats->probes++;
+    TTBUCKET *bucket = BucketFor(key);
+    for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+        uint64_t check = __atomic_load_n(&bucket->entries[i].check, __ATOMIC_RELAXED);
+        uint64_t data = __atomic_load_n(&bucket->entries[i].data, __ATOMIC_RELAXED);
+        if (data != 0 && (check ^ data) == key) {
+            UnpackData(data, hit);
+            stats->hits++;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+    Same position first, then an empty slot, otherwise the entry worth least: shallow
+    searches lose to deep ones, and every search generation of age costs 8 plies of depth
+*/
+void StoreTable(uint64_t key, MOVE move, int score, int depth, BOUND bound, TTSTATS *stats) {
+    if (buckets == NULL) return;
+
+    TTBUCKET *bucket = BucketFor(key);
+    TTENTRY *replace = NULL;
+    int replaceValue = INT32_MAX;
+    bool evicts = false;
+
+    for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+        TTENTRY *entry = &bucket->entries[i];
+        uint64_t data = __atomic_load_n(&entry->data, __ATOMIC_RELAXED);
+        uint64_t check = __atomic_load_n(&entry->check, __ATOMIC_RELAXED);
+
+        if (data == 0 || (check ^ data) == key) {
+            // Keep the known best move when this search found none
+            if (data != 0 && move == MOVE_NONE) move = (MOVE)(data & 0xFFFF);
+            replace = entry;
+            evicts = false;
+            break;
+        }
+        int value = EntryDepth(data) - 8 * EntryAge(data);
+        if (value < replaceValue) {
+            replace = entry;
+            replaceValue = value;
+            evicts = true;
+        }
+    }
+
+    stats->stores++;
+    if (evicts) stats->collisions++;
+
+    uint64_t data = PackData(move, score, depth, bound);
+    __atomic_store_n(&replace->check, key ^ data, __ATOMIC_RELAXED);
+    __atomic_store_n(&replace->data, data, __ATOMIC_RELAXED);
+}
+
+void AddTableStats(const TTSTATS *stats) {
+    __atomic_fetch_add(&totals.probes, stats->probes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&totals.hits, stats->hits, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&totals.stores, stats->stores, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&totals.collisions, stats->collisions, __ATOMIC_RELAXED);
+}
+
+void GetTableStats(TTSTATS *stats) {
+    stats->probes = __atomic_load_n(&totals.probes, __ATOMIC_RELAXED);
+    stats->hits = __atomic_load_n(&totals.hits, __ATOMIC_RELAXED);
+    stats->stores = __atomic_load_n(&totals.stores, __ATOMIC_RELAXED);
+    stats->collisions = __atomic_load_n(&totals.collisions, __ATOMIC_RELAXED);
+}
+
+void ResetTableStats(void) {
+    memset(&totals, 0, sizeof(totals));
+}
+
+int TableFillPermille(void) {
+    uint64_t sample = (bucketCount < FILL_SAMPLE_BUCKETS) ? bucketCount : FILL_SAMPLE_BUCKETS;
+    if (sample == 0) return 0;
+
+    uint64_t used = 0;
+    for (uint64_t i = 0; i < sample; i++) {
+        for (int j = 0; j < TT_BUCKET_ENTRIES; j++) {
+            uint64_t data = __atomic_load_n(&buckets[i].entries[j].data, __ATOMIC_RELAXED);
+            if (data != 0 && EntryAge(data) == 0) used++;
+        }
+    }
+    return (int)(used * 1000 / (sample * TT_BUCKET_ENTRIES));
+}
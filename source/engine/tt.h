@@ -0,0 +1,73 @@
+#ifndef TT_H
+#define TT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "core/move.h"
+
+#define TT_DEFAULT_MB 16
+#define TT_BUCKET_ENTRIES 4
+
+typedef enum BoundType {
+    BOUND_NONE,
+    BOUND_UPPER,
+    BOUND_LOWER,
+    BOUND_EXACT,
+} BOUND;
+
+/*
+    One entry is two words, the key is stored XORed with the data so a torn write from
+    another thread fails verification instead of returning another position's data
+*/
+typedef struct TableEntry {
+    uint64_t check;
+    uint64_t data;
+} TTENTRY;
+
+// Four entries fill one 64 byte cache line, a probe costs at most one miss
+typedef struct TableBucket {
+    TTENTRY entries[TT_BUCKET_ENTRIES];
+} TTBUCKET;
+
+typedef struct TableHit {
+    MOVE move;
+    int score;
+    int depth;
+    BOUND bound;
+} TTHIT;
+
+/*
+    Counters kept per search thread and merged into the table totals when a search ends,
+    collisions are entries of another position evicted by a store
+*/
+typedef struct TableStats {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t stores;
+    uint64_t collisions;
+} TTSTATS;
+
+/*
+    One table shared by every search thread, sized once at startup
+    Large tables are backed by transparent huge pages when the kernel allows it
+*/
+bool ResizeTable(int megabytes);
+void ClearTable(void);
+void FreeTable(void);
+bool TableUsesHugePages(void);
+
+// Called once per search, older entries lose priority when a bucket is full
+void NewTableGeneration(void);
+
+bool ProbeTable(uint64_t key, TTHIT *hit, TTSTATS *stats);
+void StoreTable(uint64_t key, MOVE move, int score, int depth, BOUND bound, TTSTATS *stats);
+void PrefetchTable(uint64_t key);
+
+void AddTableStats(const TTSTATS *stats);
+void GetTableStats(TTSTATS *stats);
+void ResetTableStats(void);
+
+// Entries from the current generation per thousand, sampled from the first buckets
+int TableFillPermille(void);
+
+#endif // TT_H
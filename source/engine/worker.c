@@ -0,0 +1,130 @@
+#define _POSIX_C_SOURCE 200809L
+#include "worker.h"
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include "profiler.h"
+#include "spsc.h"
+
+#define JOB_QUEUE_SIZE 8
+#define REPLY_QUEUE_SIZE 8
+
+static SPSCQUEUE jobs;
+static SPSCQUEUE replies;
+static sem_t jobsPosted;
+static pthread_t thread;
+static bool running = false;
+
+static uint32_t lastJobId = 0;
+static uint32_t cancelledJobId = 0;
+static bool stopSearch = false;
+static bool quit = false;
+
+static void *WorkerMain(void *argument) {
+    (void)argument;
+    ENGINEJOB job;
+    ENGINEREPLY reply;
+    NameProfileThread("engine worker");
+
+    for (;;) {
+        sem_wait(&jobsPosted);
+        if (__atomic_load_n(&quit, __ATOMIC_SEQ_CST)) break;
+        if (!QueuePop(&jobs, &job)) continue;
+
+        /*
+            Clear the flag before looking at the cancel mark, a cancel that lands after the
+            check sets the flag again and stops the search right away
+        */
+        __atomic_store_n(&stopSearch, false, __ATOMIC_SEQ_CST);
+        if (job.id <= __atomic_load_n(&cancelledJobId, __ATOMIC_SEQ_CST)) continue;
+
+        job.limits.stop = &stopSearch;
+        {
+            PROFILE_SCOPE("SearchPosition");
+            SearchPosition(&job.position, job.keys, job.keyCount, &job.limits, &reply.result);
+        }
+        if (job.id <= __atomic_load_n(&cancelledJobId, __ATOMIC_SEQ_CST)) continue;
+
+        // The main thread drains replies every frame, a full queue only means it is behind
+        reply.id = job.id;
+        while (!QueuePush(&replies, &reply)) {
+            if (__atomic_load_n(&quit, __ATOMIC_SEQ_CST)) return NULL;
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+bool StartEngineWorker(void) {
+    if (running) return true;
+
+    if (!InitQueue(&jobs, sizeof(ENGINEJOB), JOB_QUEUE_SIZE)) return false;
+    if (!InitQueue(&replies, sizeof(ENGINEREPLY), REPLY_QUEUE_SIZE)) {
+        FreeQueue(&jobs);
+        return false;
+    }
+    sem_init(&jobsPosted, 0, 0);
+    quit = false;
+    stopSearch = false;
+
+    if (pthread_create(&thread, NULL, WorkerMain, NULL) != 0) {
+        sem_destroy(&jobsPosted);
+        FreeQueue(&jobs);
+        FreeQueue(&replies);
+        return false;
+    }
+    running = true;
+    return true;
+}
+
+void StopEngineWorker(void) {
+    if (!running) return;
+
+    __atomic_store_n(&quit, true, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&stopSearch, true, __ATOMIC_SEQ_CST);
+    sem_post(&jobsPosted);
+    pthread_join(thread, NULL);
+
+    sem_destroy(&jobsPosted);
+    FreeQueue(&jobs);
+    FreeQueue(&replies);
+    running = false;
+}
+
+uint32_t PostSearch(const POSITION *position, const uint64_t *gameKeys, int gameKeyCount, const SEARCHLIMITS *limits) {
+    if (!running) return 0;
+
+    ENGINEJOB job;
+    if (gameKeyCount > MAX_JOB_KEYS) {
+        gameKeys += gameKeyCount - MAX_JOB_KEYS;
+        gameKeyCount = MAX_JOB_KEYS;
+    }
+    job.id = lastJobId + 1;
+    job.position = *position;
+    for (int i = 0; i < gameKeyCount; i++) {
+        job.keys[i] = gameKeys[i];
+    }
+    job.keyCount = gameKeyCount;
+    job.limits = *limits;
+
+    if (!QueuePush(&jobs, &job)) return 0;
+    sem_post(&jobsPosted);
+    return ++lastJobId;
+}
+
+void CancelSearches(void) {
+    if (!running) return;
+
+    __atomic_store_n(&cancelledJobId, lastJobId, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&stopSearch, true, __ATOMIC_SEQ_CST);
+}
+
+bool PollEngineReply(ENGINEREPLY *reply) {
+    if (!running) return false;
+
+    // Replies to cancelled jobs may already be queued, skip them here
+    while (QueuePop(&replies, reply)) {
+        if (reply->id > __atomic_load_n(&cancelledJobId, __ATOMIC_SEQ_CST)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,38 @@
+#ifndef WORKER_H
+#define WORKER_H
+
+#include "search.h"
+
+// Repetitions cannot reach further back than the fifty-move rule
+#define MAX_JOB_KEYS 128
+
+typedef struct EngineJob {
+    uint32_t id;
+    POSITION position;
+    uint64_t keys[MAX_JOB_KEYS];
+    int keyCount;
+    SEARCHLIMITS limits;
+} ENGINEJOB;
+
+typedef struct EngineReply {
+    uint32_t id;
+    SEARCHRESULT result;
+} ENGINEREPLY;
+
+/*
+    Background search thread, fed by the main thread through lock-free queues
+    Only one thread may post and poll
+*/
+bool StartEngineWorker(void);
+void StopEngineWorker(void);
+
+// Returns the job id, 0 when the worker is not running or the queue is full
+uint32_t PostSearch(const POSITION *position, const uint64_t *gameKeys, int gameKeyCount, const SEARCHLIMITS *limits);
+
+// Aborts the running search and drops every job posted so far, their replies never arrive
+void CancelSearches(void);
+
+// Non-blocking, meant to be called once per frame
+bool PollEngineReply(ENGINEREPLY *reply);
+
+#endif // WORKER_H
@@ -1,33 +1,112 @@
 #include "raylib.h"
 #include <stdio.h>
+#include <string.h>
 #include "board.h"
 #include "screen.h"
 #include "menu.h"
+#include "utilities/loader.h"
+#include "engine/profiler.h"
+#include "engine/tablebase.h"
+#include "engine/timer.h"
+#include "engine/tt.h"
+#include "engine/worker.h"
 #include <math.h>
 
 #define SCREEN_WIDTH 1920
 #define SCREEN_HEIGHT 1080
 
-int main () {
+// Engine and data files the intro screen does not need, loaded once it is showing
+static void StartEngine() {
+    // Bot moves are searched off the render thread
+    ResizeTable(TT_DEFAULT_MB);
+    StartEngineWorker();
+
+    // Optional, without it the bot searches from the first move
+    LoadBotBook(BOT_BOOK_PATH);
+    LoadTablebases(TABLEBASE_PATH);
+    LoadPuzzles(PUZZLE_DB_PATH);
+}
+
+int main (int argc, char **argv) {
+
+    double startSeconds = NowSeconds();
+
+    // --wait-events: draw only when something changed and sleep in between, for screens left open all day
+    // --profile: time the hot paths from the first frame, F2 toggles it at any time
+    // --loose-assets and --startup-only: compare startup without the archive, and quit once it is interactive
+    bool waitEvents = false;
+    bool looseAssets = false;
+    bool startupOnly = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--wait-events") == 0) waitEvents = true;
+        if (strcmp(argv[i], "--profile") == 0) ShowProfiler(true);
+        if (strcmp(argv[i], "--loose-assets") == 0) looseAssets = true;
+        if (strcmp(argv[i], "--startup-only") == 0) startupOnly = true;
+    }
+    NameProfileThread("main");
 
     SetConfigFlags(FLAG_WINDOW_UNDECORATED | FLAG_WINDOW_RESIZABLE);
     InitWindow(1920, 1080, "Chess");
 
+    // The menu's textures are decoded in the background while the intro screen is up
+    bool packed = StartAssetLoader(looseAssets ? NULL : ASSET_ARCHIVE_PATH);
+    const char *assetSource = packed ? ASSET_ARCHIVE_PATH : "loose files";
     InitializeScreen();
     InitializeMenu();
     SetTargetFPS(60);
 
+    bool redraw = true;
+    bool engineStarted = false;
+    bool interactive = false;
     while (!WindowShouldClose()) {
 
-        UpdateMenu();
-        UpdateScreen();
+        bool loading = UploadLoadedTextures() > 0 || AreTexturesPending();
+        redraw = redraw || loading;
+
+        bool menuChanged, screenChanged;
+        {
+            PROFILE_SCOPE("Update");
+            menuChanged = UpdateMenu();
+            screenChanged = UpdateScreen();
+        }
+        redraw = redraw || menuChanged || screenChanged || IsWindowResized();
+
+        if (!waitEvents || redraw) {
+            // Animations and the bot's search need the next frame without waiting for input
+            if (waitEvents) DisableEventWaiting();
+            BeginDrawing();
+            {
+                PROFILE_SCOPE("Render");
+                ClearBackground(RAYWHITE);
+                RenderScreen();
+            }
+            EndDrawing();
+            EndProfileFrame();
+            redraw = false;
 
-        BeginDrawing();
-            ClearBackground(RAYWHITE);
-            RenderScreen();
-        EndDrawing();
+            if (!engineStarted) {
+                printf("startup: first frame after %.1f ms (%s)\n", (NowSeconds() - startSeconds) * 1000.0, assetSource);
+                StartEngine();
+                engineStarted = true;
+            }
+            if (!interactive && !AreTexturesPending()) {
+                printf("startup: interactive after %.1f ms (%s)\n", (NowSeconds() - startSeconds) * 1000.0, assetSource);
+                interactive = true;
+                if (startupOnly) break;
+            }
+        } else {
+            // Nothing to show, block until the next input event
+            EnableEventWaiting();
+            PollInputEvents();
+        }
     }
 
+    StopAssetLoader();
+    StopEngineWorker();
+    UnloadBotBook();
+    UnloadTablebases();
+    UnloadPuzzles();
+    FreeTable();
     CloseWindow();
 
     return 0;
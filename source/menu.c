@@ -14,15 +14,30 @@ void InitializeMenu(){
     InitializeButton(&learnSkillsButton, "assets/learn_skills_button.png", (Vector2){1340, 680}); 
 }
 
-void UpdateMenu(){
-    UpdateButton(&playOnlineButton);
-    UpdateButton(&playBotsButton);
-    UpdateButton(&playFriendsButton);
-    UpdateButton(&playPuzzlesButton);
-    UpdateButton(&learnSkillsButton);
-    if(IsButtonPressed(&playFriendsButton)){
+bool UpdateMenu(){
+    bool animating = UpdateButton(&playOnlineButton);
+    animating = UpdateButton(&playBotsButton) || animating;
+    animating = UpdateButton(&playFriendsButton) || animating;
+    animating = UpdateButton(&playPuzzlesButton) || animating;
+    animating = UpdateButton(&learnSkillsButton) || animating;
+
+    // The hitboxes overlap the board's h-file, so clicks only count where the buttons are drawn
+    bool onTitle = GetCurrentScreen() == TITLE;
+    if(onTitle && IsButtonPressed(&playBotsButton)){
+        SetBotColor(COLOR_BLACK);
+        ChangeScreen(GAME);
+    }
+    if(onTitle && IsButtonPressed(&playFriendsButton)){
+        SetBotColor(-1);
         ChangeScreen(GAME);
     }
+    if(onTitle && IsButtonPressed(&playPuzzlesButton)){
+        StartPuzzleMode();
+        ChangeScreen(GAME);
+    }
+
+    // The buttons ease on every screen but are only seen on the title screen
+    return animating && onTitle;
 }
 void RenderMenu(){
     RenderButton(&playOnlineButton);
@@ -3,6 +3,7 @@
 #include "utilities/button.h"
 
 void InitializeMenu();
-void UpdateMenu();
+// True when the menu needs another frame drawn
+bool UpdateMenu();
 void RenderMenu();
 void UnloadMenu();
\ No newline at end of file
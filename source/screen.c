@@ -1,14 +1,25 @@
 #include "screen.h"
 #include "menu.h"
+#include <stdlib.h>
+#include "core/gamelog.h"
+#include "engine/profiler.h"
+
+#define PROFILE_TRACE_PATH "profile.json"
+#define FRAME_HISTOGRAM_BUCKETS 34
 
 static SCREEN currentScreen = INTRO;
 static bool gameStart = false;
+static bool showRenderStats = false;
+static bool showProfiler = false;
+static const char *profilerMessage = "";
+static bool screenChanged = true;
 
 void InitializeScreen(){
     currentScreen = INTRO;
 }
 
 void ChangeScreen(SCREEN newScreen) {
+    screenChanged = screenChanged || newScreen != currentScreen;
     currentScreen = newScreen;
 }
 
@@ -16,7 +27,26 @@ SCREEN GetCurrentScreen() {
     return currentScreen;
 }
 
-void UpdateScreen() {
+void ShowProfiler(bool show) {
+    showProfiler = show;
+    EnableProfiling(show);
+}
+
+bool UpdateScreen() {
+    bool changed = false;
+
+    // F2 shows the profiler on any screen, F4 saves what it recorded as a Chrome trace
+    if (IsKeyPressed(KEY_F2))
+    {
+        ShowProfiler(!showProfiler);
+        profilerMessage = "";
+        changed = true;
+    }
+    if (showProfiler && IsKeyPressed(KEY_F4))
+    {
+        profilerMessage = WriteProfileTrace(PROFILE_TRACE_PATH) ? "saved " PROFILE_TRACE_PATH : "could not write " PROFILE_TRACE_PATH;
+    }
+
     switch (currentScreen)
     {
         case INTRO:
@@ -30,7 +60,12 @@ void UpdateScreen() {
             break;
 
         case GAME:
-            if (GetSelectedPiece())
+            // Clicks, keys, the selected piece following the mouse and the bot's search all show on the board
+            // GetKeyPressed pops raylib's key queue, nothing else reads it and keys are checked with IsKeyPressed
+            changed = changed || !gameStart || IsBotThinking() || IsMouseButtonPressed(MOUSE_LEFT_BUTTON) || GetKeyPressed() != 0 ||
+                      (IsPieceSelected() && (GetMouseDelta().x != 0 || GetMouseDelta().y != 0));
+
+            if (IsPieceSelected())
                 SetMouseCursor(MOUSE_CURSOR_POINTING_HAND);
             else
                 SetMouseCursor(MOUSE_CURSOR_DEFAULT);
@@ -39,10 +74,58 @@ void UpdateScreen() {
             {
                 InitializeChessboard();
                 PlaceStartingPieces();
+                if (IsPuzzleMode()) NextPuzzle();
                 gameStart = true;
             }
 
             MovePiece(GetMousePosition());
+            UpdateBot();
+
+            if (IsKeyPressed(KEY_BACKSPACE))
+            {
+                TakeBackMove();
+            }
+
+            // Arrows step through the game a ply at a time, up and down a snapshot apart, Home and End to either end
+            if (IsKeyPressed(KEY_LEFT)) StepReplay(-1);
+            if (IsKeyPressed(KEY_RIGHT)) StepReplay(1);
+            if (IsKeyPressed(KEY_DOWN)) StepReplay(-GAMELOG_SNAPSHOT_INTERVAL);
+            if (IsKeyPressed(KEY_UP)) StepReplay(GAMELOG_SNAPSHOT_INTERVAL);
+            if (IsKeyPressed(KEY_HOME)) SeekReplay(0);
+            if (IsKeyPressed(KEY_END)) StopReplay();
+
+            if (IsPuzzleMode() && IsKeyPressed(KEY_N))
+            {
+                NextPuzzle();
+            }
+
+            if (IsKeyPressed(KEY_F3))
+            {
+                showRenderStats = !showRenderStats;
+            }
+
+            // Ctrl+C copies the position as FEN, Ctrl+V sets one up from the clipboard, Ctrl+Z and Ctrl+Y undo and redo
+            if (IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL))
+            {
+                if (IsKeyPressed(KEY_C))
+                {
+                    char fen[FEN_BUFFER_SIZE];
+                    GetPositionFen(fen, sizeof(fen));
+                    SetClipboardText(fen);
+                }
+                if (IsKeyPressed(KEY_V))
+                {
+                    LoadPositionFen(GetClipboardText());
+                }
+                if (IsKeyPressed(KEY_Z))
+                {
+                    TakeBackMove();
+                }
+                if (IsKeyPressed(KEY_Y))
+                {
+                    RedoMove();
+                }
+            }
 
             if (IsKeyPressed(KEY_ENTER))
             {
@@ -52,6 +135,60 @@ void UpdateScreen() {
             }
             break;
     }
+
+    // The overlay is only worth reading with frames coming at the normal rate
+    changed = changed || screenChanged || showProfiler;
+    screenChanged = false;
+    return changed;
+}
+
+static int CompareFloats(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+// Frame times as a histogram of 1 ms buckets, the last one collecting everything slower
+static void RenderProfiler() {
+    float frames[PROFILE_FRAME_HISTORY];
+    int frameCount = GetProfileFrames(frames, PROFILE_FRAME_HISTORY);
+    int buckets[FRAME_HISTOGRAM_BUCKETS] = { 0 };
+    int tallest = 1;
+    for (int i = 0; i < frameCount; i++) {
+        int bucket = (int)frames[i];
+        if (bucket >= FRAME_HISTOGRAM_BUCKETS) bucket = FRAME_HISTOGRAM_BUCKETS - 1;
+        if (++buckets[bucket] > tallest) tallest = buckets[bucket];
+    }
+    qsort(frames, frameCount, sizeof(float), CompareFloats);
+
+    int x = 20, y = 120;
+    DrawRectangle(x - 10, y - 10, 420, 420, Fade(BLACK, 0.75f));
+    DrawText(frameCount ? TextFormat("frame  p50 %.2f  p99 %.2f  max %.2f ms", frames[frameCount / 2],
+                                     frames[frameCount * 99 / 100], frames[frameCount - 1]) : "frame  -",
+             x, y, 20, RAYWHITE);
+
+    for (int bucket = 0; bucket < FRAME_HISTOGRAM_BUCKETS; bucket++) {
+        int height = buckets[bucket] * 80 / tallest;
+        DrawRectangle(x + bucket * 12, y + 110 - height, 10, height, bucket < 17 ? GREEN : RED);
+    }
+    DrawText("0", x, y + 115, 10, GRAY);
+    DrawText("16", x + 16 * 12, y + 115, 10, GRAY);
+    DrawText("33+ ms", x + 33 * 12 - 20, y + 115, 10, GRAY);
+
+    PROFILEZONESTATS zones[PROFILE_MAX_ZONES];
+    int zoneCount = GetProfileZones(zones, PROFILE_MAX_ZONES);
+    y += 140;
+    static const char *headings[5] = { "zone", "avg us", "last us", "max us", "calls" };
+    static const int columns[5] = { 0, 170, 230, 290, 350 };
+    for (int column = 0; column < 5; column++) DrawText(headings[column], x + columns[column], y, 10, GRAY);
+    for (int i = 0; i < zoneCount; i++) {
+        y += 16;
+        DrawText(zones[i].name, x, y, 10, RAYWHITE);
+        DrawText(TextFormat("%.1f", zones[i].averageMicros), x + columns[1], y, 10, RAYWHITE);
+        DrawText(TextFormat("%.1f", zones[i].lastMicros), x + columns[2], y, 10, RAYWHITE);
+        DrawText(TextFormat("%.0f", zones[i].maxMicros), x + columns[3], y, 10, RAYWHITE);
+        DrawText(TextFormat("%u", zones[i].calls), x + columns[4], y, 10, RAYWHITE);
+    }
+    DrawText(TextFormat("F4 saves a trace  %s", profilerMessage), x, 120 + 390, 10, GRAY);
 }
 
 void RenderScreen(){
@@ -67,7 +204,26 @@ void RenderScreen(){
         case GAME:{
             RenderChessboard();
             RenderPieces(GetMousePosition());
+            if (IsBotThinking()) DrawText("Thinking...", 120, 20, 40, GRAY);
+
+            char verdict[32];
+            if (GetEndgameVerdict(verdict, sizeof(verdict))) DrawText(verdict, 120, 70, 30, GRAY);
+
+            char puzzleStatus[64];
+            if (GetPuzzleStatus(puzzleStatus, sizeof(puzzleStatus))) DrawText(puzzleStatus, 120, 20, 40, GRAY);
+
+            char replayStatus[64];
+            if (GetReplayStatus(replayStatus, sizeof(replayStatus))) DrawText(replayStatus, 120, 120, 30, GRAY);
+
+            // F3, what the board cost this frame
+            if (showRenderStats) {
+                SPRITESTATS stats = GetBoardRenderStats();
+                DrawText(TextFormat("%d FPS  board %d quads  %d vertices  %d texture batches", GetFPS(), stats.quads,
+                                    stats.vertices, stats.batches), 120, 1030, 20, GRAY);
+            }
         } break;
         default: break;
     }
+
+    if (showProfiler) RenderProfiler();
 }
\ No newline at end of file
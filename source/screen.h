@@ -17,8 +17,12 @@ void ChangeScreen(SCREEN newScreen);
 
 SCREEN GetCurrentScreen();
 
-void UpdateScreen();
+// True when the screen needs another frame drawn
+bool UpdateScreen();
 
 void RenderScreen();
 
+// Profiler overlay, profiling runs while it is shown
+void ShowProfiler(bool show);
+
 #endif
\ No newline at end of file
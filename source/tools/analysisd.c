@@ -0,0 +1,453 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "engine/analysis.h"
+#include "engine/search.h"
+#include "engine/timer.h"
+#include "engine/tt.h"
+
+#define MAX_CONNECTIONS 256
+#define MAX_WORKERS 64
+#define BATCH_JOBS 8
+#define DEFAULT_QUEUE_JOBS 1024
+#define RECEIVE_BUFFER (16 * ANALYSIS_MAX_FRAME)
+
+// Replies a client has not read yet, past this no more of its requests are read
+#define OUTPUT_HIGH_WATER (64 * ANALYSIS_MAX_FRAME)
+
+// Poll slots before the clients: the listener and the pipe workers wake the I/O thread with
+#define FIRST_CLIENT 2
+
+/*
+    A client connection, shared by the I/O thread and every queued job from it
+    The last reference closes the socket, so a descriptor is never reused under a worker
+    Sockets are non-blocking, replies go into output and whatever the socket does not take
+    at once is sent by the I/O thread when poll reports it writable
+*/
+typedef struct Connection {
+    int fd;
+    int references;
+    pthread_mutex_t outputLock;
+    unsigned char *output;
+    size_t outputUsed;
+    size_t outputCapacity;
+    bool broken;
+    bool readClosed;
+    unsigned char buffer[RECEIVE_BUFFER];
+    size_t used;
+} CONNECTION;
+
+// The FEN is parsed on the I/O thread, a job only ever holds a position the generator can play
+typedef struct Job {
+    CONNECTION *connection;
+    ANALYSISREQUEST request;
+    POSITION position;
+    double received;
+} JOB;
+
+typedef struct ServerOptions {
+    const char *socketPath;
+    int workers;
+    int queueJobs;
+    int hashMb;
+    int reportSeconds;
+} SERVEROPTIONS;
+
+typedef struct ServerCounts {
+    uint64_t completed;
+    uint64_t rejected;
+    uint64_t expired;
+    uint64_t invalid;
+} SERVERCOUNTS;
+
+static SERVEROPTIONS options = { ANALYSIS_SOCKET_PATH, 1, DEFAULT_QUEUE_JOBS, TT_DEFAULT_MB, 5 };
+
+/*
+    Bounded job queue between the I/O thread and the pool
+    A full queue is answered at once with ANALYSIS_OVERLOADED, the I/O thread never waits
+*/
+static JOB *queue;
+static int queueHead = 0;
+static int queueCount = 0;
+static bool shuttingDown = false;
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueNotEmpty = PTHREAD_COND_INITIALIZER;
+
+static SERVERCOUNTS counts;
+static LATENCYHISTOGRAM intervalLatency;
+static LATENCYHISTOGRAM totalLatency;
+static volatile sig_atomic_t interrupted = 0;
+static int wakeFds[2] = { -1, -1 };
+
+static void OnSignal(int signal) {
+    (void)signal;
+    interrupted = 1;
+}
+
+static void ReleaseConnection(CONNECTION *connection) {
+    if (__atomic_sub_fetch(&connection->references, 1, __ATOMIC_ACQ_REL) > 0) return;
+    close(connection->fd);
+    pthread_mutex_destroy(&connection->outputLock);
+    free(connection->output);
+    free(connection);
+}
+
+// Whatever the socket takes without blocking, caller holds outputLock
+static void FlushOutput(CONNECTION *connection) {
+    size_t sent = 0;
+    while (sent < connection->outputUsed) {
+        ssize_t written = send(connection->fd, connection->output + sent, connection->outputUsed - sent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (written <= 0) {
+            // The client is gone, nothing queued for it will ever be read
+            connection->broken = true;
+            sent = connection->outputUsed;
+            break;
+        }
+        sent += (size_t)written;
+    }
+    memmove(connection->output, connection->output + sent, connection->outputUsed - sent);
+    connection->outputUsed -= sent;
+}
+
+static void WakeIoThread(void) {
+    char byte = 0;
+    if (write(wakeFds[1], &byte, 1) < 0) {
+        // A full pipe already has the I/O thread on its way
+    }
+}
+
+// Replies from several workers to one client go out whole, one frame at a time, and never wait on the client
+static void SendReply(CONNECTION *connection, const ANALYSISREPLY *reply) {
+    unsigned char frame[ANALYSIS_MAX_FRAME];
+    size_t length = EncodeAnalysisReply(reply, frame);
+
+    pthread_mutex_lock(&connection->outputLock);
+    if (!connection->broken && connection->outputUsed + length > connection->outputCapacity) {
+        size_t capacity = connection->outputCapacity ? connection->outputCapacity : ANALYSIS_MAX_FRAME;
+        while (capacity < connection->outputUsed + length) capacity *= 2;
+        unsigned char *output = realloc(connection->output, capacity);
+        if (output == NULL) connection->broken = true;
+        else connection->output = output, connection->outputCapacity = capacity;
+    }
+    if (!connection->broken) {
+        memcpy(connection->output + connection->outputUsed, frame, length);
+        connection->outputUsed += length;
+        FlushOutput(connection);
+    }
+    bool pending = connection->outputUsed > 0;
+    pthread_mutex_unlock(&connection->outputLock);
+
+    if (pending) WakeIoThread();
+}
+
+static void RecordLatency(double received) {
+    uint64_t micros = (uint64_t)((NowSeconds() - received) * 1e6);
+    AddLatency(&intervalLatency, micros);
+    AddLatency(&totalLatency, micros);
+}
+
+static bool PushJob(CONNECTION *connection, const ANALYSISREQUEST *request, const POSITION *position, double received) {
+    pthread_mutex_lock(&queueLock);
+    bool accepted = queueCount < options.queueJobs;
+    if (accepted) {
+        __atomic_add_fetch(&connection->references, 1, __ATOMIC_RELAXED);
+        queue[(queueHead + queueCount++) % options.queueJobs] = (JOB){ connection, *request, *position, received };
+        pthread_cond_signal(&queueNotEmpty);
+    }
+    pthread_mutex_unlock(&queueLock);
+    return accepted;
+}
+
+// Up to BATCH_JOBS jobs per lock round trip, zero once shutting down with nothing left
+static int PopJobs(JOB *jobs) {
+    pthread_mutex_lock(&queueLock);
+    while (queueCount == 0 && !shuttingDown) pthread_cond_wait(&queueNotEmpty, &queueLock);
+
+    // Leave work for the other workers when the queue is short
+    int take = queueCount / options.workers;
+    if (take < 1) take = 1;
+    if (take > BATCH_JOBS) take = BATCH_JOBS;
+    if (take > queueCount) take = queueCount;
+
+    for (int i = 0; i < take; i++) {
+        jobs[i] = queue[queueHead];
+        queueHead = (queueHead + 1) % options.queueJobs;
+    }
+    queueCount -= take;
+    pthread_mutex_unlock(&queueLock);
+    return take;
+}
+
+static void RunJob(JOB *job) {
+    ANALYSISREPLY reply = { .id = job->request.id, .status = ANALYSIS_OK };
+    double started = NowSeconds();
+    reply.queueMicros = (uint32_t)((started - job->received) * 1e6);
+
+    double deadline = job->received + job->request.deadlineMs / 1000.0;
+    if (job->request.deadlineMs && started >= deadline) {
+        reply.status = ANALYSIS_EXPIRED;
+        __atomic_add_fetch(&counts.expired, 1, __ATOMIC_RELAXED);
+    } else {
+        // The search gets what is left before the deadline, never more than was asked for
+        SEARCHLIMITS limits = { .depth = job->request.depth, .nodes = job->request.nodes,
+                                .moveTimeMs = (int)job->request.moveTimeMs, .threads = 1 };
+        if (job->request.deadlineMs) {
+            int remainingMs = (int)((deadline - started) * 1000);
+            if (remainingMs < 1) remainingMs = 1;
+            if (limits.moveTimeMs == 0 || limits.moveTimeMs > remainingMs) limits.moveTimeMs = remainingMs;
+        }
+        if (limits.depth == 0 && limits.nodes == 0 && limits.moveTimeMs == 0) limits.depth = 1;
+
+        SEARCHRESULT result;
+        SearchPosition(&job->position, NULL, 0, &limits, &result);
+        reply.depth = (uint8_t)result.depth;
+        reply.score = (int16_t)result.score;
+        reply.nodes = result.nodes;
+        if (result.bestMove != MOVE_NONE) MoveToUci(result.bestMove, reply.bestMove);
+        __atomic_add_fetch(&counts.completed, 1, __ATOMIC_RELAXED);
+    }
+
+    reply.searchMicros = (uint32_t)((NowSeconds() - started) * 1e6);
+    SendReply(job->connection, &reply);
+    RecordLatency(job->received);
+    ReleaseConnection(job->connection);
+}
+
+static void *WorkerMain(void *argument) {
+    (void)argument;
+    JOB jobs[BATCH_JOBS];
+    int count;
+    while ((count = PopJobs(jobs)) > 0) {
+        for (int i = 0; i < count; i++) RunJob(&jobs[i]);
+    }
+    return NULL;
+}
+
+// Every complete frame in the connection buffer, false if the client has to be dropped
+static bool HandleFrames(CONNECTION *connection) {
+    long frameSize;
+    size_t offset = 0;
+    double received = NowSeconds();
+
+    while ((frameSize = AnalysisFrameSize(connection->buffer + offset, connection->used - offset)) > 0) {
+        const unsigned char *payload = connection->buffer + offset + ANALYSIS_FRAME_HEADER;
+        ANALYSISREQUEST request = { 0 };
+        POSITION position;
+        offset += (size_t)frameSize;
+
+        // Bad FENs are answered here, before a worker or the generator ever sees them
+        if (!DecodeAnalysisRequest(payload, (size_t)frameSize - ANALYSIS_FRAME_HEADER, &request) ||
+            !ParseFen(&position, request.fen)) {
+            ANALYSISREPLY reply = { .id = request.id, .status = ANALYSIS_BAD_REQUEST };
+            __atomic_add_fetch(&counts.invalid, 1, __ATOMIC_RELAXED);
+            SendReply(connection, &reply);
+            continue;
+        }
+        if (!PushJob(connection, &request, &position, received)) {
+            ANALYSISREPLY reply = { .id = request.id, .status = ANALYSIS_OVERLOADED };
+            __atomic_add_fetch(&counts.rejected, 1, __ATOMIC_RELAXED);
+            SendReply(connection, &reply);
+            RecordLatency(received);
+        }
+    }
+    if (frameSize < 0) return false;
+
+    memmove(connection->buffer, connection->buffer + offset, connection->used - offset);
+    connection->used -= offset;
+    return true;
+}
+
+static void Report(double seconds, uint64_t requests, const LATENCYHISTOGRAM *latency, const char *label) {
+    int depth;
+    pthread_mutex_lock(&queueLock);
+    depth = queueCount;
+    pthread_mutex_unlock(&queueLock);
+
+    printf("%s %7.0f req/s  p50 %7.2f ms  p99 %7.2f ms  max %7.2f ms  queue %4d  done %llu  rejected %llu  expired %llu  invalid %llu\n",
+           label, seconds > 0 ? requests / seconds : 0.0, LatencyPercentile(latency, 50) / 1000.0,
+           LatencyPercentile(latency, 99) / 1000.0, latency->maxMicros / 1000.0, depth,
+           (unsigned long long)counts.completed, (unsigned long long)counts.rejected,
+           (unsigned long long)counts.expired, (unsigned long long)counts.invalid);
+    fflush(stdout);
+}
+
+static int OpenListener(const char *path) {
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "%s: socket path too long\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, 64) != 0) {
+        perror(path);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void Usage(const char *program) {
+    fprintf(stderr, "usage: %s [--socket PATH] [--workers N] [--queue N] [--hash MB] [--report SECONDS]\n", program);
+}
+
+int main(int argc, char **argv) {
+    options.workers = AvailableCores();
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "--socket") == 0) options.socketPath = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--workers") == 0) options.workers = atoi(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "--queue") == 0) options.queueJobs = atoi(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "--hash") == 0) options.hashMb = atoi(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "--report") == 0) options.reportSeconds = atoi(argv[++i]);
+        else {
+            Usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (options.workers < 1 || options.workers > MAX_WORKERS || options.queueJobs < 1 || options.reportSeconds < 1) {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int listener = OpenListener(options.socketPath);
+    if (listener < 0) return EXIT_FAILURE;
+
+    struct sigaction action = { .sa_handler = OnSignal };
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    // Workers with replies the socket did not take at once wake the I/O thread to watch for POLLOUT
+    if (pipe(wakeFds) != 0) {
+        perror("pipe");
+        return EXIT_FAILURE;
+    }
+    fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+
+    queue = malloc(options.queueJobs * sizeof(JOB));
+    ResizeTable(options.hashMb);
+    pthread_t workers[MAX_WORKERS];
+    for (int i = 0; i < options.workers; i++) pthread_create(&workers[i], NULL, WorkerMain, NULL);
+    printf("listening on %s, %d workers, queue %d\n", options.socketPath, options.workers, options.queueJobs);
+    fflush(stdout);
+
+    // Slot 0 is the listener, slot 1 the wake pipe, the rest are clients in the order they connected
+    struct pollfd polls[MAX_CONNECTIONS + FIRST_CLIENT] = { { .fd = listener, .events = POLLIN }, { .fd = wakeFds[0], .events = POLLIN } };
+    CONNECTION *connections[MAX_CONNECTIONS + FIRST_CLIENT];
+    int pollCount = FIRST_CLIENT;
+
+    double start = NowSeconds(), lastReport = start;
+    uint64_t lastTotal = 0;
+    while (!interrupted) {
+        // A client whose replies back up is not read from until it catches up, which also bounds its output
+        for (int i = FIRST_CLIENT; i < pollCount; i++) {
+            CONNECTION *connection = connections[i];
+            pthread_mutex_lock(&connection->outputLock);
+            size_t pending = connection->outputUsed;
+            pthread_mutex_unlock(&connection->outputLock);
+
+            bool reading = !connection->readClosed && pending < OUTPUT_HIGH_WATER;
+            polls[i].events = (reading ? POLLIN : 0) | (pending ? POLLOUT : 0);
+        }
+
+        int ready = poll(polls, pollCount, 250);
+        if (ready < 0 && errno != EINTR) break;
+
+        if (ready > 0 && (polls[1].revents & POLLIN)) {
+            char drain[64];
+            while (read(wakeFds[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+
+        if (ready > 0 && (polls[0].revents & POLLIN)) {
+            int fd = accept(listener, NULL, NULL);
+            CONNECTION *connection = (fd >= 0 && pollCount < MAX_CONNECTIONS + FIRST_CLIENT) ? calloc(1, sizeof(CONNECTION)) : NULL;
+            if (connection) {
+                fcntl(fd, F_SETFL, O_NONBLOCK);
+                connection->fd = fd;
+                connection->references = 1;
+                pthread_mutex_init(&connection->outputLock, NULL);
+                connections[pollCount] = connection;
+                polls[pollCount++] = (struct pollfd){ .fd = fd };
+            } else if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+        for (int i = FIRST_CLIENT; i < pollCount; i++) {
+            CONNECTION *connection = connections[i];
+            short revents = ready > 0 ? polls[i].revents : 0;
+
+            if (revents & POLLOUT) {
+                pthread_mutex_lock(&connection->outputLock);
+                FlushOutput(connection);
+                pthread_mutex_unlock(&connection->outputLock);
+            }
+
+            // End of input or a malformed frame stops reading, replies to queued jobs still go out
+            if ((revents & POLLIN) && !connection->readClosed) {
+                ssize_t bytes = read(connection->fd, connection->buffer + connection->used, RECEIVE_BUFFER - connection->used);
+                if (bytes > 0) {
+                    connection->used += (size_t)bytes;
+                    if (!HandleFrames(connection)) connection->readClosed = true;
+                } else if (bytes == 0 || (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    connection->readClosed = true;
+                }
+            }
+
+            // Dropped once nothing more can reach the client, broken replies are discarded by the workers
+            pthread_mutex_lock(&connection->outputLock);
+            bool finished = connection->readClosed && connection->outputUsed == 0 &&
+                            __atomic_load_n(&connection->references, __ATOMIC_ACQUIRE) == 1;
+            bool drop = connection->broken || (revents & (POLLHUP | POLLERR)) || finished;
+            if (drop) connection->broken = true;
+            pthread_mutex_unlock(&connection->outputLock);
+
+            if (drop) {
+                ReleaseConnection(connection);
+                connections[i] = connections[pollCount - 1];
+                polls[i] = polls[--pollCount];
+                i--;
+            }
+        }
+
+        double now = NowSeconds();
+        if (now - lastReport >= options.reportSeconds) {
+            uint64_t total = __atomic_load_n(&totalLatency.total, __ATOMIC_RELAXED);
+            Report(now - lastReport, total - lastTotal, &intervalLatency, "interval");
+            ResetLatency(&intervalLatency);
+            lastReport = now;
+            lastTotal = total;
+        }
+    }
+
+    pthread_mutex_lock(&queueLock);
+    shuttingDown = true;
+    pthread_cond_broadcast(&queueNotEmpty);
+    pthread_mutex_unlock(&queueLock);
+    for (int i = 0; i < options.workers; i++) pthread_join(workers[i], NULL);
+
+    Report(NowSeconds() - start, totalLatency.total, &totalLatency, "total   ");
+    for (int i = FIRST_CLIENT; i < pollCount; i++) ReleaseConnection(connections[i]);
+    close(listener);
+    close(wakeFds[0]);
+    close(wakeFds[1]);
+    unlink(options.socketPath);
+    free(queue);
+    FreeTable();
+    return EXIT_SUCCESS;
+}
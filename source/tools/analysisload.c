@@ -0,0 +1,220 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "engine/analysis.h"
+#include "engine/timer.h"
+
+#define MAX_CONNECTIONS 256
+#define MAX_POSITIONS 4096
+
+static const char *defaultPositions[] = {
+    START_FEN,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+};
+
+typedef struct LoadOptions {
+    const char *socketPath;
+    int connections;
+    int inFlight;
+    uint32_t requests;
+    ANALYSISREQUEST limits;
+} LOADOPTIONS;
+
+typedef struct Client {
+    int fd;
+    int inFlight;
+    unsigned char buffer[16 * ANALYSIS_MAX_FRAME];
+    size_t used;
+} CLIENT;
+
+static char *positions[MAX_POSITIONS];
+static int positionCount = 0;
+
+// FEN or EPD lines, only the first four fields of an EPD line are a position
+static bool LoadPositions(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) return false;
+
+    char line[512];
+    while (positionCount < MAX_POSITIONS && fgets(line, sizeof(line), file)) {
+        char fields[6][96];
+        int count = sscanf(line, "%95s %95s %95s %95s %95s %95s", fields[0], fields[1], fields[2], fields[3], fields[4], fields[5]);
+        if (count < 4) continue;
+
+        bool fullFen = count == 6 && strspn(fields[4], "0123456789") == strlen(fields[4]);
+        char fen[sizeof(fields) + 8];
+        int length = snprintf(fen, sizeof(fen), "%s %s %s %s %s %s", fields[0], fields[1], fields[2], fields[3],
+                              fullFen ? fields[4] : "0", fullFen ? fields[5] : "1");
+        if (length < FEN_BUFFER_SIZE) positions[positionCount++] = strdup(fen);
+    }
+    fclose(file);
+    return positionCount > 0;
+}
+
+static int Connect(const char *path) {
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(address.sun_path)) return -1;
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+static bool SendAll(int fd, const unsigned char *data, size_t length) {
+    for (size_t sent = 0; sent < length;) {
+        ssize_t written = send(fd, data + sent, length - sent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        sent += (size_t)written;
+    }
+    return true;
+}
+
+static void Usage(const char *program) {
+    fprintf(stderr, "usage: %s [--socket PATH] [--connections N] [--inflight N] [--requests N]\n", program);
+    fprintf(stderr, "          [--depth D] [--nodes N] [--movetime MS] [--deadline MS] [--positions FILE]\n");
+}
+
+int main(int argc, char **argv) {
+    LOADOPTIONS options = { ANALYSIS_SOCKET_PATH, 4, 4, 10000, { .depth = 4 } };
+    const char *positionsPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (value && strcmp(argv[i], "--socket") == 0) options.socketPath = value;
+        else if (value && strcmp(argv[i], "--connections") == 0) options.connections = atoi(value);
+        else if (value && strcmp(argv[i], "--inflight") == 0) options.inFlight = atoi(value);
+        else if (value && strcmp(argv[i], "--requests") == 0) options.requests = (uint32_t)strtoul(value, NULL, 10);
+        else if (value && strcmp(argv[i], "--depth") == 0) options.limits.depth = (uint16_t)atoi(value);
+        else if (value && strcmp(argv[i], "--nodes") == 0) options.limits.nodes = strtoull(value, NULL, 10);
+        else if (value && strcmp(argv[i], "--movetime") == 0) options.limits.moveTimeMs = (uint32_t)atoi(value);
+        else if (value && strcmp(argv[i], "--deadline") == 0) options.limits.deadlineMs = (uint32_t)atoi(value);
+        else if (value && strcmp(argv[i], "--positions") == 0) positionsPath = value;
+        else {
+            Usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        i++;
+    }
+    if (options.connections < 1 || options.connections > MAX_CONNECTIONS || options.inFlight < 1 || options.requests == 0) {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (positionsPath && !LoadPositions(positionsPath)) {
+        fprintf(stderr, "%s: no positions\n", positionsPath);
+        return EXIT_FAILURE;
+    }
+    if (positionCount == 0) {
+        for (size_t i = 0; i < sizeof(defaultPositions) / sizeof(defaultPositions[0]); i++) {
+            positions[positionCount++] = (char *)defaultPositions[i];
+        }
+    }
+
+    CLIENT *clients = calloc(options.connections, sizeof(CLIENT));
+    struct pollfd polls[MAX_CONNECTIONS];
+    for (int i = 0; i < options.connections; i++) {
+        clients[i].fd = Connect(options.socketPath);
+        if (clients[i].fd < 0) {
+            perror(options.socketPath);
+            return EXIT_FAILURE;
+        }
+        polls[i] = (struct pollfd){ .fd = clients[i].fd, .events = POLLIN };
+    }
+
+    // Request ids index the send times, latency is measured from send to reply on this side
+    double *sentAt = malloc(options.requests * sizeof(double));
+    LATENCYHISTOGRAM latency = { { 0 } };
+    uint64_t statusCounts[4] = { 0 }, serverQueueMicros = 0, searchMicros = 0, nodes = 0;
+    uint32_t nextId = 0, replies = 0;
+    double start = NowSeconds();
+
+    while (replies < options.requests) {
+        // Keep every connection topped up to its in-flight window
+        for (int i = 0; i < options.connections; i++) {
+            while (clients[i].inFlight < options.inFlight && nextId < options.requests) {
+                ANALYSISREQUEST request = options.limits;
+                unsigned char frame[ANALYSIS_MAX_FRAME];
+                request.id = nextId;
+                snprintf(request.fen, sizeof(request.fen), "%s", positions[nextId % positionCount]);
+
+                sentAt[nextId++] = NowSeconds();
+                if (!SendAll(clients[i].fd, frame, EncodeAnalysisRequest(&request, frame))) {
+                    fprintf(stderr, "server closed the connection\n");
+                    return EXIT_FAILURE;
+                }
+                clients[i].inFlight++;
+            }
+        }
+
+        if (poll(polls, options.connections, 1000) < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < options.connections; i++) {
+            if (!(polls[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+            CLIENT *client = &clients[i];
+            ssize_t bytes = read(client->fd, client->buffer + client->used, sizeof(client->buffer) - client->used);
+            if (bytes <= 0) {
+                fprintf(stderr, "server closed the connection\n");
+                return EXIT_FAILURE;
+            }
+            client->used += (size_t)bytes;
+
+            long frameSize;
+            size_t offset = 0;
+            while ((frameSize = AnalysisFrameSize(client->buffer + offset, client->used - offset)) > 0) {
+                ANALYSISREPLY reply;
+                if (DecodeAnalysisReply(client->buffer + offset + ANALYSIS_FRAME_HEADER, (size_t)frameSize - ANALYSIS_FRAME_HEADER, &reply) &&
+                    reply.id < nextId) {
+                    AddLatency(&latency, (uint64_t)((NowSeconds() - sentAt[reply.id]) * 1e6));
+                    statusCounts[reply.status < 4 ? reply.status : ANALYSIS_BAD_REQUEST]++;
+                    serverQueueMicros += reply.queueMicros;
+                    searchMicros += reply.searchMicros;
+                    nodes += reply.nodes;
+                }
+                offset += (size_t)frameSize;
+                client->inFlight--;
+                replies++;
+            }
+            if (frameSize < 0) {
+                fprintf(stderr, "malformed reply\n");
+                return EXIT_FAILURE;
+            }
+            memmove(client->buffer, client->buffer + offset, client->used - offset);
+            client->used -= offset;
+        }
+    }
+
+    double seconds = NowSeconds() - start;
+    printf("%u requests over %d connections x %d in flight in %.2fs: %.0f req/s\n", replies, options.connections,
+           options.inFlight, seconds, replies / seconds);
+    printf("latency  p50 %.2f ms  p90 %.2f ms  p99 %.2f ms  max %.2f ms\n", LatencyPercentile(&latency, 50) / 1000.0,
+           LatencyPercentile(&latency, 90) / 1000.0, LatencyPercentile(&latency, 99) / 1000.0, latency.maxMicros / 1000.0);
+    printf("status   ok %llu  overloaded %llu  expired %llu  bad %llu\n", (unsigned long long)statusCounts[ANALYSIS_OK],
+           (unsigned long long)statusCounts[ANALYSIS_OVERLOADED], (unsigned long long)statusCounts[ANALYSIS_EXPIRED],
+           (unsigned long long)statusCounts[ANALYSIS_BAD_REQUEST]);
+    printf("server   queue %.2f ms  search %.2f ms average, %.0f nodes/request\n", serverQueueMicros / 1000.0 / replies,
+           searchMicros / 1000.0 / replies, (double)nodes / replies);
+
+    for (int i = 0; i < options.connections; i++) close(clients[i].fd);
+    free(clients);
+    free(sentAt);
+    return statusCounts[ANALYSIS_BAD_REQUEST] ? EXIT_FAILURE : EXIT_SUCCESS;
+}
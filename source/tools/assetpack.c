@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "engine/archive.h"
+
+typedef struct PackedFile {
+    ARCHIVEENTRY entry;
+    unsigned char *data;
+} PACKEDFILE;
+
+static int CompareNames(const void *a, const void *b) {
+    return strncmp(((const PACKEDFILE *)a)->entry.name, ((const PACKEDFILE *)b)->entry.name, ARCHIVE_NAME_SIZE);
+}
+
+static unsigned char *ReadWholeFile(const char *path, uint64_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+
+    unsigned char *data = NULL;
+    long length = (fseek(file, 0, SEEK_END) == 0) ? ftell(file) : -1;
+    if (length >= 0 && fseek(file, 0, SEEK_SET) == 0 && (data = malloc(length ? length : 1)) != NULL &&
+        fread(data, 1, length, file) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *size = (uint64_t)length;
+    return data;
+}
+
+static uint64_t Align(uint64_t offset) {
+    return (offset + ARCHIVE_ALIGNMENT - 1) & ~(uint64_t)(ARCHIVE_ALIGNMENT - 1);
+}
+
+// Files are stored under the path they were given as, the game asks for "assets/..." names
+static int Pack(const char *archivePath, char **paths, int count) {
+    PACKEDFILE *files = calloc(count, sizeof(PACKEDFILE));
+    for (int i = 0; i < count; i++) {
+        if (strlen(paths[i]) >= ARCHIVE_NAME_SIZE) {
+            fprintf(stderr, "%s: name longer than %d characters\n", paths[i], ARCHIVE_NAME_SIZE - 1);
+            return EXIT_FAILURE;
+        }
+        strcpy(files[i].entry.name, paths[i]);
+        files[i].data = ReadWholeFile(paths[i], &files[i].entry.size);
+        if (files[i].data == NULL) {
+            perror(paths[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    qsort(files, count, sizeof(PACKEDFILE), CompareNames);
+    uint64_t offset = sizeof(ARCHIVEHEADER) + (uint64_t)count * sizeof(ARCHIVEENTRY);
+    for (int i = 0; i < count; i++) {
+        if (i > 0 && CompareNames(&files[i - 1], &files[i]) == 0) {
+            fprintf(stderr, "%s: packed twice\n", files[i].entry.name);
+            return EXIT_FAILURE;
+        }
+        files[i].entry.offset = offset = Align(offset);
+        offset += files[i].entry.size;
+    }
+
+    FILE *out = fopen(archivePath, "wb");
+    if (out == NULL) {
+        perror(archivePath);
+        return EXIT_FAILURE;
+    }
+    ARCHIVEHEADER header = { .entrySize = sizeof(ARCHIVEENTRY), .entryCount = (uint32_t)count };
+    memcpy(header.magic, ARCHIVE_MAGIC, 4);
+    fwrite(&header, sizeof(header), 1, out);
+    for (int i = 0; i < count; i++) fwrite(&files[i].entry, sizeof(ARCHIVEENTRY), 1, out);
+
+    static const unsigned char padding[ARCHIVE_ALIGNMENT] = { 0 };
+    for (int i = 0; i < count; i++) {
+        fwrite(padding, 1, files[i].entry.offset - (uint64_t)ftell(out), out);
+        fwrite(files[i].data, 1, files[i].entry.size, out);
+        free(files[i].data);
+    }
+    free(files);
+
+    if (fclose(out) != 0) {
+        perror(archivePath);
+        return EXIT_FAILURE;
+    }
+    printf("%s: %d files, %llu bytes\n", archivePath, count, (unsigned long long)offset);
+    return EXIT_SUCCESS;
+}
+
+static int List(const char *archivePath) {
+    ARCHIVE archive;
+    if (!OpenArchive(&archive, archivePath)) {
+        fprintf(stderr, "%s: not an asset archive\n", archivePath);
+        return EXIT_FAILURE;
+    }
+    for (uint32_t i = 0; i < archive.entryCount; i++) {
+        printf("%10llu  %s\n", (unsigned long long)archive.entries[i].size, archive.entries[i].name);
+    }
+    CloseArchive(&archive);
+    return EXIT_SUCCESS;
+}
+
+static void Usage(const char *program) {
+    fprintf(stderr, "usage: %s ARCHIVE FILE...\n", program);
+    fprintf(stderr, "       %s --list ARCHIVE\n", program);
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "--list") == 0) return List(argv[2]);
+    if (argc >= 3 && argv[1][0] != '-') return Pack(argv[1], argv + 2, argc - 2);
+
+    Usage(argv[0]);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "core/fen.h"
+#include "engine/search.h"
+#include "engine/tt.h"
+
+static const char *benchPositions[] = {
+    START_FEN,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+};
+
+#define POSITION_COUNT (sizeof(benchPositions) / sizeof(benchPositions[0]))
+
+// Every position from an empty table, so runs with different thread counts are comparable
+static void RunBench(int depth, int threads, bool verbose, uint64_t *nodes, double *seconds) {
+    SEARCHLIMITS limits = { .depth = depth, .threads = threads };
+    *nodes = 0;
+    *seconds = 0;
+
+    for (size_t i = 0; i < POSITION_COUNT; i++) {
+        POSITION pos;
+        SEARCHRESULT result;
+        ParseFen(&pos, benchPositions[i]);
+        ClearTable();
+        SearchPosition(&pos, NULL, 0, &limits, &result);
+
+        if (verbose) {
+            printf("position %zu  depth %2d  score %6d  nodes %10llu  %7.3fs  %9.0f nps  hash fill %4d\n", i + 1,
+                   result.depth, result.score, (unsigned long long)result.nodes, result.seconds,
+                   result.seconds > 0 ? result.nodes / result.seconds : 0.0, TableFillPermille());
+        }
+        *nodes += result.nodes;
+        *seconds += result.seconds;
+    }
+}
+
+/*
+    Time to reach the same depth with 1, 2, 4 ... threads, the helpers only pay off
+    through the shared table so this is the number that picks a thread count
+*/
+static void RunSpeedup(int depth, int maxThreads) {
+    double baseline = 0;
+    for (int threads = 1;; threads = (threads * 2 < maxThreads) ? threads * 2 : maxThreads) {
+        uint64_t nodes;
+        double seconds;
+        RunBench(depth, threads, false, &nodes, &seconds);
+        if (threads == 1) baseline = seconds;
+
+        printf("threads %2d  time %8.3fs  nodes %12llu  %10.0f nps  speedup %5.2f\n", threads, seconds,
+               (unsigned long long)nodes, seconds > 0 ? nodes / seconds : 0.0, seconds > 0 ? baseline / seconds : 0.0);
+        if (threads == maxThreads) break;
+    }
+}
+
+static void Usage(const char *program) {
+    fprintf(stderr, "usage: %s [--hash MB] [--threads N] [DEPTH]\n", program);
+    fprintf(stderr, "       %s [--hash MB] --smp MAXTHREADS [DEPTH]\n", program);
+}
+
+int main(int argc, char **argv) {
+    int depth = 6;
+    int threads = 1;
+    int smpThreads = 0;
+    int hashMb = TT_DEFAULT_MB;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc) {
+            hashMb = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--smp") == 0 && i + 1 < argc) {
+            smpThreads = atoi(argv[++i]);
+        } else {
+            depth = atoi(argv[i]);
+        }
+    }
+    if (depth < 1 || threads < 1 || smpThreads < 0 || hashMb < 1) {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (!ResizeTable(hashMb)) {
+        fprintf(stderr, "cannot allocate a %d MB transposition table\n", hashMb);
+        return EXIT_FAILURE;
+    }
+
+    if (smpThreads > 0) {
+        printf("depth %d, %d cores online\n", depth, AvailableCores());
+        RunSpeedup(depth, smpThreads);
+        return EXIT_SUCCESS;
+    }
+
+    uint64_t totalNodes;
+    double totalSeconds;
+    RunBench(depth, threads, true, &totalNodes, &totalSeconds);
+    printf("total: nodes %llu time %.3fs nps %.0f\n", (unsigned long long)totalNodes, totalSeconds,
+           totalSeconds > 0 ? totalNodes / totalSeconds : 0.0);
+
+    TTSTATS stats;
+    GetTableStats(&stats);
+    printf("hash: %d MB%s  hit rate %.1f%%  stores %llu  collisions %llu\n", hashMb,
+           TableUsesHugePages() ? " huge pages" : "", stats.probes ? 100.0 * stats.hits / stats.probes : 0.0,
+           (unsigned long long)stats.stores, (unsigned long long)stats.collisions);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,233 @@
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "core/fen.h"
+#include "core/notation.h"
+#include "core/pgn.h"
+#include "engine/book.h"
+
+#define DEFAULT_BOOK_PLIES 16
+
+typedef struct BuildEntry {
+    uint64_t key;
+    uint16_t move;
+    uint32_t count;
+} BUILDENTRY;
+
+typedef struct BuildList {
+    BUILDENTRY *entries;
+    size_t count;
+    size_t capacity;
+} BUILDLIST;
+
+static void AddEntry(BUILDLIST *list, uint64_t key, uint16_t move) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 1 << 16;
+        list->entries = realloc(list->entries, list->capacity * sizeof(BUILDENTRY));
+        if (list->entries == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    list->entries[list->count++] = (BUILDENTRY){ key, move, 1 };
+}
+
+static int CompareEntries(const void *a, const void *b) {
+    const BUILDENTRY *x = a, *y = b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return (int)x->move - (int)y->move;
+}
+
+static void WriteBigEndian(unsigned char *bytes, uint64_t value, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+        bytes[i] = (unsigned char)value;
+        value >>= 8;
+    }
+}
+
+// Every move played in the first plies of every game, weighted by how often it was played
+static void CollectGame(const char *text, size_t length, int maxPlies, BUILDLIST *list) {
+    PGNLEXER lexer;
+    PGNTOKEN token;
+    POSITION pos;
+    int plies = 0;
+
+    InitPgnLexer(&lexer, text, length);
+    SetStartingPosition(&pos);
+
+    while (plies < maxPlies && NextPgnToken(&lexer, &token)) {
+        // Books describe the normal start position only
+        if (token.type == PGN_TOKEN_TAG && token.length == 3 && memcmp(token.text, "FEN", 3) == 0) return;
+        if (token.type != PGN_TOKEN_MOVE) continue;
+
+        MOVE move = ParseMove(&pos, token.text, token.length);
+        if (move == MOVE_NONE) return;
+
+        AddEntry(list, PolyglotKey(&pos), EncodePolyglotMove(move));
+        UNDO undo;
+        MakeMove(&pos, move, &undo);
+        plies++;
+    }
+}
+
+static int BuildBook(const char *pgnPath, const char *bookPath, int maxPlies, uint32_t minCount) {
+    int fd = open(pgnPath, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0) {
+        perror(pgnPath);
+        return EXIT_FAILURE;
+    }
+    const char *base = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+
+    BUILDLIST list = { 0 };
+    const char *cursor = base, *game;
+    size_t length, games = 0;
+    while (SplitPgnGame(&cursor, base + info.st_size, &game, &length)) {
+        CollectGame(game, length, maxPlies, &list);
+        games++;
+    }
+    munmap((void *)base, info.st_size);
+
+    qsort(list.entries, list.count, sizeof(BUILDENTRY), CompareEntries);
+
+    FILE *out = fopen(bookPath, "wb");
+    if (out == NULL) {
+        perror(bookPath);
+        return EXIT_FAILURE;
+    }
+
+    size_t written = 0;
+    for (size_t i = 0; i < list.count;) {
+        size_t j = i + 1;
+        uint32_t count = 1;
+        while (j < list.count && list.entries[j].key == list.entries[i].key && list.entries[j].move == list.entries[i].move) {
+            count++;
+            j++;
+        }
+        if (count >= minCount) {
+            unsigned char bytes[POLYGLOT_ENTRY_SIZE] = { 0 };
+            WriteBigEndian(bytes, list.entries[i].key, 8);
+            WriteBigEndian(bytes + 8, list.entries[i].move, 2);
+            WriteBigEndian(bytes + 10, count > 65535 ? 65535 : count, 2);
+            fwrite(bytes, 1, sizeof(bytes), out);
+            written++;
+        }
+        i = j;
+    }
+    fclose(out);
+    free(list.entries);
+
+    printf("%zu games, %zu book entries written to %s\n", games, written, bookPath);
+    return EXIT_SUCCESS;
+}
+
+static int ProbeBookFile(const char *bookPath, const char *fen) {
+    BOOK book;
+    POSITION pos;
+    if (!OpenBook(&book, bookPath)) {
+        perror(bookPath);
+        return EXIT_FAILURE;
+    }
+    if (!ParseFen(&pos, fen)) {
+        fprintf(stderr, "invalid FEN\n");
+        CloseBook(&book);
+        return EXIT_FAILURE;
+    }
+
+    MOVELIST legal;
+    GenerateLegalMoves(&pos, &legal);
+
+    size_t first;
+    size_t count = FindBookEntries(&book, PolyglotKey(&pos), &first);
+    printf("key %016llx, %zu book moves\n", (unsigned long long)PolyglotKey(&pos), count);
+    for (size_t i = first; i < first + count; i++) {
+        BOOKENTRY entry;
+        ReadBookEntry(&book, i, &entry);
+        MOVE move = DecodePolyglotMove(&legal, entry.move);
+
+        char text[MOVE_TEXT_SIZE] = "?";
+        if (move != MOVE_NONE) MoveToSan(&pos, move, text);
+        printf("%-8s weight %5u\n", text, entry.weight);
+    }
+    CloseBook(&book);
+    return EXIT_SUCCESS;
+}
+
+// Reference keys from the Polyglot book format description, UCI moves played from the start
+static const struct {
+    const char *moves;
+    uint64_t key;
+} referenceKeys[] = {
+    { "",                                     0x463B96181691FC9CULL },
+    { "e2e4",                                 0x823C9B50FD114196ULL },
+    { "e2e4 d7d5",                            0x0756B94461C50FB0ULL },
+    { "e2e4 d7d5 e4e5",                       0x662FAFB965DB29D4ULL },
+    { "e2e4 d7d5 e4e5 f7f5",                  0x22A48B5A8E47FF78ULL },
+    { "e2e4 d7d5 e4e5 f7f5 e1e2",             0x652A607CA3F242C1ULL },
+    { "e2e4 d7d5 e4e5 f7f5 e1e2 e8f7",        0x00FDD303C946BDD9ULL },
+    { "a2a4 b7b5 h2h4 b5b4 c2c4",             0x3C8123EA7B067637ULL },
+    { "a2a4 b7b5 h2h4 b5b4 c2c4 b4c3 a1a3",   0x5C3F9B829B279560ULL },
+};
+
+// Keys have to match the published ones for third-party books to be found at all
+static int CheckKeys(void) {
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(referenceKeys) / sizeof(referenceKeys[0]); i++) {
+        POSITION pos;
+        SetStartingPosition(&pos);
+
+        const char *text = referenceKeys[i].moves;
+        while (*text) {
+            size_t length = strcspn(text, " ");
+            MOVE move = ParseMove(&pos, text, length);
+            UNDO undo;
+            if (move != MOVE_NONE) MakeMove(&pos, move, &undo);
+            text += length;
+            text += strspn(text, " ");
+        }
+
+        uint64_t key = PolyglotKey(&pos);
+        bool ok = key == referenceKeys[i].key;
+        failures += !ok;
+        printf("%016llx  %s  %s\n", (unsigned long long)key, ok ? "ok      " : "MISMATCH",
+               *referenceKeys[i].moves ? referenceKeys[i].moves : "startpos");
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static void Usage(const char *program) {
+    fprintf(stderr, "usage: %s --build PGN BOOK [--plies N] [--min-count N]\n", program);
+    fprintf(stderr, "       %s --probe BOOK [FEN]\n", program);
+    fprintf(stderr, "       %s --check\n", program);
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 4 && strcmp(argv[1], "--build") == 0) {
+        int plies = DEFAULT_BOOK_PLIES;
+        uint32_t minCount = 1;
+        for (int i = 4; i + 1 < argc; i += 2) {
+            if (strcmp(argv[i], "--plies") == 0) plies = atoi(argv[i + 1]);
+            else if (strcmp(argv[i], "--min-count") == 0) minCount = (uint32_t)atoi(argv[i + 1]);
+        }
+        return BuildBook(argv[2], argv[3], plies, minCount);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--probe") == 0) {
+        return ProbeBookFile(argv[2], argc > 3 ? argv[3] : START_FEN);
+    }
+    if (argc == 2 && strcmp(argv[1], "--check") == 0) {
+        return CheckKeys();
+    }
+    Usage(argv[0]);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,316 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "core/fen.h"
+#include "core/notation.h"
+#include "engine/search.h"
+#include "engine/timer.h"
+#include "engine/tt.h"
+
+#define BATCH_LINES 64
+#define QUEUE_BATCHES 64
+#define MAX_OPERANDS 8
+
+typedef struct Batch {
+    long firstLine;
+    int count;
+    char *lines[BATCH_LINES];
+} BATCH;
+
+typedef struct RunnerOptions {
+    int threads;
+    int depth;
+    int moveTimeMs;
+    int maxPerftDepth;
+} RUNNEROPTIONS;
+
+typedef struct RunnerCounts {
+    uint64_t positions;
+    uint64_t failed;
+    uint64_t illegal;
+    uint64_t perftChecks;
+    uint64_t perftMismatches;
+    uint64_t bestMoveChecks;
+    uint64_t bestMoveMisses;
+} RUNNERCOUNTS;
+
+/*
+    Bounded batch queue between the reader and the pool, the reader blocks when the pool
+    falls behind so memory stays flat on files of any length
+*/
+static BATCH *queue[QUEUE_BATCHES];
+static int queueHead = 0;
+static int queueCount = 0;
+static bool readerDone = false;
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueNotEmpty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t queueNotFull = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t reportLock = PTHREAD_MUTEX_INITIALIZER;
+
+static RUNNEROPTIONS options = { .threads = 1, .depth = 6, .moveTimeMs = 0, .maxPerftDepth = 4 };
+
+static void PushBatch(BATCH *batch) {
+    pthread_mutex_lock(&queueLock);
+    while (queueCount == QUEUE_BATCHES) pthread_cond_wait(&queueNotFull, &queueLock);
+    queue[(queueHead + queueCount++) % QUEUE_BATCHES] = batch;
+    pthread_cond_signal(&queueNotEmpty);
+    pthread_mutex_unlock(&queueLock);
+}
+
+// NULL once the reader is done and the queue is drained
+static BATCH *PopBatch(void) {
+    pthread_mutex_lock(&queueLock);
+    while (queueCount == 0 && !readerDone) pthread_cond_wait(&queueNotEmpty, &queueLock);
+    BATCH *batch = NULL;
+    if (queueCount > 0) {
+        batch = queue[queueHead];
+        queueHead = (queueHead + 1) % QUEUE_BATCHES;
+        queueCount--;
+        pthread_cond_signal(&queueNotFull);
+    }
+    pthread_mutex_unlock(&queueLock);
+    return batch;
+}
+
+static void FinishReading(void) {
+    pthread_mutex_lock(&queueLock);
+    readerDone = true;
+    pthread_cond_broadcast(&queueNotEmpty);
+    pthread_mutex_unlock(&queueLock);
+}
+
+static void ReportMismatch(long line, const char *format, const char *detail) {
+    pthread_mutex_lock(&reportLock);
+    fprintf(stderr, "line %ld: ", line);
+    fprintf(stderr, format, detail);
+    fputc('\n', stderr);
+    pthread_mutex_unlock(&reportLock);
+}
+
+static char *Trim(char *text) {
+    while (*text == ' ' || *text == '\t') text++;
+    char *end = text + strlen(text);
+    while (end > text && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n')) end--;
+    *end = '\0';
+    return text;
+}
+
+/*
+    Operations after the position are "opcode operand ...;", the ones checked are
+    bm and am (best and avoid moves, SAN) and D1..Dn (perft counts, as in perftsuite.epd)
+*/
+static bool CheckBestMove(POSITION *pos, char *bm, char *am, long line, RUNNERCOUNTS *counts) {
+    SEARCHLIMITS limits = { .depth = options.moveTimeMs ? 0 : options.depth, .moveTimeMs = options.moveTimeMs, .threads = 1 };
+    SEARCHRESULT result;
+    SearchPosition(pos, NULL, 0, &limits, &result);
+    counts->bestMoveChecks++;
+
+    // Mate or stalemate on the board, there is no move to compare with the bm/am list
+    if (result.bestMove == MOVE_NONE) {
+        counts->bestMoveMisses++;
+        ReportMismatch(line, "%s", "no legal moves for bm/am");
+        return false;
+    }
+
+    char played[MOVE_TEXT_SIZE];
+    MoveToSan(pos, result.bestMove, played);
+
+    bool listed = false, avoided = false;
+    char *save;
+    for (char *token = bm ? strtok_r(bm, " ", &save) : NULL; token; token = strtok_r(NULL, " ", &save)) {
+        MOVE move = ParseMove(pos, token, strlen(token));
+        if (move == MOVE_NONE) ReportMismatch(line, "unresolvable bm %s", token);
+        if (move == result.bestMove) listed = true;
+    }
+    for (char *token = am ? strtok_r(am, " ", &save) : NULL; token; token = strtok_r(NULL, " ", &save)) {
+        MOVE move = ParseMove(pos, token, strlen(token));
+        if (move == MOVE_NONE) ReportMismatch(line, "unresolvable am %s", token);
+        if (move == result.bestMove) avoided = true;
+    }
+
+    if ((bm && !listed) || avoided) {
+        counts->bestMoveMisses++;
+        ReportMismatch(line, "engine played %s", played);
+        return false;
+    }
+    return true;
+}
+
+// Past the four position fields and the optional FEN move counters, the rest are operations
+static char *SplitOperations(char *record) {
+    char *end = record;
+    for (int field = 0; field < 6; field++) {
+        char *text = end;
+        while (*text == ' ' || *text == '\t') text++;
+        if (*text == '\0' || *text == ';' || (field >= 4 && (*text < '0' || *text > '9'))) break;
+        while (*text && *text != ' ' && *text != '\t' && *text != ';') text++;
+        end = text;
+    }
+    if (*end == '\0') return NULL;
+
+    *end = '\0';
+    return end + 1;
+}
+
+static bool CheckRecord(char *record, long line, RUNNERCOUNTS *counts) {
+    char *operations = SplitOperations(record);
+
+    POSITION pos;
+    if (!ParseFen(&pos, record)) {
+        counts->illegal++;
+        ReportMismatch(line, "illegal position %s", record);
+        return false;
+    }
+
+    bool passed = true;
+    char *bm = NULL, *am = NULL;
+    char *save;
+    for (char *op = operations ? strtok_r(operations, ";", &save) : NULL; op; op = strtok_r(NULL, ";", &save)) {
+        op = Trim(op);
+        if (strncmp(op, "bm ", 3) == 0) {
+            bm = op + 3;
+        } else if (strncmp(op, "am ", 3) == 0) {
+            am = op + 3;
+        } else if (op[0] == 'D' && op[1] >= '1' && op[1] <= '9') {
+            char *end;
+            int depth = (int)strtol(op + 1, &end, 10);
+            uint64_t expected = strtoull(end, NULL, 10);
+            if (depth > options.maxPerftDepth) continue;
+
+            counts->perftChecks++;
+            uint64_t nodes = Perft(&pos, depth);
+            if (nodes != expected) {
+                char detail[64];
+                snprintf(detail, sizeof(detail), "D%d %llu, expected %llu", depth, (unsigned long long)nodes,
+                         (unsigned long long)expected);
+                counts->perftMismatches++;
+                ReportMismatch(line, "perft %s", detail);
+                passed = false;
+            }
+        }
+    }
+
+    if (bm || am) passed = CheckBestMove(&pos, bm, am, line, counts) && passed;
+    return passed;
+}
+
+static void *WorkerMain(void *argument) {
+    RUNNERCOUNTS *counts = argument;
+    BATCH *batch;
+
+    while ((batch = PopBatch()) != NULL) {
+        for (int i = 0; i < batch->count; i++) {
+            counts->positions++;
+            if (!CheckRecord(batch->lines[i], batch->firstLine + i, counts)) counts->failed++;
+            free(batch->lines[i]);
+        }
+        free(batch);
+    }
+    return NULL;
+}
+
+// Streams the file line by line, blank lines and # comments are skipped but still counted
+static void ReadRecords(FILE *file) {
+    char *line = NULL;
+    size_t capacity = 0;
+    long number = 0;
+    BATCH *batch = NULL;
+
+    while (getline(&line, &capacity, file) != -1) {
+        number++;
+        char *record = Trim(line);
+        if (*record == '\0' || *record == '#') continue;
+
+        if (batch == NULL) {
+            batch = malloc(sizeof(BATCH));
+            batch->firstLine = number;
+            batch->count = 0;
+        }
+        // Line numbers inside a batch must stay consecutive for the reports
+        if (batch->count > 0 && batch->firstLine + batch->count != number) {
+            PushBatch(batch);
+            batch = malloc(sizeof(BATCH));
+            batch->firstLine = number;
+            batch->count = 0;
+        }
+        batch->lines[batch->count++] = strdup(record);
+        if (batch->count == BATCH_LINES) {
+            PushBatch(batch);
+            batch = NULL;
+        }
+    }
+    if (batch) PushBatch(batch);
+    free(line);
+}
+
+static void Usage(const char *program) {
+    fprintf(stderr, "usage: %s [--threads N] [--depth D | --movetime MS] [--hash MB] [--perft-depth D] FILE|-\n", program);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    int hashMb = TT_DEFAULT_MB;
+    bool badArguments = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) options.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) options.depth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--movetime") == 0 && i + 1 < argc) options.moveTimeMs = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc) hashMb = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--perft-depth") == 0 && i + 1 < argc) options.maxPerftDepth = atoi(argv[++i]);
+        else if (path == NULL) path = argv[i];
+        else badArguments = true;
+    }
+    if (badArguments || path == NULL || options.threads < 1 || options.depth < 1 || options.moveTimeMs < 0 || hashMb < 1) {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+    ResizeTable(hashMb);
+
+    double start = NowSeconds();
+    pthread_t *threads = malloc(sizeof(pthread_t) * options.threads);
+    RUNNERCOUNTS *counts = calloc(options.threads, sizeof(RUNNERCOUNTS));
+    for (int i = 0; i < options.threads; i++) {
+        pthread_create(&threads[i], NULL, WorkerMain, &counts[i]);
+    }
+
+    ReadRecords(file);
+    FinishReading();
+
+    RUNNERCOUNTS total = { 0 };
+    for (int i = 0; i < options.threads; i++) {
+        pthread_join(threads[i], NULL);
+        total.positions += counts[i].positions;
+        total.failed += counts[i].failed;
+        total.illegal += counts[i].illegal;
+        total.perftChecks += counts[i].perftChecks;
+        total.perftMismatches += counts[i].perftMismatches;
+        total.bestMoveChecks += counts[i].bestMoveChecks;
+        total.bestMoveMisses += counts[i].bestMoveMisses;
+    }
+    double seconds = NowSeconds() - start;
+    if (file != stdin) fclose(file);
+
+    printf("positions %llu  passed %llu  failed %llu  time %.3fs  %.0f positions/s  threads %d\n",
+           (unsigned long long)total.positions, (unsigned long long)(total.positions - total.failed),
+           (unsigned long long)total.failed, seconds, seconds > 0 ? total.positions / seconds : 0.0, options.threads);
+    printf("illegal %llu  perft %llu/%llu mismatched  best move %llu/%llu missed\n",
+           (unsigned long long)total.illegal, (unsigned long long)total.perftMismatches,
+           (unsigned long long)total.perftChecks, (unsigned long long)total.bestMoveMisses,
+           (unsigned long long)total.bestMoveChecks);
+
+    free(threads);
+    free(counts);
+    FreeTable();
+    return total.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,323 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "engine/analysis.h"
+#include "engine/session.h"
+#include "engine/timer.h"
+
+#define MAX_CONNECTIONS 256
+#define STATS_REQUEST -1
+
+typedef struct LoadOptions {
+    const char *socketPath;
+    int connections;
+    int games;
+    int plies;
+    double seconds;
+    uint32_t clockMs;
+    uint32_t incrementMs;
+} LOADOPTIONS;
+
+typedef struct LoadGame {
+    uint32_t id;
+    int ply;
+    double sentAt;
+    POSITION pos;
+} LOADGAME;
+
+/*
+    The server answers a connection's requests in order, so a queue of the game each
+    request was for is all it takes to match replies, one request in flight per game
+    Requests wait in output until poll says the socket has room, outputSent is how far they went
+*/
+typedef struct Client {
+    int fd;
+    LOADGAME *games;
+    int *requests;
+    int requestHead;
+    int requestCount;
+    unsigned char input[64 * GAME_MAX_FRAME];
+    size_t used;
+    unsigned char *output;
+    size_t outputUsed;
+    size_t outputSent;
+} CLIENT;
+
+typedef struct LoadCounts {
+    uint64_t moves;
+    uint64_t games;
+    uint64_t rejected;
+    uint64_t endings[SESSION_MOVE_LIMIT + 1];
+} LOADCOUNTS;
+
+static LOADOPTIONS options = { GAME_SOCKET_PATH, 8, 1000, 80, 10.0, 600000, 1000 };
+static LOADCOUNTS counts;
+static LATENCYHISTOGRAM latency;
+static GAMEMESSAGE statsReply;
+static bool haveStats = false;
+static uint64_t randomState = 0x9E3779B97F4A7C15ull;
+static bool running = true;
+
+static uint64_t NextRandom(void) {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 7;
+    randomState ^= randomState << 17;
+    return randomState;
+}
+
+static int Connect(const char *path) {
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(address.sun_path)) return -1;
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+
+    // The server stops reading a client that is behind on its replies, so neither side may block on a write
+    if (fd >= 0) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+// Sends what the socket takes without blocking, false when the server went away
+static bool Flush(CLIENT *client) {
+    while (client->outputSent < client->outputUsed) {
+        ssize_t written = send(client->fd, client->output + client->outputSent, client->outputUsed - client->outputSent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (written <= 0) return false;
+        client->outputSent += (size_t)written;
+    }
+
+    // Unsent requests move to the front, there is never more of them than requests in flight
+    memmove(client->output, client->output + client->outputSent, client->outputUsed - client->outputSent);
+    client->outputUsed -= client->outputSent;
+    client->outputSent = 0;
+    return true;
+}
+
+static void Queue(CLIENT *client, int game, const GAMEMESSAGE *message) {
+    client->outputUsed += EncodeGameMessage(message, client->output + client->outputUsed);
+    client->requests[(client->requestHead + client->requestCount++) % (options.games + 1)] = game;
+    if (game != STATS_REQUEST) client->games[game].sentAt = NowSeconds();
+}
+
+static void StartGame(CLIENT *client, int game) {
+    GAMEMESSAGE message = { .type = GAME_MSG_NEW_GAME, .tag = (uint32_t)game, .solo = 1,
+                            .clockMs = options.clockMs, .incrementMs = options.incrementMs };
+    Queue(client, game, &message);
+}
+
+// A random legal move, played locally at once since the server must accept it
+static void SendMove(CLIENT *client, int game) {
+    LOADGAME *state = &client->games[game];
+    MOVELIST moves;
+    GenerateLegalMoves(&state->pos, &moves);
+
+    GAMEMESSAGE message = { .type = GAME_MSG_MOVE, .game = state->id };
+    MOVE move = moves.moves[NextRandom() % moves.count];
+    MoveToUci(move, message.move);
+    UNDO undo;
+    MakeMove(&state->pos, move, &undo);
+    state->ply++;
+    Queue(client, game, &message);
+}
+
+static void HandleReply(CLIENT *client, const GAMEMESSAGE *reply) {
+    int game = client->requests[client->requestHead];
+    client->requestHead = (client->requestHead + 1) % (options.games + 1);
+    client->requestCount--;
+    if (game == STATS_REQUEST) {
+        statsReply = *reply;
+        haveStats = reply->type == GAME_MSG_STATS_REPLY;
+        return;
+    }
+
+    LOADGAME *state = &client->games[game];
+    AddLatency(&latency, (uint64_t)((NowSeconds() - state->sentAt) * 1e6));
+
+    if (reply->type == GAME_MSG_CREATED) {
+        state->id = reply->game;
+        state->ply = 0;
+        SetStartingPosition(&state->pos);
+        if (state->id == SESSION_NONE) {
+            counts.rejected++;
+            if (running) StartGame(client, game);
+        } else if (running) {
+            SendMove(client, game);
+        }
+        return;
+    }
+
+    if (reply->status != SESSION_MOVE_OK) counts.rejected++;
+    else if (reply->move[0]) counts.moves++;
+
+    if (reply->status != SESSION_MOVE_OK || reply->result != SESSION_ONGOING) {
+        // Finished, resigned or out of step with the server, the game is over either way
+        counts.games++;
+        if (reply->ending <= SESSION_MOVE_LIMIT) counts.endings[reply->ending]++;
+        state->id = SESSION_NONE;
+        if (running) StartGame(client, game);
+    } else if (running && state->ply >= options.plies) {
+        GAMEMESSAGE message = { .type = GAME_MSG_RESIGN, .game = state->id };
+        Queue(client, game, &message);
+    } else if (running) {
+        SendMove(client, game);
+    }
+}
+
+// Reads what is there and queues the answers, false when the server went away
+static bool ServeClient(CLIENT *client) {
+    ssize_t bytes = read(client->fd, client->input + client->used, sizeof(client->input) - client->used);
+    if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return true;
+    if (bytes <= 0) return false;
+    client->used += (size_t)bytes;
+
+    long frameSize;
+    size_t offset = 0;
+    while ((frameSize = GameFrameSize(client->input + offset, client->used - offset)) > 0) {
+        GAMEMESSAGE reply;
+        if (!DecodeGameMessage(client->input + offset + GAME_FRAME_HEADER, (size_t)frameSize - GAME_FRAME_HEADER, &reply) ||
+            client->requestCount == 0) {
+            return false;
+        }
+        HandleReply(client, &reply);
+        offset += (size_t)frameSize;
+    }
+    if (frameSize < 0) return false;
+    memmove(client->input, client->input + offset, client->used - offset);
+    client->used -= offset;
+    return true;
+}
+
+/*
+    One round of the loop: replies are read on every connection whatever is waiting to be sent,
+    queued requests go out only where the socket has room
+    Returns the number of ready connections, -1 when the server closed one
+*/
+static int PollClients(CLIENT *clients, struct pollfd *polls, int timeoutMs) {
+    for (int i = 0; i < options.connections; i++) {
+        polls[i].events = POLLIN | (clients[i].outputSent < clients[i].outputUsed ? POLLOUT : 0);
+    }
+    int ready = poll(polls, options.connections, timeoutMs);
+    if (ready < 0) return errno == EINTR ? 0 : -1;
+
+    for (int i = 0; i < options.connections; i++) {
+        if ((polls[i].revents & (POLLIN | POLLHUP | POLLERR)) && !ServeClient(&clients[i])) return -1;
+        if ((polls[i].revents & POLLOUT) && !Flush(&clients[i])) return -1;
+    }
+    return ready;
+}
+
+// Waits for every request still in flight, true if all were answered
+static bool Drain(CLIENT *clients, struct pollfd *polls) {
+    for (;;) {
+        bool idle = true;
+        for (int i = 0; i < options.connections; i++) idle = idle && clients[i].requestCount == 0;
+        if (idle) return true;
+        if (PollClients(clients, polls, 5000) <= 0) return false;
+    }
+}
+
+static void Usage(const char *program) {
+    fprintf(stderr, "usage: %s [--socket PATH] [--connections N] [--games N] [--plies N] [--seconds S]\n", program);
+    fprintf(stderr, "          [--clock MS] [--increment MS]\n");
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (value && strcmp(argv[i], "--socket") == 0) options.socketPath = value;
+        else if (value && strcmp(argv[i], "--connections") == 0) options.connections = atoi(value);
+        else if (value && strcmp(argv[i], "--games") == 0) options.games = atoi(value);
+        else if (value && strcmp(argv[i], "--plies") == 0) options.plies = atoi(value);
+        else if (value && strcmp(argv[i], "--seconds") == 0) options.seconds = atof(value);
+        else if (value && strcmp(argv[i], "--clock") == 0) options.clockMs = (uint32_t)strtoul(value, NULL, 10);
+        else if (value && strcmp(argv[i], "--increment") == 0) options.incrementMs = (uint32_t)strtoul(value, NULL, 10);
+        else {
+            Usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        i++;
+    }
+    if (options.connections < 1 || options.connections > MAX_CONNECTIONS || options.games < 1 ||
+        options.plies < 1 || options.seconds <= 0) {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    CLIENT *clients = calloc(options.connections, sizeof(CLIENT));
+    struct pollfd polls[MAX_CONNECTIONS];
+    for (int i = 0; i < options.connections; i++) {
+        CLIENT *client = &clients[i];
+        client->fd = Connect(options.socketPath);
+        if (client->fd < 0) {
+            perror(options.socketPath);
+            return EXIT_FAILURE;
+        }
+        polls[i] = (struct pollfd){ .fd = client->fd, .events = POLLIN };
+        client->games = calloc(options.games, sizeof(LOADGAME));
+        client->requests = malloc((options.games + 1) * sizeof(int));
+        client->output = malloc((size_t)(options.games + 1) * GAME_MAX_FRAME);
+
+        // Queued only, the loop sends them as the server reads
+        for (int game = 0; game < options.games; game++) StartGame(client, game);
+    }
+
+    double start = NowSeconds();
+    while (NowSeconds() - start < options.seconds) {
+        if (PollClients(clients, polls, 1000) < 0) {
+            fprintf(stderr, "server closed the connection\n");
+            return EXIT_FAILURE;
+        }
+    }
+    double seconds = NowSeconds() - start;
+    running = false;
+
+    // Every game is still open on the server, its memory figures are for the full load
+    GAMEMESSAGE stats = { .type = GAME_MSG_STATS };
+    bool drained = Drain(clients, polls);
+    if (drained) {
+        Queue(&clients[0], STATS_REQUEST, &stats);
+        drained = Drain(clients, polls);
+    }
+
+    int concurrent = options.connections * options.games;
+    printf("%d games over %d connections for %.2fs: %llu moves, %.0f moves/s, %llu games finished\n", concurrent,
+           options.connections, seconds, (unsigned long long)counts.moves, counts.moves / seconds,
+           (unsigned long long)counts.games);
+    printf("latency  p50 %.2f ms  p90 %.2f ms  p99 %.2f ms  max %.2f ms\n", LatencyPercentile(&latency, 50) / 1000.0,
+           LatencyPercentile(&latency, 90) / 1000.0, LatencyPercentile(&latency, 99) / 1000.0, latency.maxMicros / 1000.0);
+    printf("endings  mate %llu  stalemate %llu  repetition %llu  fifty %llu  material %llu  resigned %llu  rejected %llu\n",
+           (unsigned long long)counts.endings[SESSION_CHECKMATE], (unsigned long long)counts.endings[SESSION_STALEMATE],
+           (unsigned long long)counts.endings[SESSION_REPETITION], (unsigned long long)counts.endings[SESSION_FIFTY_MOVES],
+           (unsigned long long)counts.endings[SESSION_DEAD_POSITION], (unsigned long long)counts.endings[SESSION_RESIGNATION],
+           (unsigned long long)counts.rejected);
+    if (haveStats && statsReply.liveGames > 0) {
+        printf("server   %u live games, %.0f bytes/game in use (%.0f moves), %.0f bytes/game reserved, %.1f MB pool\n",
+               statsReply.liveGames, sizeof(GAMESESSION) + (double)statsReply.moveBytes / statsReply.liveGames,
+               (double)statsReply.moveBytes / statsReply.liveGames, (double)statsReply.poolBytes / statsReply.liveGames,
+               statsReply.poolBytes / (1024.0 * 1024.0));
+    } else {
+        printf("server   no stats reply\n");
+    }
+
+    for (int i = 0; i < options.connections; i++) {
+        close(clients[i].fd);
+        free(clients[i].games);
+        free(clients[i].requests);
+        free(clients[i].output);
+    }
+    free(clients);
+    return (drained && counts.rejected == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,472 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "engine/session.h"
+#include "engine/timer.h"
+
+#define MAX_CONNECTIONS 4096
+#define MAX_EVENTS 256
+#define RECEIVE_BUFFER (64 * GAME_MAX_FRAME)
+#define SEND_BUFFER_START 4096
+#define CONNECTION_SLOT_BITS 16
+
+// Unsent replies past the high water stop reading from the client, past the limit it is dropped
+#define SEND_BUFFER_HIGH_WATER (256 * GAME_MAX_FRAME)
+#define SEND_BUFFER_LIMIT (1024 * GAME_MAX_FRAME)
+
+/*
+    A client connection, the token in its low bits is its slot and the high bits count
+    connections so a token left in a finished game never matches a later client
+    Closed connections stay in their slot until the end of the loop iteration
+    games holds the ids of the games it created or joined, ended ones are pruned as it grows
+*/
+typedef struct Connection {
+    int fd;
+    uint32_t token;
+    bool closed;
+    bool pending;
+    bool overflowed;
+    uint32_t watching;
+    unsigned char input[RECEIVE_BUFFER];
+    size_t used;
+    unsigned char *output;
+    size_t outputUsed;
+    size_t outputSent;
+    size_t outputSize;
+    uint32_t *games;
+    uint32_t gameCount;
+    uint32_t gameCapacity;
+} CONNECTION;
+
+static CONNECTION *connections[MAX_CONNECTIONS];
+static int pendingSlots[MAX_CONNECTIONS];
+static int pendingCount = 0;
+static uint32_t connectionSerial = 0;
+
+static SESSIONPOOL pool;
+static uint64_t movesPlayed = 0;
+static uint64_t gamesFinished = 0;
+static int epollFd;
+static volatile sig_atomic_t interrupted = 0;
+
+static void OnSignal(int signal) {
+    (void)signal;
+    interrupted = 1;
+}
+
+static uint64_t NowMs(void) {
+    return (uint64_t)(NowSeconds() * 1000.0);
+}
+
+static CONNECTION *FindConnection(uint32_t token) {
+    CONNECTION *connection = connections[token & (MAX_CONNECTIONS - 1)];
+    return (token && connection && !connection->closed && connection->token == token) ? connection : NULL;
+}
+
+static void MarkPending(CONNECTION *connection) {
+    if (connection->pending) return;
+    connection->pending = true;
+    pendingSlots[pendingCount++] = (int)(connection->token & (MAX_CONNECTIONS - 1));
+}
+
+// Replies collect in the output buffer and go out in one write per connection and iteration
+static void Send(uint32_t token, const GAMEMESSAGE *message) {
+    CONNECTION *connection = FindConnection(token);
+    if (!connection || connection->overflowed) return;
+
+    // A client that never reads is closed by FlushPending rather than buffered for without end
+    if (connection->outputUsed + GAME_MAX_FRAME > SEND_BUFFER_LIMIT) {
+        connection->overflowed = true;
+        MarkPending(connection);
+        return;
+    }
+    if (connection->outputUsed + GAME_MAX_FRAME > connection->outputSize) {
+        size_t size = connection->outputSize ? connection->outputSize * 2 : SEND_BUFFER_START;
+        unsigned char *output = realloc(connection->output, size);
+        if (!output) return;
+        connection->output = output;
+        connection->outputSize = size;
+    }
+    connection->outputUsed += EncodeGameMessage(message, connection->output + connection->outputUsed);
+    MarkPending(connection);
+}
+
+static void TrackGame(CONNECTION *connection, uint32_t id) {
+    if (connection->gameCount == connection->gameCapacity) {
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < connection->gameCount; i++) {
+            if (FindSession(&pool, connection->games[i])) connection->games[kept++] = connection->games[i];
+        }
+        connection->gameCount = kept;
+    }
+    if (connection->gameCount == connection->gameCapacity) {
+        uint32_t capacity = connection->gameCapacity ? connection->gameCapacity * 2 : 8;
+        uint32_t *games = realloc(connection->games, capacity * sizeof(*games));
+        if (!games) return;
+        connection->games = games;
+        connection->gameCapacity = capacity;
+    }
+    connection->games[connection->gameCount++] = id;
+}
+
+static void SendMoved(uint32_t token, const GAMESESSION *session, uint32_t id, SESSIONMOVESTATUS status, const char *move) {
+    GAMEMESSAGE reply = { .type = GAME_MSG_MOVED, .game = id, .status = (uint8_t)status };
+    if (session) {
+        reply.result = session->result;
+        reply.ending = session->ending;
+        reply.ply = session->plyCount;
+        reply.clocks[0] = session->clockMs[0];
+        reply.clocks[1] = session->clockMs[1];
+    }
+    if (move) snprintf(reply.move, sizeof(reply.move), "%s", move);
+    Send(token, &reply);
+}
+
+// Players hear about the end of the game unless they were already told, informed and alsoInformed are 0 when unused
+static void FinishGame(GAMESESSION *session, uint32_t id, uint32_t informed, uint32_t alsoInformed) {
+    for (int color = COLOR_WHITE; color <= COLOR_BLACK; color++) {
+        uint32_t player = session->players[color];
+        if (player && player != informed && player != alsoInformed &&
+            (color == COLOR_WHITE || player != session->players[COLOR_WHITE])) {
+            SendMoved(player, session, id, SESSION_MOVE_OK, NULL);
+        }
+    }
+    EndSession(&pool, id);
+    gamesFinished++;
+}
+
+static void HandleMessage(CONNECTION *connection, const GAMEMESSAGE *message) {
+    uint32_t token = connection->token;
+    GAMESESSION *session = FindSession(&pool, message->game);
+
+    switch (message->type) {
+        case GAME_MSG_NEW_GAME: {
+            uint32_t id = CreateSession(&pool, token, message->solo ? token : 0, message->clockMs,
+                                        message->incrementMs, NowMs());
+            GAMEMESSAGE reply = { .type = GAME_MSG_CREATED, .tag = message->tag, .game = id };
+            if (id != SESSION_NONE) TrackGame(connection, id);
+            Send(token, &reply);
+            break;
+        }
+        case GAME_MSG_JOIN: {
+            bool open = session && session->players[COLOR_BLACK] == 0 && session->players[COLOR_WHITE] != token;
+            GAMEMESSAGE reply = { .type = GAME_MSG_JOINED, .game = message->game,
+                                  .status = open ? SESSION_MOVE_OK : SESSION_MOVE_NO_GAME };
+            if (open) {
+                // White's clock starts when there is someone to play
+                session->players[COLOR_BLACK] = token;
+                session->lastMoveMs = NowMs();
+                TrackGame(connection, message->game);
+                Send(session->players[COLOR_WHITE], &reply);
+            }
+            Send(token, &reply);
+            break;
+        }
+        case GAME_MSG_MOVE: {
+            char played[MOVE_TEXT_SIZE] = "";
+            SESSIONMOVESTATUS status = SESSION_MOVE_NO_GAME;
+            if (session && session->players[COLOR_BLACK] == 0) {
+                status = SESSION_MOVE_NOT_YOUR_TURN;
+            } else if (session) {
+                status = PlaySessionMove(&pool, session, token, message->move, strlen(message->move), NowMs(), played);
+            }
+            if (status == SESSION_MOVE_OK) movesPlayed++;
+
+            // The opponent's copy of a played move already carries the result
+            uint32_t opponent = 0;
+            SendMoved(token, session, message->game, status, played);
+            if (status == SESSION_MOVE_OK) {
+                opponent = session->players[session->position.sideToMove];
+                if (opponent != token) SendMoved(opponent, session, message->game, status, played);
+            }
+            if (session && session->result != SESSION_ONGOING) FinishGame(session, message->game, token, opponent);
+            break;
+        }
+        case GAME_MSG_RESIGN:
+            if (session) ResignSession(session, token);
+            if (session && session->result != SESSION_ONGOING) {
+                SendMoved(token, session, message->game, SESSION_MOVE_OK, NULL);
+                FinishGame(session, message->game, token, 0);
+            } else {
+                SendMoved(token, NULL, message->game, SESSION_MOVE_NO_GAME, NULL);
+            }
+            break;
+        case GAME_MSG_STATS: {
+            GAMEMESSAGE reply = { .type = GAME_MSG_STATS_REPLY, .liveGames = pool.liveCount, .movesPlayed = movesPlayed,
+                                  .poolBytes = SessionPoolBytes(&pool), .moveBytes = SessionMoveBytes(&pool) };
+            Send(token, &reply);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// Every complete frame in the input buffer, false if the client has to be dropped
+static bool HandleFrames(CONNECTION *connection) {
+    long frameSize;
+    size_t offset = 0;
+    while ((frameSize = GameFrameSize(connection->input + offset, connection->used - offset)) > 0) {
+        GAMEMESSAGE message;
+        if (!DecodeGameMessage(connection->input + offset + GAME_FRAME_HEADER, (size_t)frameSize - GAME_FRAME_HEADER, &message)) {
+            return false;
+        }
+        HandleMessage(connection, &message);
+        offset += (size_t)frameSize;
+    }
+    if (frameSize < 0) return false;
+
+    memmove(connection->input, connection->input + offset, connection->used - offset);
+    connection->used -= offset;
+    return true;
+}
+
+// Games of a departing client are resigned for it, its slot is freed after the iteration
+static void CloseConnection(CONNECTION *connection) {
+    if (connection->closed) return;
+    connection->closed = true;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+
+    // Ids of ended games no longer resolve, the generation in the id has moved on
+    uint32_t token = connection->token;
+    for (uint32_t i = 0; i < connection->gameCount; i++) {
+        uint32_t id = connection->games[i];
+        GAMESESSION *session = FindSession(&pool, id);
+        if (!session || (session->players[COLOR_WHITE] != token && session->players[COLOR_BLACK] != token)) continue;
+
+        ResignSession(session, token);
+        if (session->players[COLOR_BLACK] == 0) session->result = SESSION_DRAWN;
+        FinishGame(session, id, token, 0);
+    }
+    MarkPending(connection);
+}
+
+// Reads stop while the client is behind on its replies, writes are watched while some are unsent
+static void UpdateEvents(CONNECTION *connection) {
+    uint32_t events = (connection->outputUsed < SEND_BUFFER_HIGH_WATER ? EPOLLIN : 0) |
+                      (connection->outputSent < connection->outputUsed ? EPOLLOUT : 0);
+    if (connection->watching == events) return;
+    struct epoll_event event = { .events = events, .data.ptr = connection };
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+    connection->watching = events;
+}
+
+// False when the client is gone, closing is left to the caller
+static bool Flush(CONNECTION *connection) {
+    while (connection->outputSent < connection->outputUsed) {
+        ssize_t written = send(connection->fd, connection->output + connection->outputSent,
+                               connection->outputUsed - connection->outputSent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (written <= 0) return false;
+        connection->outputSent += (size_t)written;
+    }
+
+    // What is left moves to the front, so the buffer only ever holds unsent replies
+    memmove(connection->output, connection->output + connection->outputSent, connection->outputUsed - connection->outputSent);
+    connection->outputUsed -= connection->outputSent;
+    connection->outputSent = 0;
+    UpdateEvents(connection);
+    return true;
+}
+
+/*
+    A connection is listed at most once while its pending flag is set, closing one during the
+    flush can queue messages for others, they are taken in the next round
+*/
+static void FlushPending(void) {
+    static int flushing[MAX_CONNECTIONS];
+    while (pendingCount > 0) {
+        int count = pendingCount;
+        memcpy(flushing, pendingSlots, count * sizeof(int));
+        pendingCount = 0;
+
+        for (int i = 0; i < count; i++) {
+            CONNECTION *connection = connections[flushing[i]];
+            if (!connection->closed && (connection->overflowed || !Flush(connection))) CloseConnection(connection);
+            connection->pending = false;
+            if (connection->closed) {
+                free(connection->output);
+                free(connection->games);
+                free(connection);
+                connections[flushing[i]] = NULL;
+            }
+        }
+    }
+}
+
+static void AcceptConnections(int listener) {
+    int fd;
+    while ((fd = accept(listener, NULL, NULL)) >= 0) {
+        int slot = 0;
+        while (slot < MAX_CONNECTIONS && connections[slot]) slot++;
+        CONNECTION *connection = (slot < MAX_CONNECTIONS) ? calloc(1, sizeof(CONNECTION)) : NULL;
+        if (!connection) {
+            close(fd);
+            continue;
+        }
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        connection->fd = fd;
+        connection->token = (++connectionSerial << CONNECTION_SLOT_BITS) | (uint32_t)slot;
+        if (connection->token == 0) connection->token = (++connectionSerial << CONNECTION_SLOT_BITS) | (uint32_t)slot;
+        connections[slot] = connection;
+
+        struct epoll_event event = { .events = EPOLLIN, .data.ptr = connection };
+        connection->watching = EPOLLIN;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+static void ReadConnection(CONNECTION *connection) {
+    while (!connection->closed) {
+        // Backed up, reading resumes from FlushPending once the client has taken its replies
+        if (connection->outputUsed >= SEND_BUFFER_HIGH_WATER || connection->overflowed) {
+            MarkPending(connection);
+            return;
+        }
+
+        ssize_t bytes = read(connection->fd, connection->input + connection->used, RECEIVE_BUFFER - connection->used);
+        if (bytes < 0 && errno == EINTR) continue;
+        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (bytes <= 0) {
+            CloseConnection(connection);
+            return;
+        }
+        connection->used += (size_t)bytes;
+        if (!HandleFrames(connection)) {
+            CloseConnection(connection);
+            return;
+        }
+    }
+}
+
+// Flags fall on the clock even when the side to move never sends anything
+static void SweepClocks(uint64_t nowMs) {
+    for (uint32_t slot = 0; slot < SessionSlotCount(&pool); slot++) {
+        GAMESESSION *session = SessionAtSlot(&pool, slot);
+        if (session->live && session->players[COLOR_BLACK] && CheckSessionClock(session, nowMs)) {
+            FinishGame(session, SessionId(session), 0, 0);
+        }
+    }
+}
+
+static void Report(double seconds, uint64_t moves, const char *label) {
+    size_t poolBytes = SessionPoolBytes(&pool), moveBytes = SessionMoveBytes(&pool);
+    uint32_t live = pool.liveCount;
+    printf("%s %9.0f moves/s  live %7u  finished %9llu  bytes/game %4zu + %4.0f moves  pool %6.1f MB\n",
+           label, seconds > 0 ? moves / seconds : 0.0, live, (unsigned long long)gamesFinished,
+           sizeof(GAMESESSION), live ? (double)moveBytes / live : 0.0, poolBytes / (1024.0 * 1024.0));
+    fflush(stdout);
+}
+
+static int OpenListener(const char *path) {
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "%s: socket path too long\n", path);
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, 128) != 0) {
+        perror(path);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+static void Usage(const char *program) {
+    fprintf(stderr, "usage: %s [--socket PATH] [--report SECONDS]\n", program);
+}
+
+int main(int argc, char **argv) {
+    const char *socketPath = GAME_SOCKET_PATH;
+    int reportSeconds = 5;
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 < argc && strcmp(argv[i], "--socket") == 0) socketPath = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--report") == 0) reportSeconds = atoi(argv[++i]);
+        else {
+            Usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (reportSeconds < 1) {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int listener = OpenListener(socketPath);
+    if (listener < 0) return EXIT_FAILURE;
+
+    struct sigaction action = { .sa_handler = OnSignal };
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    InitSessionPool(&pool);
+    epollFd = epoll_create1(0);
+    struct epoll_event listenEvent = { .events = EPOLLIN, .data.ptr = NULL };
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listener, &listenEvent);
+    printf("listening on %s, %zu bytes per game plus %zu per %d moves\n", socketPath, sizeof(GAMESESSION),
+           sizeof(MOVECHUNK), SESSION_MOVES_PER_CHUNK);
+    fflush(stdout);
+
+    double start = NowSeconds(), lastReport = start, lastSweep = start;
+    uint64_t lastMoves = 0;
+    struct epoll_event events[MAX_EVENTS];
+    while (!interrupted) {
+        int ready = epoll_wait(epollFd, events, MAX_EVENTS, 250);
+        if (ready < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < ready; i++) {
+            CONNECTION *connection = events[i].data.ptr;
+            if (!connection) {
+                AcceptConnections(listener);
+                continue;
+            }
+            if (connection->closed) continue;
+            if (events[i].events & EPOLLOUT) MarkPending(connection);
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) ReadConnection(connection);
+        }
+
+        double now = NowSeconds();
+        if (now - lastSweep >= 1.0) {
+            SweepClocks((uint64_t)(now * 1000.0));
+            lastSweep = now;
+        }
+        FlushPending();
+
+        if (now - lastReport >= reportSeconds) {
+            Report(now - lastReport, movesPlayed - lastMoves, "interval");
+            lastReport = now;
+            lastMoves = movesPlayed;
+        }
+    }
+
+    Report(NowSeconds() - start, movesPlayed, "total   ");
+    for (int slot = 0; slot < MAX_CONNECTIONS; slot++) {
+        if (!connections[slot]) continue;
+        if (!connections[slot]->closed) close(connections[slot]->fd);
+        free(connections[slot]->output);
+        free(connections[slot]->games);
+        free(connections[slot]);
+    }
+    FreeSessionPool(&pool);
+    close(epollFd);
+    close(listener);
+    unlink(socketPath);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "core/fen.h"
+#include "core/notation.h"
+#include "core/rules.h"
+
+typedef struct PerftCase {
+    const char *name;
+    const char *fen;
+    int depth;
+    uint64_t nodes;
+} PERFTCASE;
+
+// Reference positions and leaf counts from the Chess Programming Wiki perft results page
+static const PERFTCASE suite[] = {
+    { "startpos",  START_FEN, 6, 119060324ULL },
+    { "kiwipete",  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 5, 193690690ULL },
+    { "position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083ULL },
+    { "position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292ULL },
+    { "position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 5, 89941194ULL },
+    { "position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 5, 164075551ULL },
+};
+
+// Malformed or unplayable positions ParseFen has to turn down, most of them would crash the
+// generator and the last one could only arise by leaving a king in check
+static const struct {
+    const char *name;
+    const char *fen;
+} rejected[] = {
+    { "ep-no-pawn",    "4k3/8/8/4P3/8/8/8/4K3 w - d6 0 1" },
+    { "ep-wrong-rank", "4k3/8/8/3pP3/8/8/8/4K3 w - d3 0 1" },
+    { "castle-empty",  "4k3/8/8/8/8/8/8/6K1 w K - 0 1" },
+    { "castle-rook",   "4k3/8/8/8/8/8/8/4K3 w Q - 0 1" },
+    { "11-queens",     "QQQQQQQQ/QQQk4/8/8/8/8/8/4K3 w - - 0 1" },
+    { "two-kings",     "4k3/8/8/8/8/8/8/3KK3 w - - 0 1" },
+    { "no-king",       "8/8/8/8/8/8/8/4K3 w - - 0 1" },
+    { "pawn-rank8",    "3Pk3/8/8/8/8/8/8/4K3 w - - 0 1" },
+    { "side-in-check", "4k3/4Q3/8/8/8/8/8/4K3 w - - 0 1" },
+};
+
+static double NowSeconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static uint64_t Divide(POSITION *pos, int depth) {
+    uint64_t total = 0;
+    MOVELIST list;
+    GenerateLegalMoves(pos, &list);
+
+    for (int i = 0; i < list.count; i++) {
+        MOVE move = list.moves[i];
+        UNDO undo;
+        MakeMove(pos, move, &undo);
+        uint64_t nodes = Perft(pos, depth - 1);
+        UnmakeMove(pos, &undo);
+
+        char text[MOVE_TEXT_SIZE];
+        MoveToUci(move, text);
+        printf("%s: %llu\n", text, (unsigned long long)nodes);
+        total += nodes;
+    }
+    return total;
+}
+
+static void Report(uint64_t nodes, double seconds) {
+    printf("nodes %llu time %.3fs nps %.0f\n", (unsigned long long)nodes, seconds,
+           seconds > 0 ? nodes / seconds : 0.0);
+}
+
+static int RunSuite(void) {
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0;
+
+    for (size_t i = 0; i < sizeof(suite) / sizeof(suite[0]); i++) {
+        POSITION pos;
+        ParseFen(&pos, suite[i].fen);
+
+        double start = NowSeconds();
+        uint64_t nodes = Perft(&pos, suite[i].depth);
+        double seconds = NowSeconds() - start;
+
+        bool ok = nodes == suite[i].nodes;
+        failures += !ok;
+        totalNodes += nodes;
+        totalSeconds += seconds;
+
+        printf("%-10s depth %d  %12llu  %s  %8.3fs  %10.0f nps\n", suite[i].name, suite[i].depth,
+               (unsigned long long)nodes, ok ? "ok      " : "MISMATCH", seconds, seconds > 0 ? nodes / seconds : 0.0);
+        if (!ok) {
+            printf("           expected %llu\n", (unsigned long long)suite[i].nodes);
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(rejected) / sizeof(rejected[0]); i++) {
+        POSITION pos;
+        bool ok = !ParseFen(&pos, rejected[i].fen);
+        failures += !ok;
+        printf("%-13s bad FEN  %s\n", rejected[i].name, ok ? "rejected" : "ACCEPTED");
+    }
+
+    printf("total: ");
+    Report(totalNodes, totalSeconds);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static void PrintUsage(const char *program) {
+    fprintf(stderr,
+            "usage: %s [--divide] [FEN] DEPTH\n"
+            "       %s --suite\n",
+            program, program);
+}
+
+int main(int argc, char **argv) {
+    bool divide = false;
+    const char *fen = START_FEN;
+    int arg = 1;
+
+    if (argc == 2 && strcmp(argv[1], "--suite") == 0) {
+        return RunSuite();
+    }
+
+    if (arg < argc && (strcmp(argv[arg], "--divide") == 0 || strcmp(argv[arg], "-d") == 0)) {
+        divide = true;
+        arg++;
+    }
+
+    if (argc - arg == 2) {
+        fen = argv[arg++];
+    }
+
+    if (argc - arg != 1 || atoi(argv[arg]) < 1) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int depth = atoi(argv[arg]);
+    POSITION pos;
+    if (!ParseFen(&pos, fen)) {
+        fprintf(stderr, "invalid FEN: %s\n", fen);
+        return EXIT_FAILURE;
+    }
+
+    double start = NowSeconds();
+    uint64_t nodes = divide ? Divide(&pos, depth) : Perft(&pos, depth);
+    Report(nodes, NowSeconds() - start);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,283 @@
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "core/pgn.h"
+#include "engine/timer.h"
+
+#define BATCH_GAMES 64
+#define QUEUE_BATCHES 64
+#define MAX_THREADS 64
+
+// Every batch that can be in flight at once: queued plus one per worker
+#define BATCH_RING 256
+
+typedef struct GameSpan {
+    const char *text;
+    size_t length;
+} GAMESPAN;
+
+typedef struct Batch {
+    uint64_t sequence;
+    uint64_t firstGame;
+    size_t endOffset;
+    int count;
+    GAMESPAN games[BATCH_GAMES];
+} BATCH;
+
+typedef struct ReplayCounts {
+    uint64_t games;
+    uint64_t failed;
+    uint64_t plies;
+    uint64_t byStatus[PGN_WRONG_RESULT + 1];
+} REPLAYCOUNTS;
+
+static const char *statusNames[] = { "ok", "bad FEN", "illegal move", "wrong result" };
+
+/*
+    Bounded batch queue from the splitter to the pool, the splitter blocks when the pool
+    falls behind so only a window of the file is ever being worked on
+*/
+static BATCH *queue[QUEUE_BATCHES];
+static int queueHead = 0;
+static int queueCount = 0;
+static bool splitterDone = false;
+static pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queueNotEmpty = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t queueNotFull = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t outputLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Set by a worker when a batch is replayed, read by the splitter to release pages behind it
+static bool batchDone[BATCH_RING];
+static size_t batchEnd[BATCH_RING];
+
+static bool errorsOnly = false;
+
+static void PushBatch(BATCH *batch) {
+    pthread_mutex_lock(&queueLock);
+    while (queueCount == QUEUE_BATCHES) pthread_cond_wait(&queueNotFull, &queueLock);
+    queue[(queueHead + queueCount++) % QUEUE_BATCHES] = batch;
+    pthread_cond_signal(&queueNotEmpty);
+    pthread_mutex_unlock(&queueLock);
+}
+
+static BATCH *PopBatch(void) {
+    pthread_mutex_lock(&queueLock);
+    while (queueCount == 0 && !splitterDone) pthread_cond_wait(&queueNotEmpty, &queueLock);
+    BATCH *batch = NULL;
+    if (queueCount > 0) {
+        batch = queue[queueHead];
+        queueHead = (queueHead + 1) % QUEUE_BATCHES;
+        queueCount--;
+        pthread_cond_signal(&queueNotFull);
+    }
+    pthread_mutex_unlock(&queueLock);
+    return batch;
+}
+
+static void FinishSplitting(void) {
+    pthread_mutex_lock(&queueLock);
+    splitterDone = true;
+    pthread_cond_broadcast(&queueNotEmpty);
+    pthread_mutex_unlock(&queueLock);
+}
+
+// Status lines of a batch are written together, one lock per batch rather than per game
+static void ReplayBatch(BATCH *batch, REPLAYCOUNTS *counts) {
+    char output[BATCH_GAMES * 96];
+    size_t used = 0;
+
+    for (int i = 0; i < batch->count; i++) {
+        PGNREPLAY replay;
+        PGNSTATUS status = ReplayPgnGame(batch->games[i].text, batch->games[i].length, &replay);
+
+        counts->games++;
+        counts->plies += replay.plies;
+        counts->byStatus[status]++;
+        if (status != PGN_OK) counts->failed++;
+        if (errorsOnly && status == PGN_OK) continue;
+
+        int errorLength = (replay.errorLength > 16) ? 16 : (int)replay.errorLength;
+        used += snprintf(output + used, sizeof(output) - used, "game %llu: %s, %d plies%s%.*s\n",
+                         (unsigned long long)(batch->firstGame + i), statusNames[status], replay.plies,
+                         errorLength ? " at " : "", errorLength, replay.errorText ? replay.errorText : "");
+    }
+
+    if (used > 0) {
+        pthread_mutex_lock(&outputLock);
+        fwrite(output, 1, used, stdout);
+        pthread_mutex_unlock(&outputLock);
+    }
+}
+
+static void *WorkerMain(void *argument) {
+    REPLAYCOUNTS *counts = argument;
+    BATCH *batch;
+
+    while ((batch = PopBatch()) != NULL) {
+        ReplayBatch(batch, counts);
+        uint64_t slot = batch->sequence % BATCH_RING;
+        batchEnd[slot] = batch->endOffset;
+        __atomic_store_n(&batchDone[slot], true, __ATOMIC_RELEASE);
+        free(batch);
+    }
+    return NULL;
+}
+
+typedef struct Releaser {
+    const char *base;
+    size_t pageSize;
+    size_t released;
+    uint64_t nextSequence;
+} RELEASER;
+
+/*
+    Drop the pages of every batch replayed so far, in file order, so resident memory
+    stays at the in-flight window however large the file is
+*/
+static void ReleaseFinished(RELEASER *releaser) {
+    size_t end = releaser->released;
+    for (;;) {
+        uint64_t slot = releaser->nextSequence % BATCH_RING;
+        if (!__atomic_load_n(&batchDone[slot], __ATOMIC_ACQUIRE)) break;
+        batchDone[slot] = false;
+        end = batchEnd[slot];
+        releaser->nextSequence++;
+    }
+
+    end -= end % releaser->pageSize;
+    if (end > releaser->released) {
+        madvise((void *)(releaser->base + releaser->released), end - releaser->released, MADV_DONTNEED);
+        releaser->released = end;
+    }
+}
+
+// False if a batch could not be allocated, the games queued before that are still replayed
+static bool SplitGames(const char *base, size_t size) {
+    const char *cursor = base;
+    const char *end = base + size;
+    RELEASER releaser = { base, (size_t)sysconf(_SC_PAGESIZE), 0, 0 };
+    uint64_t sequence = 0;
+    uint64_t games = 0;
+    BATCH *batch = NULL;
+    const char *game;
+    size_t length;
+
+    while (SplitPgnGame(&cursor, end, &game, &length)) {
+        if (batch == NULL) {
+            // Keep the ring from lapping a batch that is still being replayed
+            while (sequence - releaser.nextSequence >= BATCH_RING - 1) {
+                ReleaseFinished(&releaser);
+                sched_yield();
+            }
+            batch = malloc(sizeof(BATCH));
+            if (batch == NULL) {
+                perror("malloc");
+                return false;
+            }
+            batch->sequence = sequence++;
+            batch->firstGame = games + 1;
+            batch->count = 0;
+        }
+
+        batch->games[batch->count].text = game;
+        batch->games[batch->count].length = length;
+        batch->count++;
+        games++;
+
+        if (batch->count == BATCH_GAMES) {
+            batch->endOffset = cursor - base;
+            PushBatch(batch);
+            batch = NULL;
+            ReleaseFinished(&releaser);
+        }
+    }
+    if (batch) {
+        batch->endOffset = size;
+        PushBatch(batch);
+    }
+    return true;
+}
+
+static void Usage(const char *program) {
+    fprintf(stderr, "usage: %s [--threads N] [--errors-only] FILE\n", program);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    int threadCount = 1;
+    bool badArguments = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--errors-only") == 0) errorsOnly = true;
+        else if (path == NULL) path = argv[i];
+        else badArguments = true;
+    }
+    if (badArguments || path == NULL || threadCount < 1 || threadCount > MAX_THREADS) {
+        Usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) {
+        perror(path);
+        return EXIT_FAILURE;
+    }
+    if (info.st_size == 0) {
+        printf("games 0\n");
+        return EXIT_SUCCESS;
+    }
+
+    const char *base = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+    madvise((void *)base, info.st_size, MADV_SEQUENTIAL);
+
+    double start = NowSeconds();
+    pthread_t threads[MAX_THREADS];
+    REPLAYCOUNTS counts[MAX_THREADS] = { 0 };
+    for (int i = 0; i < threadCount; i++) {
+        pthread_create(&threads[i], NULL, WorkerMain, &counts[i]);
+    }
+
+    bool split = SplitGames(base, info.st_size);
+    FinishSplitting();
+
+    REPLAYCOUNTS total = { 0 };
+    for (int i = 0; i < threadCount; i++) {
+        pthread_join(threads[i], NULL);
+        total.games += counts[i].games;
+        total.failed += counts[i].failed;
+        total.plies += counts[i].plies;
+        for (int status = 0; status <= PGN_WRONG_RESULT; status++) total.byStatus[status] += counts[i].byStatus[status];
+    }
+    double seconds = NowSeconds() - start;
+    munmap((void *)base, info.st_size);
+    if (!split) return EXIT_FAILURE;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    fprintf(stderr, "games %llu  failed %llu (bad FEN %llu, illegal move %llu, wrong result %llu)\n",
+            (unsigned long long)total.games, (unsigned long long)total.failed,
+            (unsigned long long)total.byStatus[PGN_BAD_FEN], (unsigned long long)total.byStatus[PGN_ILLEGAL_MOVE],
+            (unsigned long long)total.byStatus[PGN_WRONG_RESULT]);
+    fprintf(stderr, "time %.3fs  %.0f games/s  %.0f moves/s  %.1f MB/s  peak RSS %ld MB  threads %d\n", seconds,
+            total.games / seconds, total.plies / seconds, info.st_size / seconds / (1024 * 1024),
+            usage.ru_maxrss / 1024, threadCount);
+    return total.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,270 @@
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "core/fen.h"
+#include "core/notation.h"
+#include "engine/puzzledb.h"
+#include "engine/timer.h"
+
+#define MAX_THEMES 254
+#define CSV_FIELDS 10
+
+typedef struct PuzzleList {
+    PUZZLE *puzzles;
+    size_t count;
+    size_t capacity;
+} PUZZLELIST;
+
+static PUZZLETHEME themes[MAX_THEMES];
+static uint32_t themeCount = 0;
+
+static PUZZLE *AddPuzzle(PUZZLELIST *list) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 1 << 16;
+        list->puzzles = realloc(list->puzzles, list->capacity * sizeof(PUZZLE));
+        if (list->puzzles == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    PUZZLE *puzzle = &list->puzzles[list->count];
+    memset(puzzle, 0, sizeof(*puzzle));
+    memset(puzzle->themes, PUZZLE_NO_THEME, sizeof(puzzle->themes));
+    return puzzle;
+}
+
+static int ThemeId(const char *name, size_t length) {
+    if (length >= PUZZLE_THEME_NAME_SIZE) length = PUZZLE_THEME_NAME_SIZE - 1;
+    for (uint32_t i = 0; i < themeCount; i++) {
+        if (strncmp(themes[i].name, name, length) == 0 && themes[i].name[length] == '\0') return (int)i;
+    }
+    if (themeCount == MAX_THEMES) return -1;
+
+    memcpy(themes[themeCount].name, name, length);
+    themes[themeCount].name[length] = '\0';
+    return (int)themeCount++;
+}
+
+static int ComparePuzzles(const void *a, const void *b) {
+    const PUZZLE *x = a, *y = b;
+    if (x->rating != y->rating) return (int)x->rating - (int)y->rating;
+    return strncmp(x->id, y->id, sizeof(x->id));
+}
+
+// Next space-separated word of a field, NULL at its end
+static const char *NextWord(const char **cursor, const char *end, size_t *length) {
+    while (*cursor < end && **cursor == ' ') (*cursor)++;
+    const char *word = *cursor;
+    while (*cursor < end && **cursor != ' ') (*cursor)++;
+    *length = (size_t)(*cursor - word);
+    return *length ? word : NULL;
+}
+
+/*
+    Lichess CSV: PuzzleId,FEN,Moves,Rating,RatingDeviation,Popularity,NbPlays,Themes,GameUrl,OpeningTags
+    The first move is the opponent's, every move is checked against the rules here so the game never has to
+*/
+static bool ParsePuzzle(const char *line, const char *end, PUZZLE *puzzle) {
+    const char *fields[CSV_FIELDS + 1];
+    int fieldCount = 0;
+    fields[fieldCount++] = line;
+    for (const char *c = line; c < end && fieldCount <= CSV_FIELDS; c++) {
+        if (*c == ',') fields[fieldCount++] = c + 1;
+    }
+    if (fieldCount < 8) return false;
+    if (fieldCount <= CSV_FIELDS) fields[fieldCount] = end + 1;
+
+    size_t idLength = (size_t)(fields[1] - 1 - fields[0]);
+    memcpy(puzzle->id, fields[0], idLength < sizeof(puzzle->id) ? idLength : sizeof(puzzle->id));
+
+    char fen[FEN_BUFFER_SIZE];
+    size_t fenLength = (size_t)(fields[2] - 1 - fields[1]);
+    if (fenLength >= sizeof(fen)) return false;
+    memcpy(fen, fields[1], fenLength);
+    fen[fenLength] = '\0';
+
+    POSITION pos;
+    if (!ParseFen(&pos, fen)) return false;
+    PackPosition(&pos, &puzzle->position);
+
+    const char *cursor = fields[2], *movesEnd = fields[3] - 1, *word;
+    size_t length;
+    while ((word = NextWord(&cursor, movesEnd, &length)) != NULL) {
+        if (puzzle->moveCount == PUZZLE_MAX_MOVES) return false;
+        MOVE move = ParseMove(&pos, word, length);
+        if (move == MOVE_NONE) return false;
+
+        UNDO undo;
+        MakeMove(&pos, move, &undo);
+        puzzle->moves[puzzle->moveCount++] = move;
+    }
+    if (puzzle->moveCount < 2) return false;
+
+    long rating = strtol(fields[3], NULL, 10);
+    puzzle->rating = (uint16_t)(rating < 0 ? 0 : rating > 65535 ? 65535 : rating);
+
+    cursor = fields[7];
+    const char *themesEnd = fields[8] - 1;
+    int themeSlot = 0;
+    while (themeSlot < PUZZLE_MAX_THEMES && (word = NextWord(&cursor, themesEnd, &length)) != NULL) {
+        int id = ThemeId(word, length);
+        if (id < 0 || memchr(puzzle->themes, id, (size_t)themeSlot)) continue;
+        puzzle->themes[themeSlot++] = (uint8_t)id;
+    }
+    return true;
+}
+
+static int BuildDatabase(const char *csvPath, const char *dbPath) {
+    int fd = open(csvPath, O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0) {
+        perror(csvPath);
+        return EXIT_FAILURE;
+    }
+    const char *base = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror("mmap");
+        return EXIT_FAILURE;
+    }
+    madvise((void *)base, info.st_size, MADV_SEQUENTIAL);
+
+    double start = NowSeconds();
+    PUZZLELIST list = { 0 };
+    size_t rejected = 0;
+    const char *end = base + info.st_size;
+    for (const char *line = base; line < end;) {
+        const char *lineEnd = memchr(line, '\n', (size_t)(end - line));
+        if (lineEnd == NULL) lineEnd = end;
+        const char *contentEnd = (lineEnd > line && lineEnd[-1] == '\r') ? lineEnd - 1 : lineEnd;
+
+        if (contentEnd > line && strncmp(line, "PuzzleId,", 9) != 0) {
+            PUZZLE *puzzle = AddPuzzle(&list);
+            if (ParsePuzzle(line, contentEnd, puzzle)) list.count++;
+            else rejected++;
+        }
+        line = lineEnd + 1;
+    }
+    munmap((void *)base, info.st_size);
+
+    qsort(list.puzzles, list.count, sizeof(PUZZLE), ComparePuzzles);
+
+    // Walking the rating-sorted puzzles keeps every theme's list in rating order too
+    uint32_t postingCount = 0;
+    for (size_t i = 0; i < list.count; i++) {
+        for (int t = 0; t < PUZZLE_MAX_THEMES && list.puzzles[i].themes[t] != PUZZLE_NO_THEME; t++) {
+            themes[list.puzzles[i].themes[t]].count++;
+            postingCount++;
+        }
+    }
+    uint32_t *postings = malloc((postingCount ? postingCount : 1) * sizeof(uint32_t));
+    uint32_t *fill = calloc(themeCount ? themeCount : 1, sizeof(uint32_t));
+    if (postings == NULL || fill == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+    for (uint32_t t = 0, first = 0; t < themeCount; t++) {
+        themes[t].first = first;
+        first += themes[t].count;
+    }
+    for (size_t i = 0; i < list.count; i++) {
+        for (int t = 0; t < PUZZLE_MAX_THEMES && list.puzzles[i].themes[t] != PUZZLE_NO_THEME; t++) {
+            int theme = list.puzzles[i].themes[t];
+            postings[themes[theme].first + fill[theme]++] = (uint32_t)i;
+        }
+    }
+
+    PUZZLEHEADER header = { { 0 }, sizeof(PUZZLE), (uint32_t)list.count, themeCount, 0, 0 };
+    memcpy(header.magic, PUZZLE_MAGIC, 4);
+    header.themeOffset = sizeof(header) + list.count * sizeof(PUZZLE);
+    header.postingOffset = header.themeOffset + themeCount * sizeof(PUZZLETHEME);
+
+    FILE *out = fopen(dbPath, "wb");
+    if (out == NULL) {
+        perror(dbPath);
+        return EXIT_FAILURE;
+    }
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(list.puzzles, sizeof(PUZZLE), list.count, out);
+    fwrite(themes, sizeof(PUZZLETHEME), themeCount, out);
+    fwrite(postings, sizeof(uint32_t), postingCount, out);
+    bool ok = ferror(out) == 0;
+    if (fclose(out) != 0) ok = false;
+
+    printf("%zu puzzles, %zu rejected, %u themes, %.1f MB written to %s in %.2fs\n", list.count, rejected, themeCount,
+           (header.postingOffset + postingCount * sizeof(uint32_t)) / 1048576.0, dbPath, NowSeconds() - start);
+    free(list.puzzles);
+    free(postings);
+    free(fill);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int PickFromDatabase(const char *dbPath, int minRating, int maxRating, const char *themeName, int count) {
+    double start = NowSeconds();
+    PUZZLEDB db;
+    if (!OpenPuzzleDb(&db, dbPath)) {
+        fprintf(stderr, "%s: not a puzzle database\n", dbPath);
+        return EXIT_FAILURE;
+    }
+    double opened = NowSeconds() - start;
+
+    int theme = -1;
+    if (themeName && (theme = FindPuzzleTheme(&db, themeName)) < 0) {
+        fprintf(stderr, "no theme %s\n", themeName);
+        ClosePuzzleDb(&db);
+        return EXIT_FAILURE;
+    }
+
+    uint64_t rng = 0x9E3779B97F4A7C15ULL ^ (uint64_t)(NowSeconds() * 1e6);
+    start = NowSeconds();
+    for (int i = 0; i < count; i++) {
+        const PUZZLE *puzzle = PickPuzzle(&db, minRating, maxRating, theme, &rng);
+        if (puzzle == NULL) break;
+
+        POSITION pos;
+        char fen[FEN_BUFFER_SIZE], text[MOVE_TEXT_SIZE];
+        UnpackPosition(&puzzle->position, &pos);
+        WriteFen(&pos, fen, sizeof(fen));
+        printf("%.8s %4u  %s  ", puzzle->id, puzzle->rating, fen);
+        for (int m = 0; m < puzzle->moveCount; m++) {
+            MoveToUci(puzzle->moves[m], text);
+            printf("%s ", text);
+        }
+        for (int t = 0; t < PUZZLE_MAX_THEMES && puzzle->themes[t] != PUZZLE_NO_THEME; t++) {
+            printf("%s%s", t ? " " : " [", db.themes[puzzle->themes[t]].name);
+        }
+        printf("%s\n", puzzle->themes[0] != PUZZLE_NO_THEME ? "]" : "");
+    }
+    fprintf(stderr, "%u puzzles, %u themes, open %.3f ms, %d picks %.3f ms\n", db.puzzleCount, db.themeCount,
+            opened * 1e3, count, (NowSeconds() - start) * 1e3);
+    ClosePuzzleDb(&db);
+    return EXIT_SUCCESS;
+}
+
+static void Usage(const char *program) {
+    fprintf(stderr, "usage: %s --build CSV DB\n", program);
+    fprintf(stderr, "       %s --pick DB MIN MAX [--theme NAME] [--count N]\n", program);
+}
+
+int main(int argc, char **argv) {
+    if (argc == 4 && strcmp(argv[1], "--build") == 0) {
+        return BuildDatabase(argv[2], argv[3]);
+    }
+    if (argc >= 5 && strcmp(argv[1], "--pick") == 0) {
+        const char *theme = NULL;
+        int count = 1;
+        for (int i = 5; i + 1 < argc; i += 2) {
+            if (strcmp(argv[i], "--theme") == 0) theme = argv[i + 1];
+            else if (strcmp(argv[i], "--count") == 0) count = atoi(argv[i + 1]);
+        }
+        return PickFromDatabase(argv[2], atoi(argv[3]), atoi(argv[4]), theme, count);
+    }
+    Usage(argv[0]);
+    return EXIT_FAILURE;
+}
@@ -0,0 +1,363 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "core/rules.h"
+#include "engine/search.h"
+#include "engine/tablebase.h"
+#include "engine/timer.h"
+
+#define NO_LEVEL 255
+#define FLAG_INVALID 1
+#define FLAG_DRAW 2
+
+// Generated in this order so promotions in KPK find KQK and KRK already on disk
+static const char *defaultSets[] = { "KQK", "KRK", "KPK", "KBNK" };
+
+/*
+    Working state per position: the level (distance to mate in plies) it will resolve at,
+    how many moves inside the table are not yet known to lose for the mover, the longest
+    exit to a lost position outside the table, and whether some move holds a draw
+*/
+typedef struct Generator {
+    TBMATERIAL material;
+    uint8_t *values;
+    uint8_t *target;
+    uint8_t *remaining;
+    uint8_t *exitLoss;
+    uint8_t *flags;
+    int threadCount;
+    int level;
+    int maxLevel;
+    bool failed;
+} GENERATOR;
+
+typedef struct GeneratorTask {
+    GENERATOR *gen;
+    uint64_t first;
+    uint64_t last;
+    uint64_t resolved;
+} GENTASK;
+
+static bool BuildPosition(const TBMATERIAL *material, uint64_t index, POSITION *pos) {
+    int side;
+    int squares[2 + TB_MAX_EXTRA];
+    TablebaseDecode(material, index, &side, squares);
+
+    BITBOARD used = 0;
+    for (int i = 0; i < 2 + material->extraCount; i++) {
+        if (used & BIT(squares[i])) return false;
+        used |= BIT(squares[i]);
+    }
+
+    ClearPosition(&pos[0]);
+    PutPiece(pos, squares[0], COLOR_WHITE, KING);
+    PutPiece(pos, squares[1], COLOR_BLACK, KING);
+    for (int i = 0; i < material->extraCount; i++) {
+        if (material->extra[i] == PAWN && (RANK_OF(squares[2 + i]) == 0 || RANK_OF(squares[2 + i]) == 7)) return false;
+        PutPiece(pos, squares[2 + i], COLOR_WHITE, material->extra[i]);
+    }
+    pos->sideToMove = side;
+    pos->castlingRights = 0;
+    pos->enPassantSquare = NO_SQUARE;
+    pos->hash = ComputeHash(pos);
+
+    // The side that just moved cannot have left its king in check
+    return !IsInCheck(pos, !side);
+}
+
+// Index of a position inside the table being built, false if the move left it
+static bool IndexInTable(const TBMATERIAL *material, const POSITION *pos, uint64_t *index) {
+    char name[8];
+    int side;
+    int squares[2 + TB_MAX_EXTRA];
+    if (!DescribeTablebasePosition(pos, name, &side, squares) || strcmp(name, material->name) != 0) return false;
+    *index = TablebaseIndex(material, side, squares);
+    return true;
+}
+
+// Result for the side to move after a capture or promotion, from the tables already built
+static bool ProbeExit(const POSITION *pos, TBRESULT *result) {
+    if (ProbeTablebase(pos, result)) return true;
+
+    // King against king and a minor piece cannot be won by either side
+    BITBOARD heavy = pos->byType[PAWN] | pos->byType[ROOK] | pos->byType[QUEEN];
+    if (PopCount(Occupied(pos)) <= 3 && heavy == 0) {
+        result->wdl = 0;
+        result->dtm = 0;
+        return true;
+    }
+    return false;
+}
+
+static void SetTargetMin(uint8_t *target, uint8_t level) {
+    uint8_t current = __atomic_load_n(target, __ATOMIC_RELAXED);
+    while (level < current && !__atomic_compare_exchange_n(target, &current, level, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void RaiseMaxLevel(GENERATOR *gen, int level) {
+    int current = __atomic_load_n(&gen->maxLevel, __ATOMIC_RELAXED);
+    while (level > current && !__atomic_compare_exchange_n(&gen->maxLevel, &current, level, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// Counts moves that stay in the table and scores the ones that leave it
+static void *InitMain(void *arg) {
+    GENTASK *task = arg;
+    GENERATOR *gen = task->gen;
+    POSITION pos;
+    MOVELIST list;
+
+    for (uint64_t index = task->first; index < task->last; index++) {
+        gen->target[index] = NO_LEVEL;
+        gen->exitLoss[index] = 0;
+        gen->remaining[index] = 0;
+        gen->flags[index] = 0;
+        if (!BuildPosition(&gen->material, index, &pos)) {
+            gen->flags[index] = FLAG_INVALID;
+            continue;
+        }
+
+        GenerateLegalMoves(&pos, &list);
+        if (list.count == 0) {
+            if (IsInCheck(&pos, pos.sideToMove)) gen->target[index] = 0;
+            else gen->flags[index] = FLAG_DRAW;
+            continue;
+        }
+
+        int winLevel = NO_LEVEL;
+        for (int i = 0; i < list.count; i++) {
+            UNDO undo;
+            uint64_t child;
+            MakeMove(&pos, list.moves[i], &undo);
+
+            if (IndexInTable(&gen->material, &pos, &child)) {
+                gen->remaining[index]++;
+            } else {
+                TBRESULT exit;
+                if (!ProbeExit(&pos, &exit)) {
+                    __atomic_store_n(&gen->failed, true, __ATOMIC_RELAXED);
+                } else if (exit.wdl < 0) {
+                    if (exit.dtm + 1 < winLevel) winLevel = exit.dtm + 1;
+                } else if (exit.wdl == 0) {
+                    gen->flags[index] |= FLAG_DRAW;
+                } else if (exit.dtm > gen->exitLoss[index]) {
+                    gen->exitLoss[index] = (uint8_t)exit.dtm;
+                }
+            }
+            UnmakeMove(&pos, &undo);
+        }
+
+        if (winLevel != NO_LEVEL) {
+            gen->target[index] = (uint8_t)winLevel;
+        } else if (gen->remaining[index] == 0 && !(gen->flags[index] & FLAG_DRAW)) {
+            // Every move leaves the table into a lost position
+            gen->target[index] = (uint8_t)(gen->exitLoss[index] + 1);
+        }
+        if (gen->target[index] != NO_LEVEL) RaiseMaxLevel(gen, gen->target[index]);
+    }
+    return NULL;
+}
+
+/*
+    A position resolved at this level tells every position that can reach it with one move:
+    a loss here is a win one ply later there, a win here removes one hope of escape there
+*/
+static void Propagate(GENERATOR *gen, POSITION *pos) {
+    int level = gen->level;
+    int mover = !pos->sideToMove;
+    BITBOARD occupied = Occupied(pos);
+    BITBOARD pieces = pos->byColor[mover];
+
+    while (pieces) {
+        int to = PopLsb(&pieces);
+        PIECETYPE type = PIECE_TYPE(pos->board[to]);
+        BITBOARD origins;
+
+        switch (type) {
+        case PAWN:
+            origins = 0;
+            if (RANK_OF(to) >= 2 && !(occupied & BIT(to - 8))) {
+                origins |= BIT(to - 8);
+                if (RANK_OF(to) == 3 && !(occupied & BIT(to - 16))) origins |= BIT(to - 16);
+            }
+            break;
+        case KNIGHT: origins = knightAttacks[to]; break;
+        case BISHOP: origins = BishopAttacks(to, occupied); break;
+        case ROOK: origins = RookAttacks(to, occupied); break;
+        case QUEEN: origins = QueenAttacks(to, occupied); break;
+        default: origins = kingAttacks[to]; break;
+        }
+        origins &= ~occupied;
+
+        while (origins) {
+            int from = PopLsb(&origins);
+            RelocatePiece(pos, to, from);
+            pos->sideToMove = mover;
+
+            uint64_t parent;
+            if (!IsInCheck(pos, !mover) && IndexInTable(&gen->material, pos, &parent)) {
+                if (!(level & 1)) {
+                    SetTargetMin(&gen->target[parent], (uint8_t)(level + 1));
+                    RaiseMaxLevel(gen, level + 1);
+                } else if (__atomic_sub_fetch(&gen->remaining[parent], 1, __ATOMIC_RELAXED) == 0 &&
+                           !(gen->flags[parent] & FLAG_DRAW) &&
+                           __atomic_load_n(&gen->target[parent], __ATOMIC_RELAXED) == NO_LEVEL) {
+                    // No move left that avoids a lost position, the longest way down is taken
+                    int lossLevel = (gen->exitLoss[parent] > level ? gen->exitLoss[parent] : level) + 1;
+                    SetTargetMin(&gen->target[parent], (uint8_t)lossLevel);
+                    RaiseMaxLevel(gen, lossLevel);
+                }
+            }
+
+            pos->sideToMove = !mover;
+            RelocatePiece(pos, from, to);
+        }
+    }
+}
+
+static void *LevelMain(void *arg) {
+    GENTASK *task = arg;
+    GENERATOR *gen = task->gen;
+    POSITION pos;
+
+    for (uint64_t index = task->first; index < task->last; index++) {
+        if (gen->values[index] != TB_DRAW || __atomic_load_n(&gen->target[index], __ATOMIC_RELAXED) != gen->level) continue;
+
+        gen->values[index] = (uint8_t)(gen->level + 1);
+        task->resolved++;
+        BuildPosition(&gen->material, index, &pos);
+        Propagate(gen, &pos);
+    }
+    return NULL;
+}
+
+static void RunThreads(GENERATOR *gen, void *(*body)(void *), uint64_t *resolved) {
+    pthread_t threads[MAX_SEARCH_THREADS];
+    GENTASK tasks[MAX_SEARCH_THREADS];
+    uint64_t chunk = (gen->material.entryCount + gen->threadCount - 1) / gen->threadCount;
+
+    for (int i = 0; i < gen->threadCount; i++) {
+        uint64_t first = chunk * i;
+        uint64_t last = first + chunk;
+        if (first > gen->material.entryCount) first = gen->material.entryCount;
+        if (last > gen->material.entryCount) last = gen->material.entryCount;
+        tasks[i] = (GENTASK){ gen, first, last, 0 };
+        pthread_create(&threads[i], NULL, body, &tasks[i]);
+    }
+    for (int i = 0; i < gen->threadCount; i++) {
+        pthread_join(threads[i], NULL);
+        if (resolved) *resolved += tasks[i].resolved;
+    }
+}
+
+static void FreeGenerator(GENERATOR *gen) {
+    free(gen->values);
+    free(gen->target);
+    free(gen->remaining);
+    free(gen->exitLoss);
+    free(gen->flags);
+}
+
+static bool Generate(const char *name, const char *directory, int threadCount) {
+    GENERATOR gen = { 0 };
+    if (!ParseTablebaseMaterial(name, &gen.material)) {
+        fprintf(stderr, "%s: not a material set, use names like KQK or KBNK\n", name);
+        return false;
+    }
+
+    size_t count = gen.material.entryCount;
+    gen.values = calloc(count, 1);
+    gen.target = malloc(count);
+    gen.remaining = malloc(count);
+    gen.exitLoss = malloc(count);
+    gen.flags = malloc(count);
+    if (!gen.values || !gen.target || !gen.remaining || !gen.exitLoss || !gen.flags) {
+        fprintf(stderr, "%s: out of memory\n", name);
+        FreeGenerator(&gen);
+        return false;
+    }
+    gen.threadCount = threadCount;
+
+    double start = NowSeconds();
+    RunThreads(&gen, InitMain, NULL);
+    if (__atomic_load_n(&gen.failed, __ATOMIC_RELAXED)) {
+        fprintf(stderr, "%s: captures or promotions lead to tables not generated yet\n", name);
+        FreeGenerator(&gen);
+        return false;
+    }
+
+    uint64_t wins = 0, losses = 0;
+    int longest = 0;
+    for (gen.level = 0; gen.level <= gen.maxLevel && gen.level < NO_LEVEL - 1; gen.level++) {
+        uint64_t resolved = 0;
+        RunThreads(&gen, LevelMain, &resolved);
+        if (resolved) longest = gen.level;
+        if (gen.level & 1) wins += resolved;
+        else losses += resolved;
+    }
+    double generated = NowSeconds() - start;
+
+    // Illegal slots are never probed, repeating the previous value there lengthens the runs
+    uint64_t valid = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!(gen.flags[i] & FLAG_INVALID)) valid++;
+        else if (i > 0) gen.values[i] = gen.values[i - 1];
+    }
+
+    char path[1024];
+    size_t bytes = 0;
+    snprintf(path, sizeof(path), "%s/%s.tb", directory, name);
+    bool ok = WriteTablebase(path, &gen.material, gen.values, &bytes);
+    if (!ok) fprintf(stderr, "%s: cannot write %s\n", name, path);
+
+    printf("%-5s entries %9zu  legal %9lu  wins %9lu  losses %9lu  longest mate %3d plies  time %7.2fs  size %8zu bytes (%.2f bits/entry)\n",
+           name, count, (unsigned long)valid, (unsigned long)wins, (unsigned long)losses, longest, generated, bytes,
+           8.0 * bytes / count);
+
+    FreeGenerator(&gen);
+    return ok;
+}
+
+static void PrintUsage(const char *program) {
+    fprintf(stderr, "usage: %s [--threads N] [--dir DIR] [MATERIAL...]\n", program);
+    fprintf(stderr, "       defaults to KQK KRK KPK KBNK in %s\n", TB_DEFAULT_DIRECTORY);
+}
+
+int main(int argc, char **argv) {
+    int threadCount = AvailableCores();
+    const char *directory = TB_DEFAULT_DIRECTORY;
+    const char *sets[16];
+    int setCount = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) directory = argv[++i];
+        else if (argv[i][0] == '-' || setCount == 16) {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        } else sets[setCount++] = argv[i];
+    }
+    if (threadCount < 1) threadCount = 1;
+    if (threadCount > MAX_SEARCH_THREADS) threadCount = MAX_SEARCH_THREADS;
+    if (setCount == 0) {
+        for (size_t i = 0; i < sizeof(defaultSets) / sizeof(defaultSets[0]); i++) sets[setCount++] = defaultSets[i];
+    }
+
+    mkdir(directory, 0755);
+    InitBitboards();
+    for (int i = 0; i < setCount; i++) {
+        // Tables written so far answer the captures and promotions of the next one
+        LoadTablebases(directory);
+        if (!Generate(sets[i], directory, threadCount)) {
+            UnloadTablebases();
+            return EXIT_FAILURE;
+        }
+    }
+    UnloadTablebases();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,301 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "core/fen.h"
+#include "core/notation.h"
+#include "engine/search.h"
+#include "engine/tablebase.h"
+#include "engine/timer.h"
+#include "engine/tt.h"
+
+#define ENGINE_NAME "Chess"
+#define ENGINE_AUTHOR "torresmjm"
+
+// Kept back from every clock budget for process scheduling and the pipe to the GUI
+#define MOVE_OVERHEAD_MS 30
+
+// Moves the remaining clock is spread over when the GUI does not say
+#define DEFAULT_MOVES_TO_GO 30
+
+static POSITION position;
+static uint64_t gameKeys[MAX_GAME_PLY];
+static int gameKeyCount = 0;
+static int threadCount = 1;
+
+/*
+    One search at a time runs on its own thread so stdin is always read, stop is seen within
+    one limit check of the search, and go infinite holds its bestmove until stop arrives
+    go ponder searches without a clock and holds its bestmove until ponderhit turns it into
+    a normal search under the go command's time limits, or stop ends it
+*/
+static pthread_t searchThread;
+static bool searching = false;
+static bool stopSearch = false;
+static bool holdBestMove = false;
+static bool pondering = false;
+static pthread_mutex_t stopLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stopRaised = PTHREAD_COND_INITIALIZER;
+static SEARCHLIMITS limits;
+
+static void PrintIteration(const SEARCHRESULT *progress, void *context) {
+    (void)context;
+    char line[4096];
+    int length;
+
+    if (progress->score >= MATE_BOUND) {
+        length = snprintf(line, sizeof(line), "info depth %d score mate %d", progress->depth, (MATE_SCORE - progress->score + 1) / 2);
+    } else if (progress->score <= -MATE_BOUND) {
+        length = snprintf(line, sizeof(line), "info depth %d score mate -%d", progress->depth, (MATE_SCORE + progress->score) / 2);
+    } else {
+        length = snprintf(line, sizeof(line), "info depth %d score cp %d", progress->depth, progress->score);
+    }
+
+    double seconds = progress->seconds > 0 ? progress->seconds : 1e-6;
+    length += snprintf(line + length, sizeof(line) - length, " nodes %llu nps %llu time %d pv",
+                       (unsigned long long)progress->nodes, (unsigned long long)(progress->nodes / seconds),
+                       (int)(progress->seconds * 1000));
+    for (int i = 0; i < progress->pvLength && length < (int)sizeof(line) - MOVE_TEXT_SIZE - 2; i++) {
+        char text[MOVE_TEXT_SIZE];
+        MoveToUci(progress->pv[i], text);
+        length += snprintf(line + length, sizeof(line) - length, " %s", text);
+    }
+    printf("%s\n", line);
+}
+
+static void *SearchMain(void *argument) {
+    (void)argument;
+    SEARCHRESULT result;
+    SearchPosition(&position, gameKeys, gameKeyCount, &limits, &result);
+
+    // The protocol only allows bestmove for go infinite once the GUI has said stop, and for go ponder after ponderhit or stop
+    pthread_mutex_lock(&stopLock);
+    while ((holdBestMove || __atomic_load_n(&pondering, __ATOMIC_RELAXED)) && !stopSearch) {
+        pthread_cond_wait(&stopRaised, &stopLock);
+    }
+    pthread_mutex_unlock(&stopLock);
+
+    char best[MOVE_TEXT_SIZE] = "0000", ponder[MOVE_TEXT_SIZE];
+    if (result.bestMove != MOVE_NONE) MoveToUci(result.bestMove, best);
+    if (result.pvLength > 1 && result.pv[0] == result.bestMove) {
+        MoveToUci(result.pv[1], ponder);
+        printf("bestmove %s ponder %s\n", best, ponder);
+    } else {
+        printf("bestmove %s\n", best);
+    }
+    return NULL;
+}
+
+static void StopSearch(void) {
+    if (!searching) return;
+
+    pthread_mutex_lock(&stopLock);
+    __atomic_store_n(&stopSearch, true, __ATOMIC_RELAXED);
+    pthread_cond_signal(&stopRaised);
+    pthread_mutex_unlock(&stopLock);
+
+    pthread_join(searchThread, NULL);
+    searching = false;
+}
+
+// The search goes on as a normal one, its bestmove is sent once the time limits run out
+static void PonderHit(void) {
+    pthread_mutex_lock(&stopLock);
+    __atomic_store_n(&pondering, false, __ATOMIC_RELAXED);
+    pthread_cond_signal(&stopRaised);
+    pthread_mutex_unlock(&stopLock);
+}
+
+// Token after the given one in a command, NULL if it is missing
+static const char *ValueAfter(char **tokens, int count, const char *name) {
+    for (int i = 0; i + 1 < count; i++) {
+        if (strcmp(tokens[i], name) == 0) return tokens[i + 1];
+    }
+    return NULL;
+}
+
+static void SetPosition(char **tokens, int count) {
+    int next = 1;
+    POSITION parsed;
+
+    if (next < count && strcmp(tokens[next], "startpos") == 0) {
+        SetStartingPosition(&parsed);
+        next++;
+    } else if (next < count && strcmp(tokens[next], "fen") == 0) {
+        char fen[FEN_BUFFER_SIZE * 2] = "";
+        size_t length = 0;
+        for (next++; next < count && strcmp(tokens[next], "moves") != 0; next++) {
+            length += snprintf(fen + length, length < sizeof(fen) ? sizeof(fen) - length : 0, "%s%s", length ? " " : "", tokens[next]);
+        }
+        if (length >= sizeof(fen) || !ParseFen(&parsed, fen)) {
+            printf("info string invalid fen\n");
+            return;
+        }
+    } else {
+        return;
+    }
+
+    position = parsed;
+    gameKeyCount = 0;
+    if (next < count && strcmp(tokens[next], "moves") == 0) next++;
+
+    for (; next < count; next++) {
+        MOVE move = ParseMove(&position, tokens[next], strlen(tokens[next]));
+        if (move == MOVE_NONE) {
+            printf("info string illegal move %s\n", tokens[next]);
+            return;
+        }
+
+        // Only the latest positions can repeat, the oldest keys make room when the game is very long
+        if (gameKeyCount == MAX_GAME_PLY) {
+            memmove(gameKeys, gameKeys + 1, (MAX_GAME_PLY - 1) * sizeof(uint64_t));
+            gameKeyCount--;
+        }
+        gameKeys[gameKeyCount++] = position.hash;
+
+        UNDO undo;
+        MakeMove(&position, move, &undo);
+    }
+}
+
+// A slice of the remaining clock, never so much that the increment cannot cover what is left
+static int ClockBudget(int timeMs, int incrementMs, int movesToGo) {
+    if (movesToGo <= 0) movesToGo = DEFAULT_MOVES_TO_GO;
+    int budget = timeMs / movesToGo + incrementMs * 3 / 4;
+    int ceiling = timeMs - MOVE_OVERHEAD_MS;
+    if (budget > ceiling) budget = ceiling;
+    return budget < 1 ? 1 : budget;
+}
+
+static void Go(char **tokens, int count) {
+    const char *value;
+    limits = (SEARCHLIMITS){ .threads = threadCount, .stop = &stopSearch, .ponder = &pondering, .onIteration = PrintIteration };
+    holdBestMove = false;
+    pondering = false;
+
+    if ((value = ValueAfter(tokens, count, "depth"))) limits.depth = atoi(value);
+    if ((value = ValueAfter(tokens, count, "nodes"))) limits.nodes = strtoull(value, NULL, 10);
+    if ((value = ValueAfter(tokens, count, "movetime"))) limits.moveTimeMs = atoi(value);
+
+    const char *clock = ValueAfter(tokens, count, position.sideToMove == COLOR_WHITE ? "wtime" : "btime");
+    const char *increment = ValueAfter(tokens, count, position.sideToMove == COLOR_WHITE ? "winc" : "binc");
+    const char *movesToGo = ValueAfter(tokens, count, "movestogo");
+    if (clock && limits.moveTimeMs == 0) {
+        limits.moveTimeMs = ClockBudget(atoi(clock), increment ? atoi(increment) : 0, movesToGo ? atoi(movesToGo) : 0);
+    }
+
+    for (int i = 1; i < count; i++) {
+        if (strcmp(tokens[i], "infinite") == 0) holdBestMove = true;
+        if (strcmp(tokens[i], "ponder") == 0) pondering = true;
+    }
+
+    stopSearch = false;
+    searching = pthread_create(&searchThread, NULL, SearchMain, NULL) == 0;
+}
+
+static void SetOption(char **tokens, int count) {
+    // setoption name <id> [value <x>], ids may contain spaces
+    char name[64] = "", value[1024] = "";
+    char *target = NULL;
+    for (int i = 1; i < count; i++) {
+        if (strcmp(tokens[i], "name") == 0) target = name;
+        else if (strcmp(tokens[i], "value") == 0) target = value;
+        else if (target) {
+            size_t length = strlen(target), size = (target == name) ? sizeof(name) : sizeof(value);
+            snprintf(target + length, size - length, "%s%s", length ? " " : "", tokens[i]);
+        }
+    }
+
+    if (strcmp(name, "Hash") == 0) {
+        ResizeTable(atoi(value));
+    } else if (strcmp(name, "Threads") == 0) {
+        threadCount = atoi(value);
+        if (threadCount < 1) threadCount = 1;
+        if (threadCount > MAX_SEARCH_THREADS) threadCount = MAX_SEARCH_THREADS;
+    } else if (strcmp(name, "Clear Hash") == 0) {
+        ClearTable();
+    } else if (strcmp(name, "TablebasePath") == 0) {
+        if (strcmp(value, "<empty>") == 0 || value[0] == '\0') UnloadTablebases();
+        else printf("info string %d tablebases loaded\n", LoadTablebases(value));
+    } else {
+        printf("info string unknown option %s\n", name);
+    }
+}
+
+static int SplitTokens(char *line, char **tokens, int capacity) {
+    int count = 0;
+    char *save = NULL;
+    for (char *token = strtok_r(line, " \t\r\n", &save); token && count < capacity; token = strtok_r(NULL, " \t\r\n", &save)) {
+        tokens[count++] = token;
+    }
+    return count;
+}
+
+int main(void) {
+    // Line buffered even into a pipe, every reply has to reach the GUI at once
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    // The table maps fresh pages, memory is only touched as the search writes to it
+    ResizeTable(TT_DEFAULT_MB);
+    SetStartingPosition(&position);
+
+    // A position command carries every move of the game, one token each
+    enum { MAX_TOKENS = 2 * MAX_GAME_PLY + 64 };
+    static char *tokens[MAX_TOKENS];
+    char *line = NULL;
+    size_t capacity = 0;
+
+    while (getline(&line, &capacity, stdin) != -1) {
+        int count = SplitTokens(line, tokens, MAX_TOKENS);
+        if (count == 0) continue;
+        const char *command = tokens[0];
+
+        if (strcmp(command, "uci") == 0) {
+            printf("id name %s\n", ENGINE_NAME);
+            printf("id author %s\n", ENGINE_AUTHOR);
+            printf("option name Hash type spin default %d min 1 max 65536\n", TT_DEFAULT_MB);
+            printf("option name Threads type spin default 1 min 1 max %d\n", MAX_SEARCH_THREADS);
+            printf("option name Clear Hash type button\n");
+            printf("option name TablebasePath type string default <empty>\n");
+            printf("uciok\n");
+        } else if (strcmp(command, "isready") == 0) {
+            printf("readyok\n");
+        } else if (strcmp(command, "ucinewgame") == 0) {
+            StopSearch();
+            ClearTable();
+        } else if (strcmp(command, "position") == 0) {
+            StopSearch();
+            SetPosition(tokens, count);
+        } else if (strcmp(command, "go") == 0) {
+            StopSearch();
+            Go(tokens, count);
+        } else if (strcmp(command, "stop") == 0) {
+            StopSearch();
+        } else if (strcmp(command, "ponderhit") == 0) {
+            if (searching) PonderHit();
+        } else if (strcmp(command, "setoption") == 0) {
+            StopSearch();
+            SetOption(tokens, count);
+        } else if (strcmp(command, "d") == 0) {
+            char fen[FEN_BUFFER_SIZE];
+            WriteFen(&position, fen, sizeof(fen));
+            printf("info string %s\n", fen);
+        } else if (strcmp(command, "quit") == 0) {
+            StopSearch();
+            break;
+        }
+    }
+
+    // Input piped from a file ends without quit, the last search still gets to finish
+    if (searching && !holdBestMove && !pondering) {
+        pthread_join(searchThread, NULL);
+        searching = false;
+    }
+    StopSearch();
+    free(line);
+    UnloadTablebases();
+    FreeTable();
+    return EXIT_SUCCESS;
+}
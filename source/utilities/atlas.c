@@ -0,0 +1,61 @@
+#include "atlas.h"
+#include "rlgl.h"
+
+void InitializeAtlas(ATLAS *atlas, Image image, int cellSize) {
+    atlas -> texture = LoadTextureFromImage(image);
+    atlas -> cellSize = cellSize;
+    ResetAtlasStats(atlas);
+}
+
+void UnloadAtlas(ATLAS *atlas) {
+    if (IsAtlasLoaded(atlas)) UnloadTexture(atlas -> texture);
+    atlas -> texture = (Texture2D){ 0 };
+}
+
+bool IsAtlasLoaded(const ATLAS *atlas) {
+    return atlas -> texture.id != 0;
+}
+
+Rectangle AtlasCell(const ATLAS *atlas, int column, int row) {
+    return (Rectangle){ column * atlas -> cellSize, row * atlas -> cellSize, atlas -> cellSize, atlas -> cellSize };
+}
+
+void BeginAtlasBatch(ATLAS *atlas, int quads) {
+    rlCheckRenderBatchLimit(4 * quads);
+    rlSetTexture(atlas -> texture.id);
+    rlBegin(RL_QUADS);
+    atlas -> stats.batches++;
+}
+
+// Same vertex order as DrawTexturePro: top-left, bottom-left, bottom-right, top-right
+void DrawAtlasSprite(ATLAS *atlas, Rectangle source, Rectangle dest, Color tint) {
+    float width = (float)atlas -> texture.width;
+    float height = (float)atlas -> texture.height;
+    float left = source.x / width, right = (source.x + source.width) / width;
+    float top = source.y / height, bottom = (source.y + source.height) / height;
+
+    rlColor4ub(tint.r, tint.g, tint.b, tint.a);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+
+    rlTexCoord2f(left, top);
+    rlVertex2f(dest.x, dest.y);
+    rlTexCoord2f(left, bottom);
+    rlVertex2f(dest.x, dest.y + dest.height);
+    rlTexCoord2f(right, bottom);
+    rlVertex2f(dest.x + dest.width, dest.y + dest.height);
+    rlTexCoord2f(right, top);
+    rlVertex2f(dest.x + dest.width, dest.y);
+
+    atlas -> stats.quads++;
+    atlas -> stats.vertices += 4;
+}
+
+void EndAtlasBatch(ATLAS *atlas) {
+    (void)atlas;
+    rlEnd();
+    rlSetTexture(0);
+}
+
+void ResetAtlasStats(ATLAS *atlas) {
+    atlas -> stats = (SPRITESTATS){ 0 };
+}
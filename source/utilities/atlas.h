@@ -0,0 +1,40 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "raylib.h"
+
+/*
+    Counts for the quads pushed through an atlas since the last reset
+    batches is how many times the atlas texture was bound, raylib merges consecutive
+    batches on the same texture into one draw call
+*/
+typedef struct SpriteStats {
+    int quads;
+    int vertices;
+    int batches;
+} SPRITESTATS;
+
+/*
+    One texture cut into square cells, drawn as textured quads straight into raylib's
+    render batch so a whole board goes to the GPU as a single draw call
+*/
+typedef struct SpriteAtlas {
+    Texture2D texture;
+    int cellSize;
+    SPRITESTATS stats;
+} ATLAS;
+
+void InitializeAtlas(ATLAS *atlas, Image image, int cellSize);
+void UnloadAtlas(ATLAS *atlas);
+bool IsAtlasLoaded(const ATLAS *atlas);
+
+Rectangle AtlasCell(const ATLAS *atlas, int column, int row);
+
+// quads is an upper bound for the batch, the render batch is flushed first if it would not fit
+void BeginAtlasBatch(ATLAS *atlas, int quads);
+void DrawAtlasSprite(ATLAS *atlas, Rectangle source, Rectangle dest, Color tint);
+void EndAtlasBatch(ATLAS *atlas);
+
+void ResetAtlasStats(ATLAS *atlas);
+
+#endif
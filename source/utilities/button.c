@@ -1,10 +1,13 @@
 #include "button.h"
+#include <math.h>
+#include "loader.h"
 
+// The texture arrives from the asset loader, until then the button has no size and is not drawn
 void InitializeButton(BUTTON *button, const char *texturePath, Vector2 position){
-    button -> texture = LoadTexture(texturePath);
+    RequestTexture(texturePath, &button -> texture);
     button -> position = position;
     button -> scale = 4.0f;
-    button -> hitbox = (Rectangle){position.x, position.y, button -> texture.width * button -> scale, button -> texture.height * button -> scale};
+    button -> hitbox = (Rectangle){position.x, position.y, 0, 0};
 }
 
 bool IsButtonPressed(BUTTON *button) {
@@ -18,10 +21,12 @@ bool IsButtonHover(BUTTON *button) {
     return CheckCollisionPointRec(GetMousePosition(), button -> hitbox);
 }
 
-void UpdateButton(BUTTON *button){
+bool UpdateButton(BUTTON *button){
     float targetScale = IsButtonHover(button) ? 4.1f : 4.0f;
 
-    button -> scale += (targetScale - button -> scale) * 0.2f;
+    // Snapped once within a fraction of a pixel so an idle button stops asking for frames
+    if (fabsf(targetScale - button -> scale) < 0.001f) button -> scale = targetScale;
+    else button -> scale += (targetScale - button -> scale) * 0.2f;
 
     button -> hitbox.width  = button -> texture.width  * button -> scale;
     button -> hitbox.height = button -> texture.height * button -> scale;
@@ -30,13 +35,22 @@ void UpdateButton(BUTTON *button){
 
     button -> position.x += (targetOffset - (button -> position.x - button -> hitbox.x)) * 0.2f;
     button -> position.y += (targetOffset - (button -> position.y - button -> hitbox.y)) * 0.2f;
+
+    bool settled = fabsf(targetOffset - (button -> position.x - button -> hitbox.x)) < 0.05f &&
+                   fabsf(targetOffset - (button -> position.y - button -> hitbox.y)) < 0.05f;
+    if (settled) {
+        button -> position.x = button -> hitbox.x + targetOffset;
+        button -> position.y = button -> hitbox.y + targetOffset;
+    }
+    return !settled || button -> scale != targetScale;
 }
 
 void RenderButton(BUTTON *button) {
+    if (button -> texture.id == 0) return;
     DrawTextureEx(button -> texture, button -> position, 0.0f, button -> scale, WHITE);
 }
 
 void UnloadButton(BUTTON *button){
-    UnloadTexture(button -> texture);
+    if (button -> texture.id != 0) UnloadTexture(button -> texture);
 }
 
@@ -13,7 +13,8 @@ typedef struct Button {
 void InitializeButton(BUTTON *button, const char *texturePath, Vector2 position);
 bool IsButtonPressed(BUTTON *button);
 bool IsButtonHover(BUTTON *button);
-void UpdateButton(BUTTON *button);
+// True while the hover or press easing is still moving
+bool UpdateButton(BUTTON *button);
 void RenderButton(BUTTON *button);
 void UnloadButton(BUTTON *button);
 
@@ -0,0 +1,143 @@
+#define _POSIX_C_SOURCE 200809L
+#include "loader.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "engine/archive.h"
+
+typedef struct TextureRequest {
+    char path[ARCHIVE_NAME_SIZE];
+    Texture2D *texture;
+    Image image;
+} TEXTUREREQUEST;
+
+/*
+    Requests are taken in order: the loader decodes up to decodedCount, the main thread
+    uploads up to uploadedCount, both behind the lock only for the counters
+*/
+static TEXTUREREQUEST requests[MAX_TEXTURE_REQUESTS];
+static int requestCount = 0;
+static int decodedCount = 0;
+static int uploadedCount = 0;
+static bool stopping = false;
+static bool running = false;
+static pthread_t thread;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t requestPosted = PTHREAD_COND_INITIALIZER;
+
+static ARCHIVE archive;
+static bool archiveOpen = false;
+
+static unsigned char *ReadLooseFile(const char *path, int *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+
+    unsigned char *data = NULL;
+    long length = (fseek(file, 0, SEEK_END) == 0) ? ftell(file) : -1;
+    if (length > 0 && fseek(file, 0, SEEK_SET) == 0 && (data = malloc(length)) != NULL &&
+        fread(data, 1, length, file) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *size = (int)length;
+    return data;
+}
+
+// The archive's bytes are decoded in place, a missing entry falls back to the loose file
+static Image DecodeImage(const char *path) {
+    const char *extension = strrchr(path, '.');
+    size_t size = 0;
+    const unsigned char *packed = archiveOpen ? FindArchiveFile(&archive, path, &size) : NULL;
+    if (packed && extension) return LoadImageFromMemory(extension, packed, (int)size);
+
+    int looseSize = 0;
+    unsigned char *loose = ReadLooseFile(path, &looseSize);
+    Image image = { 0 };
+    if (loose && extension) image = LoadImageFromMemory(extension, loose, looseSize);
+    free(loose);
+    if (image.data == NULL) fprintf(stderr, "%s: could not load\n", path);
+    return image;
+}
+
+static void *LoaderMain(void *argument) {
+    (void)argument;
+    pthread_mutex_lock(&lock);
+    for (;;) {
+        while (decodedCount == requestCount && !stopping) pthread_cond_wait(&requestPosted, &lock);
+        if (stopping) break;
+
+        TEXTUREREQUEST *request = &requests[decodedCount];
+        pthread_mutex_unlock(&lock);
+        Image image = DecodeImage(request->path);
+        pthread_mutex_lock(&lock);
+        request->image = image;
+        decodedCount++;
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+bool StartAssetLoader(const char *archivePath) {
+    archiveOpen = archivePath && OpenArchive(&archive, archivePath);
+    running = pthread_create(&thread, NULL, LoaderMain, NULL) == 0;
+    return archiveOpen;
+}
+
+void StopAssetLoader() {
+    if (running) {
+        pthread_mutex_lock(&lock);
+        stopping = true;
+        pthread_cond_signal(&requestPosted);
+        pthread_mutex_unlock(&lock);
+        pthread_join(thread, NULL);
+        running = false;
+    }
+
+    // Decoded but never uploaded
+    for (int i = uploadedCount; i < decodedCount; i++) UnloadImage(requests[i].image);
+    uploadedCount = decodedCount = requestCount = 0;
+    if (archiveOpen) CloseArchive(&archive);
+    archiveOpen = false;
+}
+
+void RequestTexture(const char *path, Texture2D *texture) {
+    *texture = (Texture2D){ 0 };
+    if (strlen(path) >= ARCHIVE_NAME_SIZE || requestCount == MAX_TEXTURE_REQUESTS) {
+        fprintf(stderr, "%s: cannot queue\n", path);
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    TEXTUREREQUEST *request = &requests[requestCount];
+    strcpy(request->path, path);
+    request->texture = texture;
+    request->image = (Image){ 0 };
+    requestCount++;
+    pthread_cond_signal(&requestPosted);
+    pthread_mutex_unlock(&lock);
+}
+
+int UploadLoadedTextures() {
+    pthread_mutex_lock(&lock);
+    int decoded = decodedCount;
+    pthread_mutex_unlock(&lock);
+
+    int uploaded = 0;
+    for (; uploadedCount < decoded; uploadedCount++) {
+        TEXTUREREQUEST *request = &requests[uploadedCount];
+        if (request->image.data == NULL) continue;
+        *request->texture = LoadTextureFromImage(request->image);
+        UnloadImage(request->image);
+        uploaded++;
+    }
+    return uploaded;
+}
+
+bool AreTexturesPending() {
+    pthread_mutex_lock(&lock);
+    bool pending = uploadedCount < requestCount;
+    pthread_mutex_unlock(&lock);
+    return pending;
+}
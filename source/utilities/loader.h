@@ -0,0 +1,24 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "raylib.h"
+
+// Written by make assets.pak, without it the same names are read as loose files
+#define ASSET_ARCHIVE_PATH "assets.pak"
+#define MAX_TEXTURE_REQUESTS 64
+
+/*
+    Images are decoded on a background thread from the memory-mapped archive and uploaded to
+    the GPU by the main thread, a requested texture stays empty (id 0) until then
+    A NULL archive path reads every asset as a loose file, returns whether the archive is in use
+*/
+bool StartAssetLoader(const char *archivePath);
+void StopAssetLoader();
+
+void RequestTexture(const char *path, Texture2D *texture);
+
+// Main thread, once per frame: uploads what has been decoded, returns how many textures
+int UploadLoadedTextures();
+bool AreTexturesPending();
+
+#endif